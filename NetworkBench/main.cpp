@@ -0,0 +1,269 @@
+﻿// 本机回环发送基准：比较原有的单块在途发送方式与水位流水线、套接字配置和零拷贝发送，
+// 并测量不同块大小和文件大小下的吞吐量、每GB的CPU时间和接收端读取间隔的百分位数。
+// 接收端为SignalReceiver的FileReceiver；命令行参数给出目录时接收的文件写入该目录（含预分配），否则丢弃
+#include "../SignalTransmitter/networkmodel.h"
+#include "../SignalReceiver/filereceiver.h"
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <cstdio>
+#include <functional>
+#ifdef Q_OS_WIN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+    constexpr qint64 kFileSize{ 256 * 1024 * 1024 };
+    constexpr qint64 kMatrixFileSizes[]{ 4 * 1024 * 1024, 64 * 1024 * 1024, 256 * 1024 * 1024 };
+    constexpr qint64 kMatrixChunkSizes[]{ 16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024, 0 };   // 0为自动调整
+    constexpr qint64 kLegacyChunkSize{ 64 * 1024 };
+    constexpr int kRounds{ 3 };
+    constexpr int kTimeout{ 60000 };
+    quint16 next_port{ 46000 };
+    QString output_dir;
+
+    struct Result {
+        double megabytes_per_second{ 0.0 };
+        double cpu_seconds_per_gb{ 0.0 };
+        double gap_p50_us{ 0.0 };
+        double gap_p99_us{ 0.0 };
+        double gap_p999_us{ 0.0 };
+    };
+
+    // 进程CPU时间（用户态 + 内核态，秒），发送和接收在同一进程中
+    double ProcessCpuSeconds()
+    {
+#ifdef Q_OS_WIN
+        FILETIME creation, exit, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+            return 0.0;
+        }
+        const auto to_seconds = [](const FILETIME &time) {
+            return ((static_cast<quint64>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 1e7;
+        };
+        return to_seconds(kernel) + to_seconds(user);
+#else
+        struct rusage usage {};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#endif
+    }
+
+    QString TestFilePath(qint64 size)
+    {
+        return QDir::temp().filePath(QString("SignalTransmitter_bench_%1M.bin").arg(size / 1048576));
+    }
+
+    // 生成测试文件，内容为伪随机字节
+    bool CreateTestFile(const QString &path, qint64 size)
+    {
+        QFile file(path);
+        if (file.exists() && file.size() == size) {
+            return true;
+        }
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        QByteArray block(1024 * 1024, Qt::Uninitialized);
+        quint32 seed{ 12345 };
+        for (qint64 written = 0; written < size; written += block.size()) {
+            for (auto &byte : block) {
+                seed = seed * 1664525u + 1013904223u;
+                byte = static_cast<char>(seed >> 24);
+            }
+            file.write(block);
+        }
+        return true;
+    }
+
+    // 接收线程：由FileReceiver接收完整文件
+    QThread *StartReceiver(quint16 port, FileReceiver &receiver, bool &received)
+    {
+        return QThread::create([port, &receiver, &received]() {
+            receiver.set_output_dir(output_dir);
+            receiver.set_timeout(kTimeout);
+            received = receiver.Receive("127.0.0.1", port);
+            if (!received) {
+                std::fprintf(stderr, "receiver: %s\n", qPrintable(receiver.get_error()));
+            }
+        });
+    }
+
+    // 原有发送方式：每次bytesWritten后才写入下一个64 KB块
+    bool RunLegacy(const QString &path, quint16 port)
+    {
+        QTcpServer server;
+        if (!server.listen(QHostAddress::LocalHost, port)) {
+            return false;
+        }
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+        QEventLoop loop;
+        QTcpSocket *socket{ nullptr };
+        QByteArray header;
+        QDataStream stream(&header, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream << QFileInfo(path).fileName() << file.size();
+        const qint64 header_size = header.size();
+        qint64 bytes_written{ 0 };
+        QObject::connect(&server, &QTcpServer::newConnection, [&]() {
+            socket = server.nextPendingConnection();
+            QObject::connect(socket, &QTcpSocket::bytesWritten, [&](qint64 bytes) {
+                bytes_written += bytes;
+                if (bytes_written >= header_size + file.size()) {
+                    loop.quit();
+                } else if (bytes_written > header_size && !file.atEnd()) {
+                    socket->write(file.read(kLegacyChunkSize));
+                }
+            });
+            QObject::connect(socket, &QTcpSocket::disconnected, &loop, &QEventLoop::quit);
+            socket->write(header);
+            socket->write(file.read(kLegacyChunkSize));
+        });
+        QTimer::singleShot(kTimeout, &loop, &QEventLoop::quit);
+        loop.exec();
+        return true;
+    }
+
+    // 使用NetworkModel发送
+    bool RunModel(const QString &path, quint16 port, NetworkModel::SocketProfile_t profile, bool zero_copy, qint64 chunk_size = 0)
+    {
+        NetworkModel model(nullptr);
+        model.set_socket_profile(profile);
+        model.set_zero_copy_enabled(zero_copy);
+        model.set_fixed_chunk_size(chunk_size);
+        if (model.StartListening(QString::number(port)) != NetworkModel::kNoError) {
+            return false;
+        }
+        QEventLoop loop;
+        QObject::connect(&model, &NetworkModel::connectionEstablished, [&]() {
+            model.StartFileTransfer(path);
+        });
+        QObject::connect(&model, &NetworkModel::transferCompleted, &loop, &QEventLoop::quit);
+        QObject::connect(&model, &NetworkModel::transferError, [&](const QString &error_message) {
+            std::fprintf(stderr, "transfer error: %s\n", qPrintable(error_message));
+            loop.quit();
+        });
+        QTimer::singleShot(kTimeout, &loop, &QEventLoop::quit);
+        loop.exec();
+        return true;
+    }
+
+    // 多轮中取吞吐量最高的一轮，报告该轮的各项指标
+    Result RunScenario(const QString &path, const std::function<bool(quint16)> &send)
+    {
+        const qint64 file_size = QFileInfo(path).size();
+        Result best;
+        for (int round = 0; round < kRounds; ++round) {
+            const quint16 port = next_port++;
+            FileReceiver receiver;
+            bool received{ false };
+            QThread *receiver_thread{ nullptr };
+            // 服务器开始监听后再启动接收线程
+            QTimer start_timer;
+            start_timer.setSingleShot(true);
+            QObject::connect(&start_timer, &QTimer::timeout, [&]() {
+                receiver_thread = StartReceiver(port, receiver, received);
+                receiver_thread->start();
+            });
+            start_timer.start(0);
+            const double cpu_start = ProcessCpuSeconds();
+            if (!send(port)) {
+                std::fprintf(stderr, "listen failed on port %u\n", port);
+                return best;
+            }
+            if (receiver_thread) {
+                receiver_thread->wait();
+                delete receiver_thread;
+            }
+            const double cpu_seconds = ProcessCpuSeconds() - cpu_start;
+            const auto &stats = receiver.get_stats();
+            if (!received || stats.bytes_received != file_size || stats.MegabytesPerSecond() <= best.megabytes_per_second) {
+                continue;
+            }
+            best.megabytes_per_second = stats.MegabytesPerSecond();
+            best.cpu_seconds_per_gb = file_size > 0 ? cpu_seconds / (file_size / 1073741824.0) : 0.0;
+            best.gap_p50_us = stats.GapPercentileUs(50);
+            best.gap_p99_us = stats.GapPercentileUs(99);
+            best.gap_p999_us = stats.GapPercentileUs(99.9);
+        }
+        return best;
+    }
+
+    void PrintHeader()
+    {
+        std::printf("%-30s %8s %8s %10s %10s %10s %10s %10s\n",
+                    "scenario", "file MB", "chunk", "MB/s", "CPU s/GB", "gap p50", "gap p99", "gap p99.9");
+    }
+
+    void PrintResult(const char *name, qint64 file_size, const QString &chunk, const Result &result)
+    {
+        std::printf("%-30s %8lld %8s %10.1f %10.3f %9.1fu %9.1fu %9.1fu\n", name, file_size / 1048576, qPrintable(chunk),
+                    result.megabytes_per_second, result.cpu_seconds_per_gb,
+                    result.gap_p50_us, result.gap_p99_us, result.gap_p999_us);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    if (argc > 1) {
+        output_dir = QString::fromLocal8Bit(argv[1]);
+    }
+    QList<qint64> file_sizes{ kFileSize };
+    for (const qint64 size : kMatrixFileSizes) {
+        if (!file_sizes.contains(size)) {
+            file_sizes.append(size);
+        }
+    }
+    for (const qint64 size : std::as_const(file_sizes)) {
+        if (!CreateTestFile(TestFilePath(size), size)) {
+            std::fprintf(stderr, "cannot create %s\n", qPrintable(TestFilePath(size)));
+            return 1;
+        }
+    }
+    std::printf("best of %d rounds, receiver %s\n", kRounds,
+                output_dir.isEmpty() ? "discards data" : qPrintable("writes to " + output_dir));
+    // 发送方式比较
+    const QString path = TestFilePath(kFileSize);
+    PrintHeader();
+    PrintResult("legacy (64 KB in flight)", kFileSize, "64K", RunScenario(path, [&](quint16 port) {
+        return RunLegacy(path, port);
+    }));
+    PrintResult("pipeline, latency profile", kFileSize, "auto", RunScenario(path, [&](quint16 port) {
+        return RunModel(path, port, NetworkModel::kLatencyProfile, false);
+    }));
+    PrintResult("pipeline, throughput profile", kFileSize, "auto", RunScenario(path, [&](quint16 port) {
+        return RunModel(path, port, NetworkModel::kThroughputProfile, false);
+    }));
+#ifdef Q_OS_LINUX
+    PrintResult("sendfile", kFileSize, "-", RunScenario(path, [&](quint16 port) {
+        return RunModel(path, port, NetworkModel::kThroughputProfile, true);
+    }));
+#endif
+    // 块大小与文件大小矩阵（吞吐优先，不使用零拷贝）
+    std::printf("\n");
+    PrintHeader();
+    for (const qint64 size : kMatrixFileSizes) {
+        const QString matrix_path = TestFilePath(size);
+        for (const qint64 chunk_size : kMatrixChunkSizes) {
+            const QString chunk = chunk_size > 0 ? QString("%1K").arg(chunk_size / 1024) : QString("auto");
+            PrintResult("pipeline, throughput profile", size, chunk, RunScenario(matrix_path, [&](quint16 port) {
+                return RunModel(matrix_path, port, NetworkModel::kThroughputProfile, false, chunk_size);
+            }));
+        }
+    }
+    return 0;
+}
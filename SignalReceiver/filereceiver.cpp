@@ -0,0 +1,171 @@
+﻿#include "filereceiver.h"
+#include <QDataStream>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QtEndian>
+#include <algorithm>
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+double FileReceiver::Stats::GapPercentileUs(double percentile) const
+{
+    if (read_gaps_ns.empty()) {
+        return 0.0;
+    }
+    std::vector<qint64> gaps = read_gaps_ns;
+    const auto index = static_cast<size_t>(qBound(0.0, percentile / 100.0, 1.0) * (gaps.size() - 1));
+    std::nth_element(gaps.begin(), gaps.begin() + index, gaps.end());
+    return gaps[index] / 1000.0;
+}
+
+FileReceiver::FileReceiver()
+{}
+
+FileReceiver::~FileReceiver()
+{
+    output_.close();
+}
+
+bool FileReceiver::Receive(const QString &host, quint16 port)
+{
+    stats_ = Stats();
+    error_.clear();
+    if (!buffer_) {
+        buffer_.reset(static_cast<char *>(::operator new[](kBufferSize, std::align_val_t(kBufferAlignment))));
+    }
+    QTcpSocket socket;
+    socket.setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 4 * 1024 * 1024);
+    socket.connectToHost(host, port);
+    if (!socket.waitForConnected(timeout_)) {
+        return Fail("无法连接: " + socket.errorString());
+    }
+    QElapsedTimer timer;
+    timer.start();
+    if (!ReadHeader(socket, timer) || !OpenOutput()) {
+        return false;
+    }
+    // 缓冲区写满后整块写入文件，只有最后一块可能不满
+    qint64 buffered{ 0 };
+    qint64 last_read_ns = timer.nsecsElapsed();
+    stats_.read_gaps_ns.reserve(static_cast<size_t>(stats_.file_size / (64 * 1024) + 16));
+    while (stats_.bytes_received < stats_.file_size) {
+        if (socket.bytesAvailable() == 0 && !socket.waitForReadyRead(timeout_)) {
+            return Fail("接收中断: " + socket.errorString());
+        }
+        const qint64 n = socket.read(buffer_.get() + buffered,
+                                     qMin(kBufferSize - buffered, stats_.file_size - stats_.bytes_received));
+        if (n < 0) {
+            return Fail("读取失败: " + socket.errorString());
+        }
+        if (n == 0) {
+            continue;
+        }
+        const qint64 now_ns = timer.nsecsElapsed();
+        stats_.read_gaps_ns.push_back(now_ns - last_read_ns);
+        last_read_ns = now_ns;
+        buffered += n;
+        stats_.bytes_received += n;
+        if (buffered == kBufferSize) {
+            if (!WriteBuffer(buffered)) {
+                return false;
+            }
+            buffered = 0;
+        }
+    }
+    if (buffered > 0 && !WriteBuffer(buffered)) {
+        return false;
+    }
+    stats_.elapsed_ns = timer.nsecsElapsed() - stats_.first_byte_ns;
+    output_.close();
+    return true;
+}
+
+bool FileReceiver::ReadHeader(QTcpSocket &socket, const QElapsedTimer &timer)
+{
+    const auto wait_for = [&](qint64 bytes) {
+        while (socket.bytesAvailable() < bytes) {
+            if (!socket.waitForReadyRead(timeout_)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    // 文件名为QDataStream格式的QString：4字节长度（0xFFFFFFFF表示空）+ UTF-16数据
+    if (!wait_for(4)) {
+        return Fail("等待文件头超时: " + socket.errorString());
+    }
+    stats_.first_byte_ns = timer.nsecsElapsed();
+    uchar length_bytes[4];
+    socket.peek(reinterpret_cast<char *>(length_bytes), 4);
+    quint32 name_length = qFromBigEndian<quint32>(length_bytes);
+    if (name_length == 0xFFFFFFFF) {
+        name_length = 0;
+    }
+    if (name_length > kMaxNameBytes || name_length % 2 != 0) {
+        return Fail("文件头格式错误");
+    }
+    const qint64 header_size = 4 + name_length + 8;
+    if (!wait_for(header_size)) {
+        return Fail("等待文件头超时: " + socket.errorString());
+    }
+    QDataStream stream(socket.read(header_size));
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream >> stats_.file_name >> stats_.file_size;
+    if (stream.status() != QDataStream::Ok || stats_.file_size < 0) {
+        return Fail("文件头格式错误");
+    }
+    return true;
+}
+
+bool FileReceiver::OpenOutput()
+{
+    if (output_dir_.isEmpty()) {
+        return true;
+    }
+    // 只使用文件名部分，不允许写到输出目录之外
+    QString name = QFileInfo(stats_.file_name).fileName();
+    if (name.isEmpty()) {
+        name = "received.bin";
+    }
+    output_.setFileName(QDir(output_dir_).filePath(name));
+    // 自行缓冲，关闭QFile的内部缓冲避免二次拷贝
+    if (!output_.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        return Fail("无法创建文件: " + output_.errorString());
+    }
+    if (stats_.file_size == 0) {
+        return true;
+    }
+#ifdef Q_OS_LINUX
+    // 一次分配全部空间，写入时不再逐块扩展文件；文件系统不支持时直接写入
+    if (fallocate(output_.handle(), 0, 0, stats_.file_size) != 0 && errno != EOPNOTSUPP && errno != ENOSYS) {
+        return Fail(QString("预分配失败: %1").arg(strerror(errno)));
+    }
+#else
+    if (!output_.resize(stats_.file_size) || !output_.seek(0)) {
+        return Fail("预分配失败: " + output_.errorString());
+    }
+#endif
+    return true;
+}
+
+bool FileReceiver::WriteBuffer(qint64 size)
+{
+    if (!output_.isOpen()) {
+        return true;
+    }
+    if (output_.write(buffer_.get(), size) != size) {
+        return Fail("写入文件失败: " + output_.errorString());
+    }
+    return true;
+}
+
+bool FileReceiver::Fail(const QString &error)
+{
+    error_ = error;
+    output_.close();
+    return false;
+}
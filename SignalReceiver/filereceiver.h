@@ -0,0 +1,64 @@
+﻿#pragma once
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+#include <QTcpSocket>
+#include <memory>
+#include <new>
+#include <vector>
+
+// 无界面的参考接收端
+// 连接到SignalTransmitter后按StartFileTransfer的文件头格式（QDataStream：文件名 + 文件大小）接收一个文件。
+// 收到文件头后先为目标文件预分配空间（Linux下fallocate），数据经按页对齐的大块缓冲区整块写入，
+// 减少文件系统的扩展和部分页拷贝。接收过程中记录每次读取的间隔，供吞吐和延迟测试使用。
+class FileReceiver
+{
+public:
+    struct Stats {
+        QString file_name;
+        qint64 file_size{ 0 };
+        qint64 bytes_received{ 0 };         // 文件内容字节数（不含文件头）
+        qint64 first_byte_ns{ 0 };          // 连接建立到收到第一个字节
+        qint64 elapsed_ns{ 0 };             // 收到第一个字节到接收完成
+        std::vector<qint64> read_gaps_ns;   // 相邻两次读到数据的间隔
+
+        double MegabytesPerSecond() const { return elapsed_ns > 0 ? bytes_received / 1048576.0 / (elapsed_ns / 1e9) : 0.0; }
+        // 读取间隔的百分位数（微秒），percentile取0~100
+        double GapPercentileUs(double percentile) const;
+    };
+
+    FileReceiver();
+    ~FileReceiver();
+
+    // output_dir为空时只接收不写入磁盘（测量网络本身）
+    void set_output_dir(const QString &output_dir) { output_dir_ = output_dir; }
+    void set_timeout(int milliseconds) { timeout_ = milliseconds; }
+
+    // 阻塞接收，在调用线程中完成
+    bool Receive(const QString &host, quint16 port);
+    const Stats &get_stats() const { return stats_; }
+    const QString &get_error() const { return error_; }
+
+    static constexpr qint64 kBufferSize{ 4 * 1024 * 1024 };
+    static constexpr size_t kBufferAlignment{ 4096 };
+    static constexpr quint32 kMaxNameBytes{ 64 * 1024 };
+
+private:
+    bool ReadHeader(QTcpSocket &socket, const QElapsedTimer &timer);
+    bool OpenOutput();
+    bool WriteBuffer(qint64 size);
+    bool Fail(const QString &error);
+
+private:
+    struct AlignedDeleter {
+        void operator()(char *p) const { ::operator delete[](p, std::align_val_t(kBufferAlignment)); }
+    };
+
+    QString output_dir_;
+    int timeout_{ 30000 };
+    std::unique_ptr<char[], AlignedDeleter> buffer_;
+    QFile output_;
+    Stats stats_;
+    QString error_;
+};
@@ -0,0 +1,40 @@
+﻿// 无界面参考接收端：连接SignalTransmitter接收一个文件，输出吞吐量和读取间隔统计
+#include "filereceiver.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <cstdio>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("SignalReceiver");
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless reference receiver for SignalTransmitter");
+    parser.addHelpOption();
+    parser.addOption({ { "H", "host" }, "Server address.", "host", "127.0.0.1" });
+    parser.addOption({ { "p", "port" }, "Server port.", "port" });
+    parser.addOption({ { "o", "output" }, "Directory for the received file; omit to discard the data.", "dir" });
+    parser.addOption({ { "t", "timeout" }, "Timeout in milliseconds while waiting for data.", "ms", "30000" });
+    parser.process(app);
+
+    bool ok{ false };
+    const auto port = parser.value("port").toUShort(&ok);
+    if (!ok || port == 0) {
+        std::fprintf(stderr, "invalid or missing --port\n");
+        return 2;
+    }
+    FileReceiver receiver;
+    receiver.set_output_dir(parser.value("output"));
+    receiver.set_timeout(parser.value("timeout").toInt());
+    if (!receiver.Receive(parser.value("host"), port)) {
+        std::fprintf(stderr, "%s\n", qPrintable(receiver.get_error()));
+        return 1;
+    }
+    const auto &stats = receiver.get_stats();
+    std::printf("file: %s, %lld bytes\n", qPrintable(stats.file_name), stats.bytes_received);
+    std::printf("first byte: %.2f ms, transfer: %.2f ms, %.1f MB/s\n",
+                stats.first_byte_ns / 1e6, stats.elapsed_ns / 1e6, stats.MegabytesPerSecond());
+    std::printf("read gap: p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n",
+                stats.GapPercentileUs(50), stats.GapPercentileUs(99), stats.GapPercentileUs(99.9), stats.GapPercentileUs(100));
+    return 0;
+}
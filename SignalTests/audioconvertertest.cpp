@@ -0,0 +1,91 @@
+﻿#include "audioconvertertest.h"
+#include "audioconverter.h"
+#include <QtTest>
+#include <vector>
+
+namespace {
+
+constexpr int kFrames{ 64 };
+
+QAudioFormat FloatFormat(int channels)
+{
+    QAudioFormat format;
+    format.setSampleRate(48000);
+    format.setChannelCount(channels);
+    format.setSampleFormat(QAudioFormat::Float);
+    return format;
+}
+
+// 每帧相同的输入经同采样率转换后的第一帧输出
+std::vector<float> ConvertFrame(int in_channels, int out_channels, const std::vector<float> &frame)
+{
+    AudioConverter converter;
+    if (!converter.Configure(FloatFormat(in_channels), FloatFormat(out_channels), kFrames)) {
+        return {};
+    }
+    std::vector<float> input;
+    for (int i = 0; i < kFrames; ++i) {
+        input.insert(input.end(), frame.begin(), frame.end());
+    }
+    std::vector<float> output(static_cast<size_t>(converter.MaxOutputFrames(kFrames)) * out_channels);
+    const int frames = converter.Process(reinterpret_cast<const char *>(input.data()), kFrames, reinterpret_cast<char *>(output.data()));
+    if (frames != kFrames) {
+        return {};
+    }
+    output.resize(out_channels);
+    return output;
+}
+
+}
+
+void AudioConverterTest::SurroundToStereo_data()
+{
+    // 5.1声道顺序：FL FR FC LFE BL BR；只有一个声道有信号时它在左右声道中的位置
+    QTest::addColumn<int>("channel");
+    QTest::addColumn<bool>("left");
+    QTest::addColumn<bool>("right");
+    QTest::newRow("front left") << 0 << true << false;
+    QTest::newRow("front right") << 1 << false << true;
+    QTest::newRow("centre") << 2 << true << true;
+    QTest::newRow("lfe") << 3 << true << true;
+    QTest::newRow("back left") << 4 << true << false;
+    QTest::newRow("back right") << 5 << false << true;
+}
+
+void AudioConverterTest::SurroundToStereo()
+{
+    QFETCH(int, channel);
+    QFETCH(bool, left);
+    QFETCH(bool, right);
+    std::vector<float> frame(6, 0.0f);
+    frame[channel] = 0.5f;
+    const std::vector<float> output = ConvertFrame(6, 2, frame);
+    QCOMPARE(output.size(), size_t(2));
+    QCOMPARE(output[0] > 0.0f, left);
+    QCOMPARE(output[1] > 0.0f, right);
+    QCOMPARE(output[0] == 0.0f, !left);
+    QCOMPARE(output[1] == 0.0f, !right);
+    // 中置和LFE左右对称
+    if (left && right) {
+        QCOMPARE(output[0], output[1]);
+    }
+}
+
+void AudioConverterTest::SurroundFullScale()
+{
+    // 所有声道满幅时混合结果恰好满幅，不削波；前置声道比环绕声道权重大
+    const std::vector<float> full = ConvertFrame(6, 2, std::vector<float>(6, 1.0f));
+    QCOMPARE(full.size(), size_t(2));
+    QVERIFY(qFuzzyCompare(full[0], 1.0f));
+    QVERIFY(qFuzzyCompare(full[1], 1.0f));
+    const std::vector<float> front = ConvertFrame(6, 2, { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f });
+    const std::vector<float> back = ConvertFrame(6, 2, { 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f });
+    QVERIFY(front[0] > back[0]);
+}
+
+void AudioConverterTest::StereoToMono()
+{
+    const std::vector<float> output = ConvertFrame(2, 1, { 0.5f, 0.25f });
+    QCOMPARE(output.size(), size_t(1));
+    QCOMPARE(output[0], 0.375f);
+}
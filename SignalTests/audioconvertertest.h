@@ -0,0 +1,15 @@
+﻿#pragma once
+
+#include <QObject>
+
+// 格式转换测试：5.1到立体声折叠中置、LFE和环绕声道，立体声到单声道取平均
+class AudioConverterTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void SurroundToStereo_data();
+    void SurroundToStereo();
+    void SurroundFullScale();
+    void StereoToMono();
+};
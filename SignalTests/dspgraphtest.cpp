@@ -0,0 +1,311 @@
+﻿#include "dspgraphtest.h"
+#include "dspblocks.h"
+#include "dspgraph.h"
+#include "signalcore.h"
+#include "wavfile.h"
+#include <QtTest>
+#include <QBuffer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QThread>
+#include <QThreadPool>
+#include <atomic>
+
+namespace {
+
+// 顺序整数源：count为负时不结束
+class CountingSourceBlock : public DspBlock
+{
+public:
+    CountingSourceBlock(qint64 count, DspStream<qint64> *out)
+        : DspBlock({}, { out })
+        , count_(count)
+        , out_(out)
+    {}
+
+    Status_t Work() override
+    {
+        if (count_ >= 0 && next_ >= count_) {
+            return Done();
+        }
+        const size_t n = count_ >= 0 ? static_cast<size_t>(qMin<qint64>(kChunk, count_ - next_)) : kChunk;
+        buffer_.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            buffer_[i] = next_ + static_cast<qint64>(i);
+        }
+        const size_t written = out_->Write(buffer_.data(), n);
+        next_ += static_cast<qint64>(written);
+        produced_.store(next_, std::memory_order_release);
+        return written > 0 ? kProgress : kIdle;
+    }
+
+    qint64 get_produced() const { return produced_.load(std::memory_order_acquire); }
+
+private:
+    qint64 count_;
+    DspStream<qint64> *out_;
+    qint64 next_{ 0 };
+    std::atomic<qint64> produced_{ 0 };
+    std::vector<qint64> buffer_;
+};
+
+// 检查数据连续的汇：gate关闭时不读数据（让出时间片后重试），读到fail_at个元素后失败
+class CheckingSinkBlock : public DspBlock
+{
+public:
+    CheckingSinkBlock(const CountingSourceBlock *source, DspStream<qint64> *in, qint64 fail_at = -1)
+        : DspBlock({ in }, {})
+        , source_(source)
+        , in_(in)
+        , fail_at_(fail_at)
+        , buffer_(kChunk)
+    {}
+
+    Status_t Work() override
+    {
+        if (!gate_.load(std::memory_order_acquire)) {
+            QThread::yieldCurrentThread();
+            return kProgress;
+        }
+        // 上游只能写入下游已腾出的空间
+        max_ahead_ = qMax(max_ahead_, source_->get_produced() - consumed_);
+        const bool drained = in_->IsDrained();
+        const size_t n = in_->Read(buffer_.data(), buffer_.size());
+        if (n == 0) {
+            return drained ? Done() : kIdle;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (buffer_[i] != consumed_ + static_cast<qint64>(i)) {
+                return Fail("数据不连续");
+            }
+        }
+        consumed_ += static_cast<qint64>(n);
+        consumed_total_.store(consumed_, std::memory_order_release);
+        if (fail_at_ >= 0 && consumed_ >= fail_at_) {
+            return Fail("停止");
+        }
+        return kProgress;
+    }
+
+    void set_gate(bool open) { gate_.store(open, std::memory_order_release); }
+    qint64 get_consumed() const { return consumed_total_.load(std::memory_order_acquire); }
+    qint64 get_max_ahead() const { return max_ahead_; }
+
+private:
+    const CountingSourceBlock *source_;
+    DspStream<qint64> *in_;
+    qint64 fail_at_;
+    std::vector<qint64> buffer_;
+    std::atomic<bool> gate_{ true };
+    qint64 consumed_{ 0 };
+    std::atomic<qint64> consumed_total_{ 0 };
+    qint64 max_ahead_{ 0 };
+};
+
+// 整段卷积，累加顺序与FirFilterBlock相同，结果应逐位相同
+QList<double> Convolve(const QList<double> &x, const std::vector<double> &taps)
+{
+    QList<double> y(x.size());
+    for (qsizetype i = 0; i < x.size(); ++i) {
+        double acc{ 0.0 };
+        for (qsizetype k = 0; k < static_cast<qsizetype>(taps.size()); ++k) {
+            acc += taps[k] * (i - k >= 0 ? x[i - k] : 0.0);
+        }
+        y[i] = acc;
+    }
+    return y;
+}
+
+QList<double> RandomSignal(qsizetype size)
+{
+    QRandomGenerator random(4321);
+    QList<double> x(size);
+    for (auto &v : x) {
+        v = random.generateDouble() * 2.0 - 1.0;
+    }
+    return x;
+}
+
+std::vector<double> RandomTaps(int count)
+{
+    QRandomGenerator random(8765);
+    std::vector<double> taps(count);
+    for (auto &v : taps) {
+        v = random.generateDouble() - 0.5;
+    }
+    return taps;
+}
+
+}
+
+void DspGraphTest::Backpressure()
+{
+    constexpr size_t kCapacity{ 256 };
+    constexpr qint64 kCount{ 20 * DspBlock::kChunk + 7 };
+    QThreadPool pool;
+    pool.setMaxThreadCount(2);
+    DspGraph graph;
+    auto *stream = graph.AddStream<qint64>(kCapacity);
+    auto *source = graph.AddBlock<CountingSourceBlock>(kCount, stream);
+    auto *sink = graph.AddBlock<CheckingSinkBlock>(source, stream);
+    sink->set_gate(false);
+    graph.Start(&pool);
+    // 下游不读时上游写满缓冲区后停下
+    QTRY_COMPARE(source->get_produced(), qint64(kCapacity));
+    QThread::msleep(50);
+    QCOMPARE(source->get_produced(), qint64(kCapacity));
+    sink->set_gate(true);
+    QVERIFY(graph.Wait());
+    QCOMPARE(sink->get_consumed(), kCount);
+    QVERIFY(sink->get_max_ahead() <= qint64(kCapacity));
+}
+
+void DspGraphTest::FailureCancels()
+{
+    // 源不会结束，只有汇失败后取消其余块，Wait才能返回
+    QThreadPool pool;
+    pool.setMaxThreadCount(2);
+    DspGraph graph;
+    auto *stream = graph.AddStream<qint64>(1024);
+    auto *source = graph.AddBlock<CountingSourceBlock>(-1, stream);
+    auto *sink = graph.AddBlock<CheckingSinkBlock>(source, stream, 10 * DspBlock::kChunk);
+    QVERIFY(!graph.Run(&pool));
+    QCOMPARE(graph.get_error(), QString("停止"));
+    QVERIFY(sink->get_consumed() >= qint64(10 * DspBlock::kChunk));
+}
+
+void DspGraphTest::DestroyCancels()
+{
+    // 未等待结束就销毁图：析构函数取消仍在运行的块并等待它们退出
+    QThreadPool pool;
+    pool.setMaxThreadCount(2);
+    {
+        DspGraph graph;
+        auto *stream = graph.AddStream<qint64>(1024);
+        auto *source = graph.AddBlock<CountingSourceBlock>(-1, stream);
+        auto *sink = graph.AddBlock<CheckingSinkBlock>(source, stream);
+        graph.Start(&pool);
+        QTRY_VERIFY(sink->get_consumed() > 0);
+    }
+    // 所有块都已退出，线程池中不再有图的任务
+    QVERIFY(pool.waitForDone(5000));
+}
+
+void DspGraphTest::FirChunked_data()
+{
+    QTest::addColumn<qsizetype>("size");
+    QTest::addColumn<int>("tap_count");
+    QTest::addColumn<int>("capacity");
+    // 长度不是整段；流容量小于一段，输出经常写不下需要留到下次
+    QTest::newRow("short") << qsizetype(10) << 31 << 4096;
+    QTest::newRow("multi chunk") << qsizetype(5 * DspBlock::kChunk + 123) << 63 << 16384;
+    QTest::newRow("small stream") << qsizetype(3 * DspBlock::kChunk + 17) << 17 << 1000;
+    QTest::newRow("single tap") << qsizetype(2 * DspBlock::kChunk + 1) << 1 << 512;
+}
+
+void DspGraphTest::FirChunked()
+{
+    QFETCH(qsizetype, size);
+    QFETCH(int, tap_count);
+    QFETCH(int, capacity);
+    const QList<double> x = RandomSignal(size);
+    const std::vector<double> taps = RandomTaps(tap_count);
+
+    DspGraph graph;
+    auto *in = graph.AddStream<double>(capacity);
+    auto *out = graph.AddStream<double>(capacity);
+    graph.AddBlock<VectorSourceBlock<double>>(x, in);
+    graph.AddBlock<FirFilterBlock>(taps, in, out);
+    auto *sink = graph.AddBlock<VectorSinkBlock<double>>(out, size);
+    QVERIFY(graph.Run());
+    QCOMPARE(sink->get_data(), Convolve(x, taps));
+}
+
+void DspGraphTest::WavSink()
+{
+    QVERIFY(dir_.isValid());
+    const QString path = dir_.filePath("fir.wav");
+    const QList<double> x = RandomSignal(3 * DspBlock::kChunk + 5);
+    const std::vector<double> taps = RandomTaps(9);
+    const QList<double> expected = Convolve(x, taps);
+
+    DspGraph graph;
+    auto *in = graph.AddStream<double>();
+    auto *out = graph.AddStream<double>();
+    graph.AddBlock<VectorSourceBlock<double>>(x, in);
+    graph.AddBlock<FirFilterBlock>(taps, in, out);
+    graph.AddBlock<WavSinkBlock>(path, 48000, out);
+    QVERIFY(graph.Run());
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray data = file.readAll();
+    WavInfo info;
+    QVERIFY(ParseWavHeader(reinterpret_cast<const uchar *>(data.constData()), data.size(), info));
+    QCOMPARE(info.format_tag, int(WavInfo::kFormatFloat));
+    QCOMPARE(info.channels, 1);
+    QCOMPARE(info.sample_rate, 48000);
+    QCOMPARE(info.bits_per_sample, 32);
+    QCOMPARE(info.get_frame_count(), qint64(expected.size()));
+    const uchar *p = reinterpret_cast<const uchar *>(data.constData()) + info.data_offset;
+    for (qsizetype i = 0; i < expected.size(); ++i) {
+        QCOMPARE(qFromLittleEndian<float>(p + i * 4), static_cast<float>(expected[i]));
+    }
+}
+
+void DspGraphTest::PipelineMatchesBatch_data()
+{
+    QTest::addColumn<int>("encoding");
+    QTest::addColumn<int>("modulation");
+    QTest::addColumn<qint64>("input_bytes");
+    QTest::addColumn<bool>("modulated");
+    QTest::newRow("utf8-ask") << int(SignalCore::kEncodingUtf8) << int(SignalCore::kModulationAsk) << qint64(4096) << true;
+    QTest::newRow("utf16-psk") << int(SignalCore::kEncodingUtf16) << int(SignalCore::kModulationPsk) << qint64(4096) << true;
+    // 输入超过一段时只比较编码结果，调制文本文件过大
+    QTest::newRow("utf8-multichunk") << int(SignalCore::kEncodingUtf8) << int(SignalCore::kModulationAsk)
+                                     << 3 * TextDeviceSourceBlock::kInputChunk / 2 << false;
+}
+
+void DspGraphTest::PipelineMatchesBatch()
+{
+    QFETCH(int, encoding);
+    QFETCH(int, modulation);
+    QFETCH(qint64, input_bytes);
+    QFETCH(bool, modulated);
+    QVERIFY(dir_.isValid());
+    // 含回车和代理对，检查跨段字符和去掉回车
+    const QString unit = QString::fromUtf8("信号\r\nab\U0001F600c ");
+    const qsizetype unit_bytes = unit.toUtf8().size();
+    const QString text = unit.repeated((input_bytes + unit_bytes - 1) / unit_bytes);
+    QByteArray input = text.toUtf8();
+    QBuffer device(&input);
+    QVERIFY(device.open(QIODevice::ReadOnly));
+
+    const QString tag = QTest::currentDataTag();
+    SignalPipeline::Outputs outputs;
+    outputs.encoded_path = dir_.filePath(tag + "_encoded.txt");
+    if (modulated) {
+        outputs.modulated_path = dir_.filePath(tag + "_modulated.txt");
+    }
+    SignalPipeline pipeline(SignalCore::Encoding_t(encoding), SignalCore::Modulation_t(modulation));
+    QVERIFY2(pipeline.Run(device, outputs), qPrintable(pipeline.get_error()));
+    QCOMPARE(pipeline.get_input_bytes(), qint64(input.size()));
+
+    const QString stripped = QString(text).remove(QChar('\r'));
+    const QList<uint8_t> bits = SignalCore::Encode(stripped, SignalCore::Encoding_t(encoding));
+    QCOMPARE(pipeline.get_bit_count(), qint64(bits.size()));
+    const QString expected_encoded = dir_.filePath(tag + "_expected_encoded.txt");
+    QString error;
+    QVERIFY(SignalCore::WriteEncodedFile(expected_encoded, bits, error));
+
+    auto read_all = [](const QString &path) {
+        QFile file(path);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    };
+    QCOMPARE(read_all(outputs.encoded_path), read_all(expected_encoded));
+    if (modulated) {
+        const QString expected_modulated = dir_.filePath(tag + "_expected_modulated.txt");
+        QVERIFY(SignalCore::WriteModulatedFile(expected_modulated, SignalCore::Modulate(bits, SignalCore::Modulation_t(modulation)), error));
+        QCOMPARE(read_all(outputs.modulated_path), read_all(expected_modulated));
+    }
+}
@@ -0,0 +1,24 @@
+﻿#pragma once
+
+#include <QObject>
+#include <QTemporaryDir>
+
+// 数据流图测试：背压、失败和提前销毁时的取消、FIR分段处理与整段卷积结果相同、WAV文件汇、
+// 流式处理与整段编码调制的输出相同
+class DspGraphTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void Backpressure();
+    void FailureCancels();
+    void DestroyCancels();
+    void FirChunked_data();
+    void FirChunked();
+    void WavSink();
+    void PipelineMatchesBatch_data();
+    void PipelineMatchesBatch();
+
+private:
+    QTemporaryDir dir_;
+};
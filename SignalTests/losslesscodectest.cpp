@@ -0,0 +1,169 @@
+﻿#include "losslesscodectest.h"
+#include "losslesscodec.h"
+#include "wavfile.h"
+#include <QtTest>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QtEndian>
+#include <QtMath>
+
+namespace {
+
+// 不是整块的帧数，最后一块不满
+constexpr qint64 kFrames{ 3 * LosslessCodec::kBlockFrames + 123 };
+
+// 写出标准44字节文件头的WAV文件
+bool WriteWavFile(const QString &path, int format_tag, int bits, int channels, int sample_rate, const QByteArray &data)
+{
+    QByteArray header(44, '\0');
+    uchar *p = reinterpret_cast<uchar *>(header.data());
+    const int block_align = channels * bits / 8;
+    memcpy(p, "RIFF", 4);
+    qToLittleEndian<quint32>(quint32(36 + data.size()), p + 4);
+    memcpy(p + 8, "WAVEfmt ", 8);
+    qToLittleEndian<quint32>(16, p + 16);
+    qToLittleEndian<quint16>(quint16(format_tag), p + 20);
+    qToLittleEndian<quint16>(quint16(channels), p + 22);
+    qToLittleEndian<quint32>(quint32(sample_rate), p + 24);
+    qToLittleEndian<quint32>(quint32(sample_rate * block_align), p + 28);
+    qToLittleEndian<quint16>(quint16(block_align), p + 32);
+    qToLittleEndian<quint16>(quint16(bits), p + 34);
+    memcpy(p + 36, "data", 4);
+    qToLittleEndian<quint32>(quint32(data.size()), p + 40);
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(header) == header.size() && file.write(data) == data.size();
+}
+
+// 测试信号：正弦 + 噪声、静音、极小幅度（LPC量化移位最大）、满幅跳变，覆盖各种预测方式
+double TestSample(qint64 frame, int channel, QRandomGenerator &random)
+{
+    const qint64 section = frame / LosslessCodec::kBlockFrames;
+    const double t = double(frame) / 48000.0;
+    switch (section) {
+    case 0: return 0.6 * std::sin(2.0 * M_PI * (440.0 + 110.0 * channel) * t) + 0.05 * (random.generateDouble() - 0.5);
+    case 1: return frame % 1000 < 500 ? 0.0 : 1e-6 * std::sin(2.0 * M_PI * 50.0 * t);
+    case 2: return (frame / 7) % 2 ? 1.0 : -1.0;
+    default: return random.generateDouble() * 2.0 - 1.0;
+    }
+}
+
+QByteArray MakeSamples(int format_tag, int bits, int channels)
+{
+    QRandomGenerator random(1234);
+    const int bytes = bits / 8;
+    QByteArray data(kFrames * channels * bytes, Qt::Uninitialized);
+    uchar *p = reinterpret_cast<uchar *>(data.data());
+    const double full_scale = std::ldexp(1.0, bits - 1);
+    for (qint64 i = 0; i < kFrames; ++i) {
+        for (int c = 0; c < channels; ++c, p += bytes) {
+            const double v = TestSample(i, c, random);
+            if (format_tag == WavInfo::kFormatFloat) {
+                qToLittleEndian<float>(static_cast<float>(v), p);
+                continue;
+            }
+            const qint32 s = static_cast<qint32>(qBound(-full_scale, std::round(v * full_scale), full_scale - 1));
+            switch (bits) {
+            case 8: *p = static_cast<uchar>(s + 128); break;
+            case 16: qToLittleEndian<qint16>(static_cast<qint16>(s), p); break;
+            default:
+                p[0] = static_cast<uchar>(s);
+                p[1] = static_cast<uchar>(s >> 8);
+                p[2] = static_cast<uchar>(s >> 16);
+                break;
+            }
+        }
+    }
+    return data;
+}
+
+}
+
+void LosslessCodecTest::initTestCase()
+{
+    QVERIFY(dir_.isValid());
+}
+
+void LosslessCodecTest::RoundTrip_data()
+{
+    QTest::addColumn<int>("format_tag");
+    QTest::addColumn<int>("bits");
+    QTest::addColumn<int>("channels");
+    QTest::newRow("int8 mono") << int(WavInfo::kFormatPcm) << 8 << 1;
+    QTest::newRow("int16 stereo") << int(WavInfo::kFormatPcm) << 16 << 2;
+    QTest::newRow("int24 stereo") << int(WavInfo::kFormatPcm) << 24 << 2;
+    QTest::newRow("float32 mono") << int(WavInfo::kFormatFloat) << 32 << 1;
+}
+
+void LosslessCodecTest::RoundTrip()
+{
+    QFETCH(int, format_tag);
+    QFETCH(int, bits);
+    QFETCH(int, channels);
+    const QString name = QString("%1_%2_%3").arg(format_tag).arg(bits).arg(channels);
+    const QString wav_path = dir_.filePath(name + ".wav");
+    const QString stfl_path = dir_.filePath(name + ".stfl");
+    const QString decoded_path = dir_.filePath(name + "_decoded.wav");
+    QVERIFY(WriteWavFile(wav_path, format_tag, bits, channels, 48000, MakeSamples(format_tag, bits, channels)));
+
+    QVERIFY(LosslessCodec::EncodeWavFile(wav_path, stfl_path));
+    QVERIFY(LosslessCodec::IsCompressedFile(stfl_path));
+    QVERIFY(LosslessCodec::DecodeToWavFile(stfl_path, decoded_path));
+
+    // 解码文件可能使用不同的容器（24位解码为32位），按归一化样本逐个比较
+    QFile original(wav_path), decoded(decoded_path);
+    QVERIFY(original.open(QIODevice::ReadOnly) && decoded.open(QIODevice::ReadOnly));
+    const uchar *original_data = original.map(0, original.size());
+    const uchar *decoded_data = decoded.map(0, decoded.size());
+    QVERIFY(original_data && decoded_data);
+    WavInfo original_info, decoded_info;
+    QVERIFY(ParseWavHeader(original_data, original.size(), original_info));
+    QVERIFY(ParseWavHeader(decoded_data, decoded.size(), decoded_info));
+    QCOMPARE(decoded_info.format_tag, original_info.format_tag);
+    QCOMPARE(decoded_info.channels, channels);
+    QCOMPARE(decoded_info.sample_rate, original_info.sample_rate);
+    QCOMPARE(decoded_info.get_frame_count(), kFrames);
+    const int original_bytes = original_info.bits_per_sample / 8;
+    const int decoded_bytes = decoded_info.bits_per_sample / 8;
+    for (qint64 i = 0; i < kFrames * channels; ++i) {
+        const float a = LoadNormalizedSample(original_data + original_info.data_offset + i * original_bytes, original_info);
+        const float b = LoadNormalizedSample(decoded_data + decoded_info.data_offset + i * decoded_bytes, decoded_info);
+        if (a != b) {
+            QFAIL(qPrintable(QString("sample %1 differs: %2 != %3").arg(i).arg(a).arg(b)));
+        }
+    }
+}
+
+void LosslessCodecTest::CorruptHeader_data()
+{
+    // 文件头中的偏移和改写的值
+    QTest::addColumn<int>("offset");
+    QTest::addColumn<quint32>("value");
+    QTest::newRow("block count too small") << 28 << quint32(1);
+    QTest::newRow("block count too large") << 28 << quint32(100);
+    QTest::newRow("block frames too large") << 16 << quint32(1 << 30);
+    QTest::newRow("block frames zero") << 16 << quint32(0);
+    QTest::newRow("too many channels") << 6 << quint32(LosslessCodec::kMaxChannels + 1);
+}
+
+void LosslessCodecTest::CorruptHeader()
+{
+    QFETCH(int, offset);
+    QFETCH(quint32, value);
+    const QString wav_path = dir_.filePath("corrupt.wav");
+    const QString stfl_path = dir_.filePath("corrupt.stfl");
+    QVERIFY(WriteWavFile(wav_path, WavInfo::kFormatPcm, 16, 1, 48000, MakeSamples(WavInfo::kFormatPcm, 16, 1)));
+    QVERIFY(LosslessCodec::EncodeWavFile(wav_path, stfl_path));
+
+    QFile file(stfl_path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QByteArray data = file.readAll();
+    uchar *header = reinterpret_cast<uchar *>(data.data());
+    if (offset == 6) {
+        qToLittleEndian<quint16>(static_cast<quint16>(value), header + offset);
+    } else {
+        qToLittleEndian<quint32>(value, header + offset);
+    }
+    QVERIFY(file.seek(0) && file.write(data) == data.size());
+    file.close();
+    QVERIFY(!LosslessCodec::DecodeToWavFile(stfl_path, dir_.filePath("corrupt_decoded.wav")));
+}
@@ -0,0 +1,20 @@
+﻿#pragma once
+
+#include <QObject>
+#include <QTemporaryDir>
+
+// 无损压缩测试：8/16/24位整数和32位浮点WAV编码后再解码，样本须逐个相同；文件头损坏时解码失败
+class LosslessCodecTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void RoundTrip_data();
+    void RoundTrip();
+    void CorruptHeader_data();
+    void CorruptHeader();
+
+private:
+    QTemporaryDir dir_;
+};
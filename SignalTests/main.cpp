@@ -0,0 +1,30 @@
+﻿#include <QCoreApplication>
+#include <QtTest>
+#include "playbacktest.h"
+#include "losslesscodectest.h"
+#include "dspgraphtest.h"
+#include "audioconvertertest.h"
+
+// 依次运行各测试类，任一失败时返回非零
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int status = 0;
+    {
+        PlaybackTest test;
+        status |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        LosslessCodecTest test;
+        status |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        DspGraphTest test;
+        status |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        AudioConverterTest test;
+        status |= QTest::qExec(&test, argc, argv);
+    }
+    return status;
+}
@@ -0,0 +1,205 @@
+﻿#include "playbacktest.h"
+#include "audiomodel.h"
+#include <QtTest>
+
+namespace {
+
+// 测试文件：8000Hz单声道16位，第i帧的样本值为i
+constexpr int kSampleRate{ 8000 };
+constexpr qint64 kTotalFrames{ 20000 };
+
+QAudioFormat FileFormat()
+{
+    QAudioFormat format;
+    format.setSampleRate(kSampleRate);
+    format.setChannelCount(1);
+    format.setSampleFormat(QAudioFormat::Int16);
+    return format;
+}
+
+}
+
+void PlaybackTest::initTestCase()
+{
+    QVERIFY(dir_.isValid());
+    wav_path_ = dir_.filePath("playback.wav");
+    WavStreamWriter writer;
+    QVERIFY(writer.Open(wav_path_, FileFormat()));
+    QList<qint16> samples(kTotalFrames);
+    for (qint64 i = 0; i < kTotalFrames; ++i) {
+        samples[i] = static_cast<qint16>(i);
+    }
+    QVERIFY(writer.Write(reinterpret_cast<const char *>(samples.constData()), samples.size() * sizeof(qint16)));
+    QVERIFY(writer.Close());
+}
+
+bool PlaybackTest::IsSequence(const QByteArray &data, qint64 first)
+{
+    const auto *samples = reinterpret_cast<const qint16 *>(data.constData());
+    for (qsizetype i = 0; i < data.size() / qsizetype(sizeof(qint16)); ++i) {
+        if (samples[i] != static_cast<qint16>(first + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PlaybackTest::PlayToEnd()
+{
+    auto device = std::make_shared<NullAudioOutputDevice>();
+    QBuffer capture;
+    capture.open(QIODevice::WriteOnly);
+    device->set_capture(&capture);
+    AudioModel model(nullptr);
+    model.set_output_device(device);
+    QSignalSpy finished(&model, &AudioModel::PlaybackFinished);
+    QVERIFY(model.LoadWavFile(wav_path_));
+    QCOMPARE(model.get_playback_total_frames(), kTotalFrames);
+    QVERIFY(model.StartPlayback());
+    NullAudioOutput *output = device->get_output();
+    QVERIFY(output);
+
+    QCOMPARE(output->Pull(1000), 1000);
+    QCOMPARE(model.get_playback_position(), 1000);
+    // 读到文件末尾：只取出剩余帧，进入Idle状态，排队处理后播放结束
+    QCOMPARE(output->Pull(kTotalFrames), kTotalFrames - 1000);
+    QCOMPARE(model.get_playback_position(), kTotalFrames);
+    QCOMPARE(output->State(), QAudio::IdleState);
+    QTRY_COMPARE(finished.count(), 1);
+    QVERIFY(!model.IsPlaying());
+    QCOMPARE(model.get_playback_position(), 0);
+    QCOMPARE(capture.size(), kTotalFrames * qint64(sizeof(qint16)));
+    QVERIFY(IsSequence(capture.data(), 0));
+}
+
+void PlaybackTest::PauseResume()
+{
+    auto device = std::make_shared<NullAudioOutputDevice>();
+    QBuffer capture;
+    capture.open(QIODevice::WriteOnly);
+    device->set_capture(&capture);
+    AudioModel model(nullptr);
+    model.set_output_device(device);
+    QVERIFY(model.LoadWavFile(wav_path_));
+    QVERIFY(model.StartPlayback());
+    NullAudioOutput *output = device->get_output();
+
+    QCOMPARE(output->Pull(300), 300);
+    model.PausePlayback();
+    QVERIFY(!model.IsPlaying());
+    QCOMPARE(model.get_playback_position(), 300);
+    // 暂停时不输出数据，位置不变
+    QCOMPARE(output->Pull(300), 0);
+    QCOMPARE(model.get_playback_position(), 300);
+    model.PausePlayback();
+    QVERIFY(model.IsPlaying());
+    QCOMPARE(output->Pull(300), 300);
+    QCOMPARE(model.get_playback_position(), 600);
+    QCOMPARE(capture.size(), 600 * qint64(sizeof(qint16)));
+    QVERIFY(IsSequence(capture.data(), 0));
+}
+
+void PlaybackTest::SeekWhilePlaying()
+{
+    auto device = std::make_shared<NullAudioOutputDevice>();
+    QBuffer capture;
+    capture.open(QIODevice::WriteOnly);
+    device->set_capture(&capture);
+    AudioModel model(nullptr);
+    model.set_output_device(device);
+    QVERIFY(model.LoadWavFile(wav_path_));
+    QVERIFY(model.StartPlayback());
+    NullAudioOutput *output = device->get_output();
+
+    QCOMPARE(output->Pull(500), 500);
+    QVERIFY(model.SeekPlayback(12345));
+    QCOMPARE(model.get_playback_position(), 12345);
+    QVERIFY(model.IsPlaying());
+    capture.buffer().clear();
+    capture.seek(0);
+    QCOMPARE(output->Pull(100), 100);
+    QCOMPARE(model.get_playback_position(), 12445);
+    QVERIFY(IsSequence(capture.data(), 12345));
+}
+
+void PlaybackTest::SeekWhilePaused()
+{
+    auto device = std::make_shared<NullAudioOutputDevice>();
+    QBuffer capture;
+    capture.open(QIODevice::WriteOnly);
+    device->set_capture(&capture);
+    AudioModel model(nullptr);
+    model.set_output_device(device);
+    QVERIFY(model.LoadWavFile(wav_path_));
+    QVERIFY(model.StartPlayback());
+    NullAudioOutput *output = device->get_output();
+
+    QCOMPARE(output->Pull(500), 500);
+    model.PausePlayback();
+    QVERIFY(model.SeekPlayback(2000));
+    QCOMPARE(model.get_playback_position(), 2000);
+    QVERIFY(!model.IsPlaying());
+    // 暂停时跳转不启动输出，不会漏出声音
+    QVERIFY(output->State() != QAudio::ActiveState && output->State() != QAudio::IdleState);
+    QCOMPARE(output->Pull(100), 0);
+    QVERIFY(model.SeekPlayback(3000));
+    QCOMPARE(model.get_playback_position(), 3000);
+    QCOMPARE(capture.size(), 500 * qint64(sizeof(qint16)));
+    // 继续播放从最后跳转的位置开始
+    model.PausePlayback();
+    QVERIFY(model.IsPlaying());
+    capture.buffer().clear();
+    capture.seek(0);
+    QCOMPARE(output->Pull(100), 100);
+    QCOMPARE(model.get_playback_position(), 3100);
+    QVERIFY(IsSequence(capture.data(), 3000));
+}
+
+void PlaybackTest::IdleIsPlaying()
+{
+    auto device = std::make_shared<NullAudioOutputDevice>();
+    AudioModel model(nullptr);
+    model.set_output_device(device);
+    QSignalSpy finished(&model, &AudioModel::PlaybackFinished);
+    QVERIFY(model.LoadWavFile(wav_path_));
+    QVERIFY(model.StartPlayback());
+    NullAudioOutput *output = device->get_output();
+
+    // 设备无数据可取时为Idle状态，播放完成处理之前仍视为播放中
+    QVERIFY(model.SeekPlayback(kTotalFrames - 10));
+    QCOMPARE(output->Pull(100), 10);
+    QCOMPARE(output->State(), QAudio::IdleState);
+    QVERIFY(model.IsPlaying());
+    QCOMPARE(model.get_playback_position(), kTotalFrames);
+    QTRY_COMPARE(finished.count(), 1);
+    QVERIFY(!model.IsPlaying());
+}
+
+void PlaybackTest::ConvertingPosition()
+{
+    // 设备只支持48kHz立体声浮点，文件经格式转换后输出
+    QAudioFormat output_format;
+    output_format.setSampleRate(48000);
+    output_format.setChannelCount(2);
+    output_format.setSampleFormat(QAudioFormat::Float);
+    auto device = std::make_shared<NullAudioOutputDevice>(QList<QAudioFormat>{ output_format }, output_format);
+    AudioModel model(nullptr);
+    model.set_output_device(device);
+    QVERIFY(model.LoadWavFile(wav_path_));
+    QVERIFY(model.StartPlayback());
+    NullAudioOutput *output = device->get_output();
+    QCOMPARE(output->get_format(), output_format);
+
+    // 输出4800帧（0.1秒）对应文件800帧
+    QCOMPARE(output->Pull(4800), 4800);
+    QCOMPARE(model.get_playback_position(), 800);
+    QVERIFY(model.SeekPlayback(4000));
+    QCOMPARE(model.get_playback_position(), 4000);
+    QCOMPARE(output->Pull(480), 480);
+    QCOMPARE(model.get_playback_position(), 4080);
+    model.PausePlayback();
+    QVERIFY(model.SeekPlayback(6000));
+    model.PausePlayback();
+    QCOMPARE(output->Pull(960), 960);
+    QCOMPARE(model.get_playback_position(), 6160);
+}
@@ -0,0 +1,28 @@
+﻿#pragma once
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QBuffer>
+
+// 文件播放测试：以空音频输出驱动AudioModel，逐帧检查跳转、暂停/继续和播放完成后的位置及输出数据
+class PlaybackTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void PlayToEnd();
+    void PauseResume();
+    void SeekWhilePlaying();
+    void SeekWhilePaused();
+    void IdleIsPlaying();
+    void ConvertingPosition();
+
+private:
+    // 检查捕获的输出是否为从first开始的连续样本
+    static bool IsSequence(const QByteArray &data, qint64 first);
+
+private:
+    QTemporaryDir dir_;
+    QString wav_path_;
+};
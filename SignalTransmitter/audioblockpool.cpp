@@ -0,0 +1,137 @@
+﻿#include "audioblockpool.h"
+#include <chrono>
+
+AudioBlockRef::AudioBlockRef(const AudioBlockRef &other)
+    : block_(other.block_)
+{
+    if (block_) {
+        block_->ref_count.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+AudioBlockRef::AudioBlockRef(AudioBlockRef &&other) noexcept
+    : block_(other.block_)
+{
+    other.block_ = nullptr;
+}
+
+AudioBlockRef &AudioBlockRef::operator=(AudioBlockRef other) noexcept
+{
+    std::swap(block_, other.block_);
+    return *this;
+}
+
+AudioBlockRef::~AudioBlockRef()
+{
+    Release();
+}
+
+void AudioBlockRef::Release()
+{
+    if (!block_) {
+        return;
+    }
+    AudioBlock *block = block_;
+    block_ = nullptr;
+    if (block->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // 先取出对内存池的引用，回收之后内存池才可能被释放
+        const auto owner = std::move(block->owner);
+        owner->Recycle(block);
+    }
+}
+
+char *AudioBlockRef::MutableData()
+{
+    Q_ASSERT(block_ && block_->ref_count.load(std::memory_order_relaxed) == 1);
+    return block_->data;
+}
+
+qsizetype AudioBlockRef::capacity() const
+{
+    return block_->owner->get_block_capacity();
+}
+
+void AudioBlockRef::SetContent(qsizetype size, quint64 sequence, qint64 timestamp_us)
+{
+    Q_ASSERT(block_ && block_->ref_count.load(std::memory_order_relaxed) == 1);
+    block_->size = size;
+    block_->sequence = sequence;
+    block_->timestamp_us = timestamp_us;
+    block_->captured_ns = ClockNs();
+}
+
+qint64 AudioBlockRef::ClockNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+AudioBlock *AudioBlockRef::Detach()
+{
+    AudioBlock *block = block_;
+    block_ = nullptr;
+    return block;
+}
+
+AudioBlockRef AudioBlockRef::Adopt(AudioBlock *block)
+{
+    return AudioBlockRef(block);
+}
+
+std::shared_ptr<AudioBlockPool> AudioBlockPool::Create(int block_count, qsizetype block_capacity)
+{
+    return std::shared_ptr<AudioBlockPool>(new AudioBlockPool(block_count, block_capacity));
+}
+
+AudioBlockPool::AudioBlockPool(int block_count, qsizetype block_capacity)
+    : block_count_(block_count)
+    , block_capacity_(block_capacity)
+    , blocks_(new AudioBlock[block_count])
+{
+    // 所有数据块共用一整块对齐内存
+    slab_ = static_cast<char *>(::operator new[](static_cast<size_t>(block_count_ * block_capacity_), std::align_val_t(kSlabAlignment)));
+    AudioBlock *head{ nullptr };
+    for (int i = 0; i < block_count_; ++i) {
+        blocks_[i].data = slab_ + i * block_capacity_;
+        blocks_[i].next_free = head;
+        head = &blocks_[i];
+    }
+    free_list_.store(head, std::memory_order_relaxed);
+    free_count_.store(block_count_, std::memory_order_relaxed);
+}
+
+AudioBlockPool::~AudioBlockPool()
+{
+    ::operator delete[](slab_, std::align_val_t(kSlabAlignment));
+}
+
+AudioBlockRef AudioBlockPool::Acquire()
+{
+    // 出栈：只有本线程出栈，读到的栈顶在比较交换前不会被回收到别处
+    AudioBlock *block = free_list_.load(std::memory_order_acquire);
+    do {
+        if (!block) {
+            return AudioBlockRef();
+        }
+    } while (!free_list_.compare_exchange_weak(block, block->next_free, std::memory_order_acquire, std::memory_order_acquire));
+    free_count_.fetch_sub(1, std::memory_order_relaxed);
+    block->next_free = nullptr;
+    block->size = 0;
+    block->ref_count.store(1, std::memory_order_relaxed);
+    block->owner = shared_from_this();
+    return AudioBlockRef(block);
+}
+
+void AudioBlockPool::Recycle(AudioBlock *block)
+{
+    // 入栈：可在任意线程中进行
+    AudioBlock *head = free_list_.load(std::memory_order_relaxed);
+    do {
+        block->next_free = head;
+    } while (!free_list_.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+    free_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+int AudioBlockPool::get_free_count() const
+{
+    return free_count_.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,98 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QMetaType>
+#include <atomic>
+#include <memory>
+#include <new>
+
+class AudioBlockPool;
+
+// 音频数据块，内存来自内存池的整块预分配区域
+struct AudioBlock {
+    char *data{ nullptr };
+    qsizetype size{ 0 };
+    quint64 sequence{ 0 };          // 采集序号
+    qint64 timestamp_us{ 0 };       // 块首样本相对录音开始的时间（微秒）
+    qint64 captured_ns{ 0 };        // 从音频设备读出时的单调时钟（纳秒），用于测量延迟
+    std::atomic<int> ref_count{ 0 };
+    std::shared_ptr<AudioBlockPool> owner;  // 借出期间保持内存池存活
+    AudioBlock *next_free{ nullptr };
+};
+
+// 音频数据块引用（引用计数句柄）
+// 发布之后数据只读，录音文件、波形显示和网络发送共享同一块内存；最后一个引用释放时数据块回到内存池
+class AudioBlockRef
+{
+public:
+    AudioBlockRef() = default;
+    AudioBlockRef(const AudioBlockRef &other);
+    AudioBlockRef(AudioBlockRef &&other) noexcept;
+    AudioBlockRef &operator=(AudioBlockRef other) noexcept;
+    ~AudioBlockRef();
+
+    bool IsNull() const { return block_ == nullptr; }
+    const char *data() const { return block_->data; }
+    qsizetype size() const { return block_->size; }
+    quint64 sequence() const { return block_->sequence; }
+    qint64 timestamp_us() const { return block_->timestamp_us; }
+    qint64 captured_ns() const { return block_->captured_ns; }
+    // 不复制数据的QByteArray视图，只在持有本引用期间有效
+    QByteArray ToByteArray() const { return QByteArray::fromRawData(block_->data, block_->size); }
+
+    // 生产者在发布前填写数据（此时只有一个引用）
+    char *MutableData();
+    qsizetype capacity() const;
+    // 同时以ClockNs记录读出时刻
+    void SetContent(qsizetype size, quint64 sequence, qint64 timestamp_us);
+    // captured_ns使用的单调时钟
+    static qint64 ClockNs();
+
+    // 转移引用所有权为裸指针（例如放入无锁队列），再由Adopt接管
+    AudioBlock *Detach();
+    static AudioBlockRef Adopt(AudioBlock *block);
+
+private:
+    explicit AudioBlockRef(AudioBlock *block) : block_(block) {}
+    void Release();
+
+private:
+    AudioBlock *block_{ nullptr };
+
+    friend class AudioBlockPool;
+};
+
+Q_DECLARE_METATYPE(AudioBlockRef)
+
+// 固定大小的音频数据块内存池
+// 构造时一次性分配所有数据块，之后申请和回收只操作无锁空闲栈，稳定运行时没有堆分配也没有锁。
+// 回收可能发生在任意线程（最后一个引用在哪里释放），申请只在一个线程中进行（采集线程）：
+// 单个出栈者时栈顶元素不会被其他线程取走再放回，比较交换不存在ABA问题
+class AudioBlockPool : public std::enable_shared_from_this<AudioBlockPool>
+{
+public:
+    static std::shared_ptr<AudioBlockPool> Create(int block_count, qsizetype block_capacity);
+    ~AudioBlockPool();
+
+    // 内存池耗尽时返回空引用；同一时间只能有一个线程调用
+    AudioBlockRef Acquire();
+    qsizetype get_block_capacity() const { return block_capacity_; }
+    int get_block_count() const { return block_count_; }
+    int get_free_count() const;
+
+    static constexpr size_t kSlabAlignment{ 64 };
+
+private:
+    AudioBlockPool(int block_count, qsizetype block_capacity);
+    void Recycle(AudioBlock *block);
+
+private:
+    const int block_count_;
+    const qsizetype block_capacity_;
+    char *slab_{ nullptr };
+    std::unique_ptr<AudioBlock[]> blocks_;
+    std::atomic<AudioBlock *> free_list_{ nullptr };
+    std::atomic<int> free_count_{ 0 };
+
+    friend class AudioBlockRef;
+};
@@ -0,0 +1,151 @@
+﻿#include "audiocaptureworker.h"
+
+AudioCaptureChannel::AudioCaptureChannel(size_t capacity, QObject *parent)
+    : QObject(parent)
+    , ring_(capacity)
+{}
+
+AudioCaptureChannel::~AudioCaptureChannel()
+{
+    Clear();
+}
+
+bool AudioCaptureChannel::Push(const AudioBlockRef &block)
+{
+    // 复制一份引用放入通道，由消费者Pop时接管
+    AudioBlockRef ref = block;
+    AudioBlock *raw = ref.Detach();
+    if (!ring_.Push(raw)) {
+        AudioBlockRef::Adopt(raw);
+        dropped_blocks_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    has_data_.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void AudioCaptureChannel::Notify()
+{
+    if (has_data_.exchange(false, std::memory_order_relaxed) && !notify_pending_.exchange(true)) {
+        emit DataAvailable();
+    }
+}
+
+AudioBlockRef AudioCaptureChannel::Pop()
+{
+    AudioBlock *raw{ nullptr };
+    if (!ring_.Pop(raw)) {
+        return AudioBlockRef();
+    }
+    return AudioBlockRef::Adopt(raw);
+}
+
+void AudioCaptureChannel::Clear()
+{
+    while (!Pop().IsNull()) {
+    }
+}
+
+void AudioCaptureChannel::set_format(const QAudioFormat &format)
+{
+    std::lock_guard<std::mutex> lock(format_mutex_);
+    format_ = format;
+}
+
+QAudioFormat AudioCaptureChannel::get_format() const
+{
+    std::lock_guard<std::mutex> lock(format_mutex_);
+    return format_;
+}
+
+AudioCaptureWorker::AudioCaptureWorker(const QList<AudioCaptureChannel *> &channels, std::shared_ptr<AudioBlockPool> pool)
+    : QObject(nullptr)
+    , channels_(channels)
+    , pool_(std::move(pool))
+    , discard_buffer_(pool_->get_block_capacity(), Qt::Uninitialized)
+{}
+
+AudioCaptureWorker::~AudioCaptureWorker()
+{
+    Stop();
+}
+
+bool AudioCaptureWorker::Start(const QAudioDevice &device, const QAudioFormat &format)
+{
+    Stop();
+    if (format.bytesPerFrame() <= 0 || format.bytesPerFrame() > pool_->get_block_capacity()) {
+        return false;
+    }
+    overrun_count_ = 0;
+    dropped_bytes_ = 0;
+    format_ = format;
+    // 每块只读整数帧（如24位立体声每帧6字节），帧不会跨数据块
+    read_size_ = pool_->get_block_capacity() / format.bytesPerFrame() * format.bytesPerFrame();
+    for (auto *channel : std::as_const(channels_)) {
+        channel->set_format(format);
+    }
+    next_sequence_ = 0;
+    captured_bytes_ = 0;
+    // 音频源在采集线程中创建，其通知也在采集线程的事件循环中处理
+    audio_source_ = new QAudioSource(device, format, this);
+    audio_io_ = audio_source_->start();
+    if (!audio_io_) {
+        delete audio_source_;
+        audio_source_ = nullptr;
+        return false;
+    }
+    connect(audio_io_, &QIODevice::readyRead, this, &AudioCaptureWorker::SlotReadyRead);
+    return true;
+}
+
+void AudioCaptureWorker::Stop()
+{
+    if (audio_source_) {
+        // 停止前取走设备中剩余的数据
+        SlotReadyRead();
+        audio_source_->stop();
+        delete audio_source_;
+        audio_source_ = nullptr;
+    }
+    audio_io_ = nullptr;
+}
+
+void AudioCaptureWorker::SlotReadyRead()
+{
+    if (!audio_io_) {
+        return;
+    }
+    while (true) {
+        auto block = pool_->Acquire();
+        if (block.IsNull()) {
+            // 内存池耗尽（消费者持有的数据块过多），丢弃设备数据并计数
+            const qint64 n = audio_io_->read(discard_buffer_.data(), read_size_);
+            if (n <= 0) {
+                break;
+            }
+            overrun_count_.fetch_add(1, std::memory_order_relaxed);
+            dropped_bytes_.fetch_add(n, std::memory_order_relaxed);
+            captured_bytes_ += n;
+            continue;
+        }
+        // 设备数据直接读入数据块，之后不再复制
+        const qint64 n = audio_io_->read(block.MutableData(), read_size_);
+        if (n <= 0) {
+            break;
+        }
+        // 时间戳按已采集的帧数计算，与样本严格对应
+        const qint64 timestamp_us = captured_bytes_ / format_.bytesPerFrame() * 1000000 / format_.sampleRate();
+        block.SetContent(n, next_sequence_++, timestamp_us);
+        captured_bytes_ += n;
+        // 录音通道满时录音丢失数据，计为溢出；其他消费者跟不上时只丢弃它自己的数据
+        for (int i = 0; i < channels_.size(); ++i) {
+            if (!channels_[i]->Push(block) && i == 0) {
+                overrun_count_.fetch_add(1, std::memory_order_relaxed);
+                dropped_bytes_.fetch_add(n, std::memory_order_relaxed);
+            }
+        }
+    }
+    for (auto *channel : std::as_const(channels_)) {
+        channel->Notify();
+    }
+}
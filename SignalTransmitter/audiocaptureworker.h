@@ -0,0 +1,87 @@
+﻿#pragma once
+
+#include <QObject>
+#include <QAudioDevice>
+#include <QAudioFormat>
+#include <QAudioSource>
+#include <atomic>
+#include <mutex>
+#include "spscringbuffer.h"
+#include "audioblockpool.h"
+
+// 采集数据的一个消费者通道：独立的无锁环形缓冲区和合并通知
+// 采集线程向每个通道放入同一数据块的引用，消费者在自己的线程中按自己的节奏读取（连接DataAvailable），
+// 某个消费者变慢时只有它自己的通道溢出，不影响其他消费者
+class AudioCaptureChannel : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AudioCaptureChannel(size_t capacity, QObject *parent = nullptr);
+    ~AudioCaptureChannel();
+
+    // 采集线程调用：通道已满时返回false，数据块不放入
+    bool Push(const AudioBlockRef &block);
+    // 采集线程调用：有新数据且消费者已确认上次通知时发出DataAvailable
+    void Notify();
+    // 消费者调用：先确认通知再读取，读取期间到达的数据会触发下一次通知
+    void AcknowledgeData() { notify_pending_.store(false); }
+    AudioBlockRef Pop();
+    // 丢弃剩余数据，仅在采集停止后调用
+    void Clear();
+
+    // 采集格式在开始采集时设置，消费者读取数据块后查询
+    void set_format(const QAudioFormat &format);
+    QAudioFormat get_format() const;
+    qint64 get_dropped_blocks() const { return dropped_blocks_.load(std::memory_order_relaxed); }
+
+private:
+    SpscRingBuffer<AudioBlock *> ring_;
+    std::atomic<bool> has_data_{ false };
+    std::atomic<bool> notify_pending_{ false };
+    std::atomic<qint64> dropped_blocks_{ 0 };
+    mutable std::mutex format_mutex_;
+    QAudioFormat format_;
+
+signals:
+    // 通道中有新数据（在采集线程中发出，按消费者所在线程排队处理）
+    void DataAvailable();
+};
+
+// 音频采集工作对象，运行在独立的采集线程中
+// readyRead只做一件事：把设备数据直接读入内存池的数据块，再把数据块的引用放入各消费者通道，
+// 消费者（录音文件写入线程、网络线程、界面）各自读取，界面卡顿不会影响录音和实时音频流
+class AudioCaptureWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    // channels[0]为录音通道，它溢出时计为采集溢出；通道在采集线程启动前确定，之后不再改变
+    AudioCaptureWorker(const QList<AudioCaptureChannel *> &channels, std::shared_ptr<AudioBlockPool> pool);
+    ~AudioCaptureWorker();
+
+    // 以下两个函数须在采集线程中调用
+    bool Start(const QAudioDevice &device, const QAudioFormat &format);
+    void Stop();
+
+    qint64 get_overrun_count() const { return overrun_count_.load(std::memory_order_relaxed); }
+    qint64 get_dropped_bytes() const { return dropped_bytes_.load(std::memory_order_relaxed); }
+
+private slots:
+    void SlotReadyRead();
+
+private:
+    QList<AudioCaptureChannel *> channels_;
+    std::shared_ptr<AudioBlockPool> pool_;
+    QAudioSource *audio_source_{ nullptr };
+    QIODevice *audio_io_{ nullptr };
+    QAudioFormat format_;
+    qint64 read_size_{ 0 };                 // 每块读取的字节数：块容量向下取整到整帧
+    quint64 next_sequence_{ 0 };
+    qint64 captured_bytes_{ 0 };
+    // 内存池耗尽时用于丢弃设备数据
+    QByteArray discard_buffer_;
+    // 内存池耗尽或录音通道满而丢弃数据的次数和字节数
+    std::atomic<qint64> overrun_count_{ 0 };
+    std::atomic<qint64> dropped_bytes_{ 0 };
+};
@@ -0,0 +1,356 @@
+﻿#include "audioconverter.h"
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define CONVERTER_USE_SSE
+#endif
+
+namespace {
+
+constexpr int kHistory{ AudioConverter::kTapsPerPhase - 1 };
+
+// 第一类零阶修正贝塞尔函数
+double BesselI0(double x)
+{
+    double sum{ 1.0 }, term{ 1.0 };
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// 长度为kTapsPerPhase的点积
+inline float DotProduct(const float *a, const float *b)
+{
+#ifdef CONVERTER_USE_SSE
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (int i = 0; i < AudioConverter::kTapsPerPhase; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    acc0 = _mm_add_ps(acc0, acc1);
+    acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+    acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1));
+    return _mm_cvtss_f32(acc0);
+#else
+    float sum{ 0.0f };
+    for (int i = 0; i < AudioConverter::kTapsPerPhase; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+#endif
+}
+
+// 折叠到立体声时各声道位置在左右声道中的权重
+struct StereoWeight {
+    float left;
+    float right;
+};
+
+StereoWeight StereoWeightFor(QAudioFormat::AudioChannelPosition position)
+{
+    constexpr float kSide{ 0.70710678f };   // -3 dB
+    constexpr float kLfe{ 0.5f };           // -6 dB
+    switch (position) {
+    case QAudioFormat::FrontLeft:
+    case QAudioFormat::FrontLeftOfCenter:
+        return { 1.0f, 0.0f };
+    case QAudioFormat::FrontRight:
+    case QAudioFormat::FrontRightOfCenter:
+        return { 0.0f, 1.0f };
+    case QAudioFormat::FrontCenter:
+        return { kSide, kSide };
+    case QAudioFormat::LFE:
+    case QAudioFormat::LFE2:
+        return { kLfe, kLfe };
+    case QAudioFormat::BackLeft:
+    case QAudioFormat::SideLeft:
+    case QAudioFormat::TopFrontLeft:
+    case QAudioFormat::TopBackLeft:
+    case QAudioFormat::TopSideLeft:
+    case QAudioFormat::BottomFrontLeft:
+        return { kSide, 0.0f };
+    case QAudioFormat::BackRight:
+    case QAudioFormat::SideRight:
+    case QAudioFormat::TopFrontRight:
+    case QAudioFormat::TopBackRight:
+    case QAudioFormat::TopSideRight:
+    case QAudioFormat::BottomFrontRight:
+        return { 0.0f, kSide };
+    default:
+        // 后中置、顶部中置等以及未知位置平均分配到左右声道
+        return { 0.5f, 0.5f };
+    }
+}
+
+}
+
+bool AudioConverter::Configure(const QAudioFormat &input_format, const QAudioFormat &output_format, int max_input_frames)
+{
+    if (!input_format.isValid() || !output_format.isValid() || max_input_frames <= 0) {
+        return false;
+    }
+    input_format_ = input_format;
+    output_format_ = output_format;
+    max_input_frames_ = max_input_frames;
+    channels_ = qMin(input_format.channelCount(), output_format.channelCount());
+    // 约分得到上下采样倍数，相位数过多时以kMaxPhases近似
+    const int g = std::gcd(input_format.sampleRate(), output_format.sampleRate());
+    interpolation_ = output_format.sampleRate() / g;
+    decimation_ = input_format.sampleRate() / g;
+    if (interpolation_ > kMaxPhases) {
+        decimation_ = qMax(1, qRound(double(decimation_) * kMaxPhases / interpolation_));
+        interpolation_ = kMaxPhases;
+    }
+    DesignFilter();
+    DesignDownmix();
+    history_stride_ = kHistory + max_input_frames_;
+    history_.assign(static_cast<size_t>(history_stride_) * channels_, 0.0f);
+    resampled_.assign(static_cast<size_t>(MaxOutputFrames(max_input_frames_)) * channels_, 0.0f);
+    Reset();
+    return true;
+}
+
+void AudioConverter::Reset()
+{
+    std::fill(history_.begin(), history_.end(), 0.0f);
+    input_index_ = kHistory;
+    phase_ = 0;
+}
+
+int AudioConverter::MaxOutputFrames(int input_frames) const
+{
+    return static_cast<int>((qint64(input_frames) * interpolation_ + decimation_ - 1) / decimation_) + 1;
+}
+
+void AudioConverter::DesignFilter()
+{
+    coefficients_.clear();
+    if (interpolation_ == 1 && decimation_ == 1) {
+        return;
+    }
+    // 原型低通滤波器工作在上采样后的速率，截止频率取两个奈奎斯特频率中较低者并留出过渡带
+    const int length = interpolation_ * kTapsPerPhase;
+    const double cutoff = 0.5 / qMax(interpolation_, decimation_) * 0.9;
+    const double beta{ 8.0 };
+    const double center = (length - 1) / 2.0;
+    const double i0_beta = BesselI0(beta);
+    std::vector<double> prototype(length);
+    for (int k = 0; k < length; ++k) {
+        const double x = k - center;
+        const double sinc = x == 0.0 ? 1.0 : std::sin(2.0 * M_PI * cutoff * x) / (2.0 * M_PI * cutoff * x);
+        const double r = x / center;
+        const double window = BesselI0(beta * std::sqrt(qMax(0.0, 1.0 - r * r))) / i0_beta;
+        // 乘以L补偿插零造成的幅度损失
+        prototype[k] = 2.0 * cutoff * sinc * window * interpolation_;
+    }
+    // 拆分为L个相位，每个相位反序存放，便于与按时间顺序排列的输入做点积
+    coefficients_.resize(length);
+    for (int p = 0; p < interpolation_; ++p) {
+        for (int j = 0; j < kTapsPerPhase; ++j) {
+            coefficients_[p * kTapsPerPhase + (kTapsPerPhase - 1 - j)] = static_cast<float>(prototype[p + j * interpolation_]);
+        }
+    }
+}
+
+void AudioConverter::DesignDownmix()
+{
+    downmix_.clear();
+    const int in_channels = input_format_.channelCount();
+    if (in_channels <= channels_) {
+        frame_.clear();
+        return;
+    }
+    frame_.assign(in_channels, 0.0f);
+    downmix_.assign(static_cast<size_t>(channels_) * in_channels, 0.0f);
+    // 未指定声道布局时按WAV文件的标准声道顺序（FL FR FC LFE BL BR ...）
+    auto config = input_format_.channelConfig();
+    if (config == QAudioFormat::ChannelConfigUnknown) {
+        config = QAudioFormat::defaultChannelConfigForChannelCount(in_channels);
+    }
+    QAudioFormat layout;
+    layout.setChannelConfig(config);
+    const bool stereo = channels_ == 2 && layout.channelCount() == in_channels
+        && layout.channelOffset(QAudioFormat::FrontLeft) >= 0 && layout.channelOffset(QAudioFormat::FrontRight) >= 0;
+    if (stereo) {
+        for (int p = QAudioFormat::FrontLeft; p <= QAudioFormat::BottomFrontRight; ++p) {
+            const auto position = static_cast<QAudioFormat::AudioChannelPosition>(p);
+            const int c = layout.channelOffset(position);
+            if (c < 0) {
+                continue;
+            }
+            const StereoWeight weight = StereoWeightFor(position);
+            downmix_[c] = weight.left;
+            downmix_[in_channels + c] = weight.right;
+        }
+    } else {
+        // 前channels_个声道一一对应，多出的声道平均后加到每个输出声道（单声道即所有声道的平均）
+        const float extra = 1.0f / (in_channels - channels_);
+        for (int o = 0; o < channels_; ++o) {
+            float *row = downmix_.data() + static_cast<size_t>(o) * in_channels;
+            row[o] = 1.0f;
+            for (int c = channels_; c < in_channels; ++c) {
+                row[c] = channels_ == 1 ? 1.0f : extra;
+            }
+        }
+    }
+    // 每行权重之和归一化为1，全部声道满幅时也不会削波
+    for (int o = 0; o < channels_; ++o) {
+        float *row = downmix_.data() + static_cast<size_t>(o) * in_channels;
+        const float sum = std::accumulate(row, row + in_channels, 0.0f);
+        if (sum > 1.0f) {
+            for (int c = 0; c < in_channels; ++c) {
+                row[c] /= sum;
+            }
+        }
+    }
+}
+
+int AudioConverter::Process(const char *input, int input_frames, char *output)
+{
+    input_frames = qMin(input_frames, max_input_frames_);
+    if (input_frames <= 0) {
+        return 0;
+    }
+    int output_frames{ 0 };
+    if (coefficients_.empty()) {
+        // 采样率相同，只转换格式和声道
+        Decode(input, input_frames, 0);
+        for (int i = 0; i < input_frames; ++i) {
+            for (int c = 0; c < channels_; ++c) {
+                resampled_[i * channels_ + c] = history_[c * history_stride_ + i];
+            }
+        }
+        output_frames = input_frames;
+    } else {
+        Decode(input, input_frames, kHistory);
+        Resample(input_frames, output_frames);
+    }
+    Encode(resampled_.data(), output_frames, output);
+    return output_frames;
+}
+
+void AudioConverter::Decode(const char *input, int frames, int offset)
+{
+    const int in_channels = input_format_.channelCount();
+    const int sample_bytes = input_format_.bytesPerSample();
+    const auto sample_format = input_format_.sampleFormat();
+    auto read_sample = [&](const char *p) -> float {
+        switch (sample_format) {
+        case QAudioFormat::UInt8:
+            return (static_cast<int>(*reinterpret_cast<const quint8 *>(p)) - 128) * (1.0f / 128.0f);
+        case QAudioFormat::Int16: {
+            qint16 v;
+            memcpy(&v, p, sizeof(v));
+            return v * (1.0f / 32768.0f);
+        }
+        case QAudioFormat::Int32: {
+            qint32 v;
+            memcpy(&v, p, sizeof(v));
+            return static_cast<float>(v * (1.0 / 2147483648.0));
+        }
+        case QAudioFormat::Float: {
+            float v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+        default:
+            return 0.0f;
+        }
+    };
+    for (int i = 0; i < frames; ++i) {
+        const char *frame = input + static_cast<qsizetype>(i) * in_channels * sample_bytes;
+        if (!downmix_.empty()) {
+            // 声道数减少：按混音矩阵混合
+            for (int c = 0; c < in_channels; ++c) {
+                frame_[c] = read_sample(frame + c * sample_bytes);
+            }
+            for (int o = 0; o < channels_; ++o) {
+                const float *row = downmix_.data() + static_cast<size_t>(o) * in_channels;
+                float sum{ 0.0f };
+                for (int c = 0; c < in_channels; ++c) {
+                    sum += row[c] * frame_[c];
+                }
+                history_[o * history_stride_ + offset + i] = sum;
+            }
+        } else {
+            for (int c = 0; c < channels_; ++c) {
+                history_[c * history_stride_ + offset + i] = read_sample(frame + c * sample_bytes);
+            }
+        }
+    }
+}
+
+void AudioConverter::Resample(int input_frames, int &output_frames)
+{
+    const int available = kHistory + input_frames;
+    int index = input_index_;
+    int phase = phase_;
+    int n{ 0 };
+    while (index < available) {
+        const float *coef = coefficients_.data() + static_cast<size_t>(phase) * kTapsPerPhase;
+        for (int c = 0; c < channels_; ++c) {
+            resampled_[n * channels_ + c] = DotProduct(coef, history_.data() + c * history_stride_ + index - kHistory);
+        }
+        ++n;
+        phase += decimation_;
+        index += phase / interpolation_;
+        phase %= interpolation_;
+    }
+    // 保留最后kHistory个输入样本作为下一块的历史
+    for (int c = 0; c < channels_; ++c) {
+        float *channel = history_.data() + c * history_stride_;
+        memmove(channel, channel + input_frames, kHistory * sizeof(float));
+    }
+    input_index_ = index - input_frames;
+    phase_ = phase;
+    output_frames = n;
+}
+
+void AudioConverter::Encode(const float *samples, int frames, char *output) const
+{
+    const int out_channels = output_format_.channelCount();
+    const int sample_bytes = output_format_.bytesPerSample();
+    const auto sample_format = output_format_.sampleFormat();
+    for (int i = 0; i < frames; ++i) {
+        char *frame = output + static_cast<qsizetype>(i) * out_channels * sample_bytes;
+        for (int c = 0; c < out_channels; ++c) {
+            // 单声道复制到所有输出声道，其余多出的输出声道静音
+            float v{ 0.0f };
+            if (channels_ == 1) {
+                v = samples[i];
+            } else if (c < channels_) {
+                v = samples[i * channels_ + c];
+            }
+            v = qBound(-1.0f, v, 1.0f);
+            char *p = frame + c * sample_bytes;
+            switch (sample_format) {
+            case QAudioFormat::UInt8:
+                *reinterpret_cast<quint8 *>(p) = static_cast<quint8>(std::lrint(v * 127.0f) + 128);
+                break;
+            case QAudioFormat::Int16: {
+                const qint16 s = static_cast<qint16>(std::lrint(v * 32767.0f));
+                memcpy(p, &s, sizeof(s));
+                break;
+            }
+            case QAudioFormat::Int32: {
+                const qint32 s = static_cast<qint32>(std::llrint(v * 2147483647.0));
+                memcpy(p, &s, sizeof(s));
+                break;
+            }
+            case QAudioFormat::Float:
+                memcpy(p, &v, sizeof(v));
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
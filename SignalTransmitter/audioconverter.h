@@ -0,0 +1,58 @@
+﻿#pragma once
+
+#include <QAudioFormat>
+#include <vector>
+
+// 流式音频格式转换：样本格式（UInt8/Int16/Int32/Float）、声道混合和任意有理数比例的采样率转换
+// 声道减少时按混音矩阵混合：多声道到立体声把中置、LFE和环绕声道折叠到左右声道，其余情况平均多出的声道；
+// 声道增加时单声道复制到所有输出声道，其余多出的输出声道静音
+// 采样率转换使用多相FIR滤波器（Kaiser窗sinc原型），点积在x64下使用SSE；
+// 所有缓冲区在Configure时按最大块长一次分配，Process过程中没有堆分配
+class AudioConverter
+{
+public:
+    AudioConverter() = default;
+
+    bool Configure(const QAudioFormat &input_format, const QAudioFormat &output_format, int max_input_frames);
+    // 清空滤波器历史（跳转后调用）
+    void Reset();
+    // 转换一块数据，返回输出帧数；输入帧数不能超过max_input_frames
+    int Process(const char *input, int input_frames, char *output);
+    // 输入指定帧数时最多输出的帧数
+    int MaxOutputFrames(int input_frames) const;
+
+    const QAudioFormat &get_input_format() const { return input_format_; }
+    const QAudioFormat &get_output_format() const { return output_format_; }
+    int get_interpolation() const { return interpolation_; }
+    int get_decimation() const { return decimation_; }
+
+    static constexpr int kTapsPerPhase{ 32 };       // 每个相位的滤波器阶数（4的倍数）
+    static constexpr int kMaxPhases{ 1024 };        // 相位数上限，超过时近似比例
+
+private:
+    void Decode(const char *input, int frames, int offset);
+    void Resample(int input_frames, int &output_frames);
+    void Encode(const float *samples, int frames, char *output) const;
+    void DesignFilter();
+    void DesignDownmix();
+
+private:
+    QAudioFormat input_format_;
+    QAudioFormat output_format_;
+    int max_input_frames_{ 0 };
+    int channels_{ 0 };                 // 参与重采样的声道数（输入输出声道数较小者）
+    // 混音矩阵：channels_行、输入声道数列，声道数不减少时为空
+    std::vector<float> downmix_;
+    std::vector<float> frame_;          // 一帧输入样本
+    int interpolation_{ 1 };            // 上采样倍数L
+    int decimation_{ 1 };               // 下采样倍数M
+    // 多相系数：相位p的kTapsPerPhase个系数连续存放并反序，与输入样本顺序一致
+    std::vector<float> coefficients_;
+    // 各声道输入样本（平面格式），前kTapsPerPhase-1个为上一块保留的历史
+    std::vector<float> history_;
+    int history_stride_{ 0 };
+    // 交错格式的重采样结果
+    std::vector<float> resampled_;
+    int input_index_{ 0 };              // 下一个输出样本对应的输入位置
+    int phase_{ 0 };                    // 下一个输出样本对应的相位
+};
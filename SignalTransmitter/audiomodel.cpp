@@ -1,9 +1,23 @@
 ﻿#include "audiomodel.h"
-#include "audiowaveformview.h"
+#include "losslesscodec.h"
+#include <QDir>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QStandardPaths>
 
 AudioModel::AudioModel(QObject *parent)
     : QObject(parent)
+    , block_pool_(AudioBlockPool::Create(kCaptureBlockCount, kCaptureBlockSize))
+    , record_channel_(new AudioCaptureChannel(kRecordChannelCapacity, this))
+    , view_channel_(new AudioCaptureChannel(kViewChannelCapacity, this))
+    , stream_channel_(new AudioCaptureChannel(kStreamChannelCapacity, this))
+    , capture_thread_(new QThread(this))
+    , capture_worker_(new AudioCaptureWorker({ record_channel_, view_channel_, stream_channel_ }, block_pool_))
+    , record_thread_(new QThread(this))
+    , record_worker_(new AudioRecordWorker(record_channel_))
     , duration_timer_(new QTimer(this))
+    , output_device_(std::make_shared<SystemAudioOutputDevice>())
+    , playback_device_(new MappedAudioDevice(this))
     , playback_timer_(new QTimer(this))
 {
     // 设置默认音频格式
@@ -15,11 +29,39 @@ AudioModel::AudioModel(QObject *parent)
     // 设置计时器
     connect(duration_timer_, &QTimer::timeout, this, &AudioModel::SlotDurationUpdate);
     connect(playback_timer_, &QTimer::timeout, this, &AudioModel::SlotPlaybackUpdate);
+    // 启动采集线程，采集对象随线程结束释放
+    capture_worker_->moveToThread(capture_thread_);
+    connect(capture_thread_, &QThread::finished, capture_worker_, &QObject::deleteLater);
+    connect(view_channel_, &AudioCaptureChannel::DataAvailable, this, &AudioModel::SlotDrainCapture);
+    capture_thread_->start(QThread::TimeCriticalPriority);
+    // 启动录音文件写入线程
+    record_worker_->moveToThread(record_thread_);
+    connect(record_thread_, &QThread::finished, record_worker_, &QObject::deleteLater);
+    connect(record_channel_, &AudioCaptureChannel::DataAvailable, record_worker_, &AudioRecordWorker::SlotDrain);
+    record_thread_->start(QThread::HighPriority);
 }
 
 AudioModel::~AudioModel()
 {
     StopRecording();
+    capture_thread_->quit();
+    capture_thread_->wait();
+    record_thread_->quit();
+    record_thread_->wait();
+    // 未保存的临时录音文件随程序退出删除
+    if (!recording_file_path_.isEmpty()) {
+        QFile::remove(recording_file_path_);
+    }
+    ReleaseRecordingFile();
+    if (audio_output_) {
+        audio_output_->Stop();
+    }
+    StopLivePlayback();
+    playback_device_->close();
+    if (!temp_playback_file_path_.isEmpty()) {
+        QFile::remove(temp_playback_file_path_);
+    }
+    RemoveDecodedFile();
 }
 
 QStringList AudioModel::AvaiableAudioDevices() const
@@ -71,215 +113,422 @@ bool AudioModel::SetAudioSettings(const QString &device, const QString &format,
 
 bool AudioModel::StartRecording()
 {
-    if (audio_source_) {
-        delete audio_source_;
-        audio_source_ = nullptr;
+    StopRecording();
+    recording_duration_ = 0;
+    // 新建临时录音文件，替换上一次未保存的录音；上一次的录音正在传输时推迟到传输结束后删除
+    if (!recording_file_path_.isEmpty()) {
+        if (recording_file_retained_) {
+            retained_recording_files_.append(recording_file_path_);
+        } else {
+            QFile::remove(recording_file_path_);
+        }
     }
-    audio_source_ = new QAudioSource(current_device_, audio_format_, this);
-    if (!audio_source_) {
+    recording_file_path_ = QDir(QStandardPaths::writableLocation(QStandardPaths::TempLocation))
+        .filePath(QString("SignalTransmitter_%1.wav").arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss_zzz")));
+    bool opened{ false };
+    QMetaObject::invokeMethod(record_worker_, [this, &opened]() {
+        opened = record_worker_->Open(recording_file_path_, audio_format_);
+    }, Qt::BlockingQueuedConnection);
+    if (!opened) {
+        recording_file_path_.clear();
         return false;
     }
-    recorded_data_.clear();
-    temp_buffer_.clear();
-    recording_duration_ = 0;
-    // 开始录音
-    audio_io_ = audio_source_->start();
-    if (!audio_io_) {
-        delete audio_source_;
-        audio_source_ = nullptr;
+    // 开始录音：在采集线程中创建并启动音频源
+    view_channel_->Clear();
+    bool started{ false };
+    QMetaObject::invokeMethod(capture_worker_, [this, &started]() {
+        started = capture_worker_->Start(current_device_, audio_format_);
+    }, Qt::BlockingQueuedConnection);
+    if (!started) {
+        CloseRecorder();
         return false;
     }
-    connect(audio_io_, &QIODevice::readyRead, [this]() {
-        if (audio_io_) {
-            const QByteArray new_data = audio_io_->readAll();
-            if (!new_data.isEmpty()) {
-                // 保存到录音数据
-                recorded_data_.append(new_data);
-                // 添加到实时显示缓冲区
-                temp_buffer_.append(new_data);
-                // 检查是否有足够数据进行实时显示
-                const int bytes_per_sample = audio_format_.bytesPerSample();
-                const int frame_size = bytes_per_sample * audio_format_.channelCount();
-                const int target_samples = audio_format_.sampleRate() * AudioWaveformView::kDisplayDuration;
-                const int target_bytes = target_samples * frame_size;
-                if (temp_buffer_.size() >= target_bytes) {
-                    // 发射实时数据信号
-                    emit AudioDataReady(temp_buffer_, audio_format_);
-                    // 清空缓冲区
-                    temp_buffer_.clear();
-                }
-            }
-        }
-    });
+    is_recording_ = true;
     // 启动定时器
     duration_timer_->start(1000);
     return true;
 }
 
+void AudioModel::ReleaseRecordingFile()
+{
+    recording_file_retained_ = false;
+    for (const auto &file_path : std::as_const(retained_recording_files_)) {
+        QFile::remove(file_path);
+    }
+    retained_recording_files_.clear();
+}
+
+void AudioModel::SlotDrainCapture()
+{
+    if (!is_recording_) {
+        return;
+    }
+    // 先确认通知再读取，读取期间到达的数据会触发下一次通知。
+    // 之前的循环可能已读走这些数据，通知到达时通道为空是正常情况，不表示丢失音频
+    view_channel_->AcknowledgeData();
+    for (auto block = view_channel_->Pop(); !block.IsNull(); block = view_channel_->Pop()) {
+        // 分发给实时显示，由各自决定是否持有；录音文件和网络发送在各自的线程中读取自己的通道
+        emit AudioBlockReady(block, audio_format_);
+    }
+}
+
+bool AudioModel::CloseRecorder()
+{
+    bool ok{ false };
+    QMetaObject::invokeMethod(record_worker_, [this, &ok]() {
+        ok = record_worker_->Close();
+    }, Qt::BlockingQueuedConnection);
+    return ok;
+}
+
 void AudioModel::StopRecording()
 {
     // 停止计时器
     duration_timer_->stop();
     // 停止录音
-    if (audio_source_) {
-        audio_source_->stop();
-        delete audio_source_;
-        audio_source_ = nullptr;
-    }
-    audio_io_ = nullptr;
-    // 清空临时缓冲区
-    temp_buffer_.clear();
+    if (is_recording_) {
+        QMetaObject::invokeMethod(capture_worker_, [this]() {
+            capture_worker_->Stop();
+        }, Qt::BlockingQueuedConnection);
+        // 取走环形缓冲区中剩余的数据
+        SlotDrainCapture();
+        is_recording_ = false;
+    }
+    // 写出剩余数据并完成文件头
+    CloseRecorder();
 }
 
-bool AudioModel::SaveRecordedWavFile(const QString &file_path) const
+bool AudioModel::SaveRecordedWavFile(const QString &recording_path, const QString &file_path)
 {
-    QFile file(file_path);
-    if (!file.open(QIODevice::WriteOnly)) {
+    if (recording_path.isEmpty()) {
+        return false;
+    }
+    // 录音已完整写入临时文件，保存为WAV时直接复制，保存为.stfl时无损压缩
+    if (file_path.endsWith(".stfl", Qt::CaseInsensitive)) {
+        return LosslessCodec::EncodeWavFile(recording_path, file_path);
+    }
+    QFile input(recording_path);
+    QSaveFile output(file_path);
+    if (!input.open(QIODevice::ReadOnly) || !output.open(QIODevice::WriteOnly)) {
         return false;
     }
-    // 写入 WAV 头部信息
-    WriteWavHeader(file);
-    // 写入录音数据
-    const auto bytes_written = file.write(recorded_data_);
-    file.close();
+    constexpr qint64 kCopyChunk{ 1 << 20 };
+    while (!input.atEnd()) {
+        const QByteArray chunk = input.read(kCopyChunk);
+        if (chunk.isEmpty() || output.write(chunk) != chunk.size()) {
+            return false;
+        }
+    }
+    return output.commit();
+}
 
-    return bytes_written == recorded_data_.size();
+QString AudioModel::NewDecodedFilePath()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::TempLocation))
+        .filePath(QString("SignalTransmitter_decoded_%1.wav").arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss_zzz")));
 }
 
-void AudioModel::WriteWavHeader(QFile &file) const
+bool AudioModel::LoadDecodedFile(const QString &wav_path)
 {
-    // WAV 文件头部信息
-    struct WavHeader {
-        char riff[4] = {'R', 'I', 'F', 'F'}; // "RIFF"
-        uint32_t file_size; // 文件大小 - 8
-        char wave[4] = {'W', 'A', 'V', 'E'}; // "WAVE"
-        char fmt[4] = {'f', 'm', 't', ' '}; // "fmt "
-        uint32_t fmt_size = 16; // fmt chunk size
-        uint16_t audio_format = 1; // 1: PCM format 3: float format
-        uint16_t num_channels; // 声道数
-        uint32_t sample_rate; // 采样率
-        uint32_t byte_rate; // 每秒字节数
-        uint16_t block_align; // 块对齐
-        uint16_t bits_per_sample; // 每个样本的位数
-        char data[4] = {'d', 'a', 't', 'a'}; // "data"
-        uint32_t data_size; // 数据大小
-    };
+    const QString previous = decoded_file_path_;
+    decoded_file_path_ = wav_path;
+    const bool ok = LoadWavFile(wav_path);
+    // 新文件已打开，上一个解码文件不再被映射
+    if (!previous.isEmpty() && previous != wav_path) {
+        QFile::remove(previous);
+    }
+    return ok;
+}
 
-    WavHeader header;
-    header.num_channels = audio_format_.channelCount();
-    header.sample_rate = audio_format_.sampleRate();
-    header.bits_per_sample = audio_format_.bytesPerSample() * 8;
-    header.byte_rate = header.sample_rate * header.num_channels * (header.bits_per_sample / 8);
-    header.block_align = header.num_channels * (header.bits_per_sample / 8);
-    header.data_size = recorded_data_.size();
-    header.file_size = sizeof(WavHeader) - 8 + header.data_size;
-    // 根据Qt音频格式设置WAV格式字段
-    switch (audio_format_.sampleFormat()) {
-    case QAudioFormat::Int16:
-        header.audio_format = 1; // PCM
-        break;
-    case QAudioFormat::Float:
-        header.audio_format = 3; // IEEE float
-        break;
-    default:
-        header.audio_format = 1; // 默认PCM
-        break;
-    }
-    file.write(reinterpret_cast<const char *>(&header), sizeof(WavHeader));
+void AudioModel::RemoveDecodedFile()
+{
+    if (!decoded_file_path_.isEmpty()) {
+        QFile::remove(decoded_file_path_);
+        decoded_file_path_.clear();
+    }
 }
 
 bool AudioModel::LoadWavFile(const QString &file_path)
 {
-    QFile file(file_path);
-    if (!file.open(QIODevice::ReadOnly)) {
+    StopPlayback();
+    // 映射文件并逐块解析头部，音频数据不复制
+    const bool opened = playback_device_->Open(file_path);
+    // 加载了其他文件，之前的解码文件已解除映射
+    if (decoded_file_path_ != file_path) {
+        RemoveDecodedFile();
+    }
+    if (!opened) {
         return false;
     }
-    // WAV文件头解析
-    struct WavHeader {
-        char riff[4];
-        uint32_t file_size;
-        char wave[4];
-        char fmt[4];
-        uint32_t fmt_size;
-        uint16_t audio_format;
-        uint16_t num_channels;
-        uint32_t sample_rate;
-        uint32_t byte_rate;
-        uint16_t block_align;
-        uint16_t bits_per_sample;
-        char data[4];
-        uint32_t data_size;
-    };
-    WavHeader header;
-    // 读取WAV头部信息，检查返回读取的字节数是否正确
-    if (file.read(reinterpret_cast<char *>(&header), sizeof(WavHeader)) != sizeof(WavHeader)) {
+    // 设置播放格式
+    playback_format_ = playback_device_->get_audio_format();
+    playback_start_frame_ = 0;
+
+    return true;
+}
+
+bool AudioModel::LoadGeneratedSignal(const QList<double> &signal, int sample_rate)
+{
+    if (signal.isEmpty() || sample_rate <= 0) {
         return false;
     }
-    // 验证WAV格式
-    if (strncmp(header.riff, "RIFF", 4) != 0 || strncmp(header.wave, "WAVE", 4) != 0) {
+    // 先解除对上一个临时文件的映射再覆盖写入
+    StopPlayback();
+    playback_device_->close();
+    QAudioFormat format;
+    format.setSampleRate(sample_rate);
+    format.setChannelCount(1);
+    format.setSampleFormat(QAudioFormat::Float);
+    WavStreamWriter writer;
+    if (!writer.Open(TempPlaybackFilePath(), format)) {
         return false;
     }
-    // 设置播放格式
-    playback_format_.setChannelCount(header.num_channels);
-    playback_format_.setSampleRate(header.sample_rate);
-    playback_format_.setSampleFormat(header.bits_per_sample == 16 ? QAudioFormat::Int16 : QAudioFormat::Float);
-    // 读取音频数据
-    playback_data_ = file.read(header.data_size);
-    // 计算总时长（秒）
-    const int bytes_per_second = header.sample_rate * header.num_channels * (header.bits_per_sample / 8);
-    playback_total_duration_ = playback_data_.size() / bytes_per_second;
+    // 分块转换为32位浮点写入
+    constexpr qsizetype kBlockSamples{ 4096 };
+    float block[kBlockSamples];
+    for (qsizetype i = 0; i < signal.size(); i += kBlockSamples) {
+        const qsizetype n = qMin(kBlockSamples, signal.size() - i);
+        for (qsizetype j = 0; j < n; ++j) {
+            block[j] = static_cast<float>(signal[i + j]);
+        }
+        if (!writer.Write(reinterpret_cast<const char *>(block), n * sizeof(float))) {
+            return false;
+        }
+    }
+    if (!writer.Close()) {
+        return false;
+    }
+    return LoadWavFile(temp_playback_file_path_);
+}
 
-    return !playback_data_.isEmpty();
+const QString &AudioModel::TempPlaybackFilePath()
+{
+    if (temp_playback_file_path_.isEmpty()) {
+        temp_playback_file_path_ = QDir(QStandardPaths::writableLocation(QStandardPaths::TempLocation)).filePath("SignalTransmitter_playback.wav");
+    }
+    return temp_playback_file_path_;
 }
 
 bool AudioModel::StartPlayback()
 {
-    if (playback_data_.isEmpty()) {
+    if (!playback_device_->isOpen()) {
         return false;
     }
-    // 获取默认音频输出设备
-    const auto output_device = QMediaDevices::defaultAudioOutput();
-    if (!output_device.isFormatSupported(playback_format_)) {
-        return false;
+    delete audio_output_;
+    audio_output_ = nullptr;
+    delete converting_device_;
+    converting_device_ = nullptr;
+    auto sink_format = playback_format_;
+    if (!output_device_->IsFormatSupported(playback_format_)) {
+        // 设备不支持文件的格式（如1600Hz的调制信号），转换为设备首选格式
+        sink_format = output_device_->PreferredFormat();
+        converting_device_ = new ConvertingAudioDevice(playback_device_, this);
+        if (!converting_device_->Configure(playback_format_, sink_format)
+            || !converting_device_->open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+            delete converting_device_;
+            converting_device_ = nullptr;
+            return false;
+        }
+    }
+    // 创建音频输出，缓冲越小延迟越低，但更容易因调度不及时而断音
+    audio_output_ = output_device_->CreateOutput(sink_format, this);
+    if (playback_buffer_duration_ > 0) {
+        audio_output_->SetBufferSize(sink_format.bytesForDuration(qint64(playback_buffer_duration_) * 1000));
     }
-    // 创建音频输出
-    audio_sink_ = new QAudioSink(output_device, playback_format_, this);
-    // 创建播放缓冲区
-    playback_buffer_ = new QBuffer(&playback_data_, this);
-    playback_buffer_->open(QIODevice::ReadOnly);
-    // 开始播放
-    audio_sink_->start(playback_buffer_);
-    // 启动进度定时器
-    playback_current_position_ = 0;
-    playback_timer_->start(1000); // 每秒更新一次进度
+    // 排队处理，避免在音频输出的信号中释放它
+    connect(audio_output_, &AudioOutput::StateChanged, this, &AudioModel::SlotPlaybackStateChanged, Qt::QueuedConnection);
+    playback_paused_ = false;
+    // 拉模式：音频设备按需从映射文件读取，从上次跳转的位置开始播放
+    StartOutputAt(playback_start_frame_);
+    playback_timer_->start(kPlaybackUpdateInterval);
 
     return true;
 }
 
+void AudioModel::StartOutputAt(qint64 frame)
+{
+    playback_start_frame_ = frame;
+    playback_fed_bytes_ = frame * playback_format_.bytesPerFrame();
+    output_pending_ = false;
+    playback_device_->seek(playback_fed_bytes_);
+    if (converting_device_) {
+        converting_device_->Reset();
+        audio_output_->Start(converting_device_);
+    } else {
+        audio_output_->Start(playback_device_);
+    }
+}
+
 void AudioModel::StopPlayback()
 {
     playback_timer_->stop();
-    if (audio_sink_) {
-        audio_sink_->stop();
-        delete audio_sink_;
-        audio_sink_ = nullptr;
-    }
-    if (playback_buffer_) {
-        playback_buffer_->close();
-        delete playback_buffer_;
-        playback_buffer_ = nullptr;
-    }
-    playback_current_position_ = 0;
-    emit PlaybackPositionChanged(0, playback_total_duration_);
+    if (audio_output_) {
+        audio_output_->Stop();
+        delete audio_output_;
+        audio_output_ = nullptr;
+    }
+    delete converting_device_;
+    converting_device_ = nullptr;
+    playback_paused_ = false;
+    output_pending_ = false;
+    playback_start_frame_ = 0;
+    emit PlaybackPositionChanged(0, get_playback_total_frames());
+}
+
+bool AudioModel::StartLivePlayback(const QAudioFormat &format)
+{
+    StopLivePlayback();
+    const auto output_device = QMediaDevices::defaultAudioOutput();
+    auto sink_format = format;
+    live_converting_ = !output_device.isFormatSupported(format);
+    if (live_converting_) {
+        sink_format = output_device.preferredFormat();
+        if (!live_converter_.Configure(format, sink_format, kLiveBlockFrames)) {
+            return false;
+        }
+        live_output_.resize(static_cast<qsizetype>(live_converter_.MaxOutputFrames(kLiveBlockFrames)) * sink_format.bytesPerFrame());
+    }
+    live_sink_ = new QAudioSink(output_device, sink_format, this);
+    live_sink_->setBufferSize(sink_format.bytesForDuration(kLiveBufferDuration));
+    // 推模式：数据到达时写入音频设备
+    live_device_ = live_sink_->start();
+    if (!live_device_) {
+        delete live_sink_;
+        live_sink_ = nullptr;
+        return false;
+    }
+    live_format_ = format;
+    return true;
+}
+
+void AudioModel::PlayLiveAudio(const QByteArray &data, const QAudioFormat &format)
+{
+    if (!live_sink_ || format != live_format_) {
+        if (!StartLivePlayback(format)) {
+            return;
+        }
+    }
+    // 只处理完整的帧，剩余部分与下一次的数据拼接
+    live_pending_ += data;
+    const int bytes_per_frame = live_format_.bytesPerFrame();
+    const qint64 frames = live_pending_.size() / bytes_per_frame;
+    const char *input = live_pending_.constData();
+    const int output_bytes_per_frame = live_sink_->format().bytesPerFrame();
+    for (qint64 done = 0; done < frames;) {
+        const int n = static_cast<int>(qMin<qint64>(frames - done, kLiveBlockFrames));
+        const char *block = input + done * bytes_per_frame;
+        qint64 size = qint64(n) * bytes_per_frame;
+        if (live_converting_) {
+            size = qint64(live_converter_.Process(block, n, live_output_.data())) * output_bytes_per_frame;
+            block = live_output_.constData();
+        }
+        // 输出缓冲已满时丢弃整帧，不等待音频设备
+        const qint64 free = live_sink_->bytesFree() / output_bytes_per_frame * output_bytes_per_frame;
+        const qint64 written = qMax<qint64>(0, live_device_->write(block, qMin(size, free)));
+        live_dropped_bytes_ += size - written;
+        done += n;
+    }
+    live_pending_.remove(0, frames * bytes_per_frame);
+}
+
+void AudioModel::StopLivePlayback()
+{
+    if (live_sink_) {
+        live_sink_->stop();
+        delete live_sink_;
+        live_sink_ = nullptr;
+    }
+    live_device_ = nullptr;
+    live_format_ = QAudioFormat();
+    live_pending_.clear();
 }
 
 void AudioModel::PausePlayback()
 {
-    if (audio_sink_->state() == QAudio::ActiveState) {
-        audio_sink_->suspend();
+    if (!audio_output_) {
+        return;
+    }
+    if (playback_paused_) {
+        playback_paused_ = false;
+        if (output_pending_) {
+            // 暂停期间跳转过，从新位置启动输出
+            StartOutputAt(playback_start_frame_);
+        } else {
+            audio_output_->Resume();
+        }
+        playback_timer_->start(kPlaybackUpdateInterval);
+    } else {
+        playback_paused_ = true;
+        audio_output_->Suspend();
         playback_timer_->stop();
-    } else if (audio_sink_->state() == QAudio::SuspendedState) {
-        audio_sink_->resume();
-        playback_timer_->start(1000);
+        // 暂停时更新一次进度，显示实际停止的位置
+        emit PlaybackPositionChanged(get_playback_position(), get_playback_total_frames());
+    }
+}
+
+bool AudioModel::SeekPlayback(qint64 frame)
+{
+    if (!playback_device_->isOpen()) {
+        return false;
+    }
+    frame = qBound<qint64>(0, frame, get_playback_total_frames());
+    if (audio_output_ && !playback_paused_) {
+        // 重新启动音频输出，丢弃设备缓冲中的旧数据，已输出帧数从零计
+        audio_output_->Stop();
+        StartOutputAt(frame);
+    } else if (audio_output_) {
+        // 暂停时停止输出并只记录位置：先启动再挂起会让设备在挂起前播出一小段
+        audio_output_->Stop();
+        playback_start_frame_ = frame;
+        playback_fed_bytes_ = frame * playback_format_.bytesPerFrame();
+        output_pending_ = true;
+    } else {
+        // 未播放时记录起始位置，下次开始播放时生效
+        playback_start_frame_ = frame;
+    }
+    emit PlaybackPositionChanged(frame, get_playback_total_frames());
+    return true;
+}
+
+qint64 AudioModel::get_playback_position() const
+{
+    if (!audio_output_ || output_pending_) {
+        return playback_start_frame_;
+    }
+    // 音频设备已输出的帧数，格式转换时按采样率换算为文件帧，不超过已从文件读出的帧数
+    qint64 processed = audio_output_->ProcessedFrames();
+    const qint64 output_rate = audio_output_->get_format().sampleRate();
+    const qint64 file_rate = playback_format_.sampleRate();
+    if (output_rate != file_rate && output_rate > 0) {
+        processed = (processed * file_rate + output_rate / 2) / output_rate;
+    }
+    const qint64 played = playback_start_frame_ + processed;
+    const qint64 consumed = playback_device_->pos() / playback_format_.bytesPerFrame();
+    return qMin(played, consumed);
+}
+
+void AudioModel::SlotPlaybackUpdate()
+{
+    if (!audio_output_) {
+        return;
+    }
+    const qint64 position = get_playback_position();
+    emit PlaybackPositionChanged(position, get_playback_total_frames());
+    // 发出上次更新以来已播放的数据
+    const qint64 played_bytes = position * playback_format_.bytesPerFrame();
+    if (played_bytes <= playback_fed_bytes_) {
+        return;
+    }
+    emit PlaybackDataReady(playback_device_->PeekAt(playback_fed_bytes_, played_bytes - playback_fed_bytes_), playback_format_);
+    playback_fed_bytes_ = played_bytes;
+}
+
+void AudioModel::SlotPlaybackStateChanged(QAudio::State state)
+{
+    Q_UNUSED(state);
+    // 排队到达时音频输出可能已被替换，以当前状态为准；数据读完且设备空闲即播放完成
+    if (audio_output_ && audio_output_->State() == QAudio::IdleState && playback_device_->atEnd()) {
+        StopPlayback();
+        emit PlaybackFinished();
     }
 }
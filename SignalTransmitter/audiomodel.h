@@ -8,7 +8,17 @@
 #include <QTimer>
 #include <QFile>
 #include <QAudioSink>
-#include <QBuffer>
+#include <QThread>
+#include "wavstreamwriter.h"
+#include "spscringbuffer.h"
+#include "audiocaptureworker.h"
+#include "audiorecordworker.h"
+#include "audioblockpool.h"
+#include "mappedaudiodevice.h"
+#include "convertingaudiodevice.h"
+#include "audioconverter.h"
+#include "audiooutput.h"
+#include <memory>
 
 class AudioModel  : public QObject
 {
@@ -23,65 +33,153 @@ public:
     bool SetAudioSettings(const QString &device, const QString &format, const QString &sample_rate, const QString &channel);
     bool StartRecording();
     void StopRecording();
-    bool SaveRecordedWavFile(const QString &file_path) const;
-    // 播放
+    bool IsRecording() const { return is_recording_; }
+    // 保存录音文件recording_path，扩展名为.stfl时保存为无损压缩格式；
+    // 先写入临时文件再替换目标文件，失败时原文件不变。耗时较长，可在工作线程中调用
+    static bool SaveRecordedWavFile(const QString &recording_path, const QString &file_path);
+    // 播放WAV文件
     bool LoadWavFile(const QString &file_path);
+    // .stfl无损压缩文件：先在工作线程中解码到NewDecodedFilePath()，再加载解码结果；
+    // 解码文件归模型所有，加载其他文件或退出时删除
+    static QString NewDecodedFilePath();
+    bool LoadDecodedFile(const QString &wav_path);
+    // 将生成的信号（如调制信号）写入临时WAV文件并加载播放，采样率由播放时的格式转换适配设备
+    bool LoadGeneratedSignal(const QList<double> &signal, int sample_rate);
     bool StartPlayback();
     void StopPlayback();
     void PausePlayback();
-    bool IsPlaying() const { return audio_sink_ && audio_sink_->state() == QAudio::ActiveState; }
+    // 跳转到指定帧，播放中和暂停时均可调用（拖动进度条时连续调用即为擦洗）
+    bool SeekPlayback(qint64 frame);
+    // 已开始播放且未暂停；音频设备暂时无数据（IdleState）仍视为播放中，播放完成后为false
+    bool IsPlaying() const { return audio_output_ && !playback_paused_; }
+    // 文件播放使用的音频输出设备，默认为系统默认输出；下次开始播放时生效
+    void set_output_device(std::shared_ptr<AudioOutputDevice> device) { output_device_ = std::move(device); }
+    // 音频设备缓冲时长（毫秒），0表示使用系统默认值；下次开始播放时生效
+    void set_playback_buffer_duration(int milliseconds) { playback_buffer_duration_ = milliseconds; }
+    // 实时播放（如客户端上传的音频）：推模式输出，与文件播放互不影响；
+    // 格式变化时重建音频输出，输出缓冲已满时丢弃数据而不阻塞调用者
+    void PlayLiveAudio(const QByteArray &data, const QAudioFormat &format);
+    void StopLivePlayback();
+    qint64 get_live_dropped_bytes() const { return live_dropped_bytes_; }
     // 获取私有变量值
-    const QByteArray &get_recorded_data() const { return recorded_data_; }
-    int get_playback_total_duration() const { return playback_total_duration_; }
+    qint64 get_recorded_bytes() const { return record_worker_->get_data_bytes(); }
+    const QString &get_recording_file_path() const { return recording_file_path_; }
+    // 传输录音文件期间保留该文件：其间开始的新录音写入新文件，旧文件在释放后才删除
+    void RetainRecordingFile() { recording_file_retained_ = true; }
+    void ReleaseRecordingFile();
+    qint64 get_recording_data_offset() const { return WavStreamWriter::kHeaderSize; }
+    const QAudioFormat &get_audio_format() const { return audio_format_; }
+    // 采集溢出次数：环形缓冲区满而丢弃数据
+    qint64 get_capture_overrun_count() const { return capture_worker_->get_overrun_count(); }
+    qint64 get_capture_dropped_bytes() const { return capture_worker_->get_dropped_bytes(); }
+    // 实时音频流通道：在网络线程中连接DataAvailable并读取，数据块不经过界面线程
+    AudioCaptureChannel *get_stream_channel() const { return stream_channel_; }
+    // 播放位置和总长度以帧为单位
+    qint64 get_playback_total_frames() const { return playback_device_->get_wav_info().get_frame_count(); }
+    qint64 get_playback_position() const;
+    int get_playback_sample_rate() const { return playback_format_.sampleRate(); }
+    // 实际播放的WAV文件（.stfl文件为解码后的临时文件）
+    QString get_playback_file_path() const { return playback_device_->get_file_path(); }
+
+public:
+    static constexpr int kCaptureBlockCount{ 1024 };        // 采集数据块数量
+    // 各消费者通道的容量（数据块数），合计小于kCaptureBlockCount，通道积压不会耗尽内存池
+    static constexpr size_t kRecordChannelCapacity{ 512 };
+    static constexpr size_t kViewChannelCapacity{ 128 };
+    static constexpr size_t kStreamChannelCapacity{ 128 };
+    static constexpr qsizetype kCaptureBlockSize{ 4096 };   // 采集数据块大小（字节）
+    static constexpr int kLiveBlockFrames{ 4096 };          // 实时播放每次转换的最大帧数
+    static constexpr qint64 kLiveBufferDuration{ 300000 };  // 实时播放的输出缓冲时长（微秒）
+    static constexpr int kPlaybackUpdateInterval{ 50 };     // 播放进度更新间隔（毫秒），与波形显示时长一致
 
 private:
-    void WriteWavHeader(QFile &file) const;
+    // 在写入线程中写出剩余录音数据并关闭文件
+    bool CloseRecorder();
+    // 从指定帧开始向音频设备输出
+    void StartOutputAt(qint64 frame);
+    bool StartLivePlayback(const QAudioFormat &format);
+    const QString &TempPlaybackFilePath();
+    void RemoveDecodedFile();
 
 private:
     // 录音设备和格式设置
     QAudioDevice current_device_;
     QAudioFormat audio_format_;
-    // 进行录音相关
-    QAudioSource *audio_source_{ nullptr };
-    QIODevice *audio_io_{ nullptr };
-    QByteArray recorded_data_;
+    // 进行录音相关：采集在独立线程中进行，数据块经各消费者的通道分发：
+    // 录音文件在写入线程中写入，实时音频流由网络线程读取，界面线程只读取显示通道
+    std::shared_ptr<AudioBlockPool> block_pool_;
+    AudioCaptureChannel *record_channel_;
+    AudioCaptureChannel *view_channel_;
+    AudioCaptureChannel *stream_channel_;
+    QThread *capture_thread_;
+    AudioCaptureWorker *capture_worker_;
+    bool is_recording_{ false };
+    // 录音数据边采集边写入临时WAV文件，内存占用与录音时长无关
+    QThread *record_thread_;
+    AudioRecordWorker *record_worker_;
+    QString recording_file_path_;
+    bool recording_file_retained_{ false };
+    QStringList retained_recording_files_;  // 保留期间被新录音替换的文件
     QTimer *duration_timer_;
     int recording_duration_{ 0 };
-    // 实时显示相关
-    QByteArray temp_buffer_;
     // 播放相关
-    QAudioSink *audio_sink_{ nullptr };
-    QBuffer *playback_buffer_{ nullptr };
-    QByteArray playback_data_;
+    std::shared_ptr<AudioOutputDevice> output_device_;
+    AudioOutput *audio_output_{ nullptr };
+    // 暂停时跳转只记录位置，恢复播放时才从新位置启动输出
+    bool playback_paused_{ false };
+    bool output_pending_{ false };
+    // 播放数据直接来自内存映射的WAV文件
+    MappedAudioDevice *playback_device_;
     QAudioFormat playback_format_;
+    // 音频输出设备不支持文件格式时，经格式转换后输出
+    ConvertingAudioDevice *converting_device_{ nullptr };
+    // 生成信号的临时播放文件
+    QString temp_playback_file_path_;
+    // 当前加载的.stfl解码文件
+    QString decoded_file_path_;
+    int playback_buffer_duration_{ 0 };
+    // 播放位置 = 本次启动音频输出时的起始帧 + 音频设备已输出的帧数（换算为文件帧）
+    qint64 playback_start_frame_{ 0 };
+    // 定时更新播放进度和实时数据（频谱显示）
     QTimer *playback_timer_;
-    int playback_total_duration_{ 0 };
-    int playback_current_position_{ 0 };
+    qint64 playback_fed_bytes_{ 0 };
+    // 实时播放
+    QAudioSink *live_sink_{ nullptr };
+    QIODevice *live_device_{ nullptr };
+    QAudioFormat live_format_;              // 输入数据的格式
+    bool live_converting_{ false };
+    AudioConverter live_converter_;
+    QByteArray live_pending_;               // 不足一帧的剩余数据
+    QByteArray live_output_;                // 转换输出缓冲
+    qint64 live_dropped_bytes_{ 0 };
 
 private slots:
     // 录音波形更新
     void SlotDurationUpdate() {
         recording_duration_++;
+        // 每秒写出缓冲数据并回填文件头，异常退出时最多丢失一秒录音
+        QMetaObject::invokeMethod(record_worker_, [this]() { record_worker_->Flush(); });
         emit RecordingDurationChanged(recording_duration_);
+        emit CaptureStatsChanged(get_capture_overrun_count());
     }
-    // 播放进度更新
-    void SlotPlaybackUpdate() {
-        playback_current_position_++;
-        emit PlaybackPositionChanged(playback_current_position_, playback_total_duration_);
-        // 检查是否播放完成
-        if (playback_current_position_ >= playback_total_duration_) {
-            StopPlayback();
-            emit PlaybackFinished();
-        }
-    }
+    // 从显示通道读取数据
+    void SlotDrainCapture();
+    // 播放进度和实时数据更新
+    void SlotPlaybackUpdate();
+    // 音频输出状态变化（检测播放完成）
+    void SlotPlaybackStateChanged(QAudio::State state);
 
 signals:
     // 录音时长更新信号
     void RecordingDurationChanged(int seconds);
-    // 录音波形数据更新信号
-    void AudioDataReady(const QByteArray &data, const QAudioFormat &format);
+    // 采集溢出计数更新信号
+    void CaptureStatsChanged(qint64 overrun_count);
+    // 录音数据块信号（界面线程）：显示类消费者共享同一数据块，不复制样本
+    void AudioBlockReady(const AudioBlockRef &block, const QAudioFormat &format);
+    // 播放实时数据信号（已送入音频设备的数据）
+    void PlaybackDataReady(const QByteArray &data, const QAudioFormat &format);
     // 播放进度更新信号
-    void PlaybackPositionChanged(int current_seconds, int total_seconds);
+    void PlaybackPositionChanged(qint64 position_frames, qint64 total_frames);
     // 播放完成信号
     void PlaybackFinished();
 };
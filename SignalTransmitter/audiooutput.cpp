@@ -0,0 +1,101 @@
+﻿#include "audiooutput.h"
+#include <QMediaDevices>
+
+SinkAudioOutput::SinkAudioOutput(const QAudioDevice &device, const QAudioFormat &format, QObject *parent)
+    : AudioOutput(format, parent)
+    , sink_(new QAudioSink(device, format, this))
+{
+    connect(sink_, &QAudioSink::stateChanged, this, &AudioOutput::StateChanged);
+}
+
+bool SystemAudioOutputDevice::IsFormatSupported(const QAudioFormat &format) const
+{
+    return QMediaDevices::defaultAudioOutput().isFormatSupported(format);
+}
+
+QAudioFormat SystemAudioOutputDevice::PreferredFormat() const
+{
+    return QMediaDevices::defaultAudioOutput().preferredFormat();
+}
+
+AudioOutput *SystemAudioOutputDevice::CreateOutput(const QAudioFormat &format, QObject *parent)
+{
+    return new SinkAudioOutput(QMediaDevices::defaultAudioOutput(), format, parent);
+}
+
+NullAudioOutput::NullAudioOutput(const QAudioFormat &format, QIODevice *capture, QObject *parent)
+    : AudioOutput(format, parent)
+    , capture_(capture)
+{
+}
+
+void NullAudioOutput::Start(QIODevice *device)
+{
+    device_ = device;
+    processed_frames_ = 0;
+    SetState(QAudio::ActiveState);
+}
+
+void NullAudioOutput::Stop()
+{
+    device_ = nullptr;
+    SetState(QAudio::StoppedState);
+}
+
+void NullAudioOutput::Suspend()
+{
+    if (state_ == QAudio::ActiveState || state_ == QAudio::IdleState) {
+        SetState(QAudio::SuspendedState);
+    }
+}
+
+void NullAudioOutput::Resume()
+{
+    if (state_ == QAudio::SuspendedState) {
+        SetState(QAudio::ActiveState);
+    }
+}
+
+qint64 NullAudioOutput::Pull(qint64 frames)
+{
+    if (!device_ || (state_ != QAudio::ActiveState && state_ != QAudio::IdleState) || frames <= 0) {
+        return 0;
+    }
+    const int bytes_per_frame = format_.bytesPerFrame();
+    const qint64 size = frames * bytes_per_frame;
+    buffer_.resize(size);
+    const qint64 read = qMax<qint64>(0, device_->read(buffer_.data(), size));
+    const qint64 read_frames = read / bytes_per_frame;
+    if (capture_ && read_frames > 0) {
+        capture_->write(buffer_.constData(), read_frames * bytes_per_frame);
+    }
+    processed_frames_ += read_frames;
+    SetState(read_frames < frames ? QAudio::IdleState : QAudio::ActiveState);
+    return read_frames;
+}
+
+void NullAudioOutput::SetState(QAudio::State state)
+{
+    if (state_ != state) {
+        state_ = state;
+        emit StateChanged(state);
+    }
+}
+
+NullAudioOutputDevice::NullAudioOutputDevice(const QList<QAudioFormat> &supported_formats, const QAudioFormat &preferred_format)
+    : supported_formats_(supported_formats)
+    , preferred_format_(preferred_format)
+{
+}
+
+bool NullAudioOutputDevice::IsFormatSupported(const QAudioFormat &format) const
+{
+    return supported_formats_.isEmpty() || supported_formats_.contains(format);
+}
+
+AudioOutput *NullAudioOutputDevice::CreateOutput(const QAudioFormat &format, QObject *parent)
+{
+    auto *output = new NullAudioOutput(format, capture_, parent);
+    output_ = output;
+    return output;
+}
@@ -0,0 +1,130 @@
+﻿#pragma once
+
+#include <QObject>
+#include <QIODevice>
+#include <QAudio>
+#include <QAudioFormat>
+#include <QAudioDevice>
+#include <QAudioSink>
+#include <QPointer>
+#include <QList>
+
+// 文件播放使用的音频输出（拉模式）：音频设备按需从数据设备读取
+// 状态与QAudioSink一致：Active/Idle（无数据可读）/Suspended/Stopped
+class AudioOutput : public QObject
+{
+    Q_OBJECT
+
+public:
+    AudioOutput(const QAudioFormat &format, QObject *parent = nullptr) : QObject(parent), format_(format) {}
+
+    const QAudioFormat &get_format() const { return format_; }
+    virtual void Start(QIODevice *device) = 0;
+    virtual void Stop() = 0;
+    virtual void Suspend() = 0;
+    virtual void Resume() = 0;
+    virtual QAudio::State State() const = 0;
+    // 本次Start以来已输出的帧数（输出格式）
+    virtual qint64 ProcessedFrames() const = 0;
+    // 设备缓冲大小（字节），Start前设置
+    virtual void SetBufferSize(qint64 bytes) { Q_UNUSED(bytes); }
+
+signals:
+    void StateChanged(QAudio::State state);
+
+protected:
+    QAudioFormat format_;
+};
+
+// 创建音频输出的设备
+class AudioOutputDevice
+{
+public:
+    virtual ~AudioOutputDevice() = default;
+
+    virtual bool IsFormatSupported(const QAudioFormat &format) const = 0;
+    virtual QAudioFormat PreferredFormat() const = 0;
+    virtual AudioOutput *CreateOutput(const QAudioFormat &format, QObject *parent) = 0;
+};
+
+// 系统音频输出：封装QAudioSink
+class SinkAudioOutput : public AudioOutput
+{
+    Q_OBJECT
+
+public:
+    SinkAudioOutput(const QAudioDevice &device, const QAudioFormat &format, QObject *parent = nullptr);
+
+    void Start(QIODevice *device) override { sink_->start(device); }
+    void Stop() override { sink_->stop(); }
+    void Suspend() override { sink_->suspend(); }
+    void Resume() override { sink_->resume(); }
+    QAudio::State State() const override { return sink_->state(); }
+    // 由已处理时长换算，精度受音频后端的计时粒度限制
+    qint64 ProcessedFrames() const override { return format_.framesForDuration(sink_->processedUSecs()); }
+    void SetBufferSize(qint64 bytes) override { sink_->setBufferSize(bytes); }
+
+private:
+    QAudioSink *sink_;
+};
+
+// 系统默认音频输出设备，每次创建输出时查询当前默认设备
+class SystemAudioOutputDevice : public AudioOutputDevice
+{
+public:
+    bool IsFormatSupported(const QAudioFormat &format) const override;
+    QAudioFormat PreferredFormat() const override;
+    AudioOutput *CreateOutput(const QAudioFormat &format, QObject *parent) override;
+};
+
+// 空音频输出：不发声，由调用者调用Pull模拟声卡取数据，已输出帧数精确到帧
+// 可将取出的数据写入捕获设备（如文件），用于测试或无声卡环境
+class NullAudioOutput : public AudioOutput
+{
+    Q_OBJECT
+
+public:
+    NullAudioOutput(const QAudioFormat &format, QIODevice *capture = nullptr, QObject *parent = nullptr);
+
+    void Start(QIODevice *device) override;
+    void Stop() override;
+    void Suspend() override;
+    void Resume() override;
+    QAudio::State State() const override { return state_; }
+    qint64 ProcessedFrames() const override { return processed_frames_; }
+
+    // 取出最多frames帧，返回实际取出的帧数；未启动或暂停时不取数据，数据不足时进入Idle状态
+    qint64 Pull(qint64 frames);
+
+private:
+    void SetState(QAudio::State state);
+
+private:
+    QIODevice *device_{ nullptr };
+    QIODevice *capture_;
+    QAudio::State state_{ QAudio::StoppedState };
+    qint64 processed_frames_{ 0 };
+    QByteArray buffer_;
+};
+
+// 空音频输出设备：supported_formats为空时支持任意格式
+class NullAudioOutputDevice : public AudioOutputDevice
+{
+public:
+    NullAudioOutputDevice(const QList<QAudioFormat> &supported_formats = {}, const QAudioFormat &preferred_format = {});
+
+    bool IsFormatSupported(const QAudioFormat &format) const override;
+    QAudioFormat PreferredFormat() const override { return preferred_format_; }
+    AudioOutput *CreateOutput(const QAudioFormat &format, QObject *parent) override;
+
+    // 之后创建的输出把取出的数据写入capture
+    void set_capture(QIODevice *capture) { capture_ = capture; }
+    // 最近创建的输出，已释放时为空
+    NullAudioOutput *get_output() const { return output_; }
+
+private:
+    QList<QAudioFormat> supported_formats_;
+    QAudioFormat preferred_format_;
+    QIODevice *capture_{ nullptr };
+    QPointer<NullAudioOutput> output_;
+};
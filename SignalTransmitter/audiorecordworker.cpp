@@ -0,0 +1,53 @@
+﻿#include "audiorecordworker.h"
+
+AudioRecordWorker::AudioRecordWorker(AudioCaptureChannel *channel)
+    : QObject(nullptr)
+    , channel_(channel)
+{}
+
+AudioRecordWorker::~AudioRecordWorker()
+{
+    writer_.Close();
+}
+
+bool AudioRecordWorker::Open(const QString &file_path, const QAudioFormat &format)
+{
+    writer_.Close();
+    // 丢弃上一次录音停止后残留的数据
+    channel_->Clear();
+    data_bytes_ = 0;
+    failed_ = false;
+    if (!writer_.Open(file_path, format)) {
+        return false;
+    }
+    is_open_ = true;
+    return true;
+}
+
+bool AudioRecordWorker::Close()
+{
+    if (!writer_.IsOpen()) {
+        return !failed_;
+    }
+    SlotDrain();
+    is_open_ = false;
+    if (!writer_.Close()) {
+        failed_ = true;
+    }
+    return !failed_;
+}
+
+void AudioRecordWorker::SlotDrain()
+{
+    channel_->AcknowledgeData();
+    for (auto block = channel_->Pop(); !block.IsNull(); block = channel_->Pop()) {
+        if (!writer_.IsOpen()) {
+            continue;
+        }
+        if (!writer_.Write(block.data(), block.size())) {
+            failed_ = true;
+            continue;
+        }
+        data_bytes_.store(writer_.get_data_bytes(), std::memory_order_relaxed);
+    }
+}
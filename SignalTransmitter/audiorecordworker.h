@@ -0,0 +1,40 @@
+﻿#pragma once
+
+#include <QObject>
+#include <QAudioFormat>
+#include <atomic>
+#include "audiocaptureworker.h"
+#include "wavstreamwriter.h"
+
+// 录音文件写入工作对象，运行在独立的写入线程中
+// 从录音通道读取数据块写入WAV文件；磁盘变慢只会让录音通道积压，不影响界面和实时音频流，界面卡顿也不会拖慢写入
+class AudioRecordWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AudioRecordWorker(AudioCaptureChannel *channel);
+    ~AudioRecordWorker();
+
+    // 以下三个函数须在写入线程中调用
+    bool Open(const QString &file_path, const QAudioFormat &format);
+    // 写出通道中剩余的数据后关闭，须在采集停止后调用
+    bool Close();
+    void Flush() { writer_.Flush(); }
+
+    // 任意线程可查询
+    bool IsOpen() const { return is_open_.load(std::memory_order_acquire); }
+    qint64 get_data_bytes() const { return data_bytes_.load(std::memory_order_relaxed); }
+    bool HasFailed() const { return failed_.load(std::memory_order_relaxed); }
+
+public slots:
+    // 连接录音通道的DataAvailable
+    void SlotDrain();
+
+private:
+    AudioCaptureChannel *channel_;
+    WavStreamWriter writer_;
+    std::atomic<bool> is_open_{ false };
+    std::atomic<qint64> data_bytes_{ 0 };
+    std::atomic<bool> failed_{ false };
+};
@@ -48,50 +48,45 @@ void AudioWaveformView::InitChart()
     setRenderHint(QPainter::Antialiasing);
 }
 
-void AudioWaveformView::UpdateWaveform(const QByteArray &audio_data, const QAudioFormat &format)
+void AudioWaveformView::UpdateWaveform(const AudioBlockRef &block, const QAudioFormat &format)
 {
-    if (!is_displaying_ || audio_data.isEmpty()) {
+    if (!is_displaying_ || block.IsNull() || block.size() == 0) {
         return;
     }
     current_format_ = format;
-    // 转换音频数据为显示数据
-    const auto new_samples = ConvertToDisplayData(audio_data, format);
-    if (new_samples.isEmpty()) {
-        return;
-    }
-    // 添加新样本到缓冲区
-    for (const auto &sample : new_samples) {
-        sample_buffer_.append(sample);
-    }
+    // 直接从共享数据块转换为显示数据，添加到缓冲区
+    AppendDisplayData(block.data(), block.size(), format);
     // 保持固定的显示点数，移除多余的旧数据
     while (sample_buffer_.size() > kMaxDisplayPoints) {
         sample_buffer_.removeFirst();
     }
     // 更新显示
-    UpdateDisplay();
+    if (!refresh_timer_.isValid() || refresh_timer_.elapsed() >= kDisplayDuration * 1000) {
+        UpdateDisplay();
+        refresh_timer_.start();
+    }
 }
 
-QList<double> AudioWaveformView::ConvertToDisplayData(const QByteArray &pcm_data, const QAudioFormat &format)
+void AudioWaveformView::AppendDisplayData(const char *pcm_data, qsizetype size, const QAudioFormat &format)
 {
-    QList<double> samples;
     const int bytes_per_sample = format.bytesPerSample();
     const int channel_count = format.channelCount();
     const int frame_size = bytes_per_sample * channel_count;
     // 只处理单声道或取立体声的左声道
-    for (int i = 0; i < pcm_data.size(); i += frame_size) {
-        if (i + bytes_per_sample > pcm_data.size()) {
+    for (qsizetype i = 0; i < size; i += frame_size) {
+        if (i + bytes_per_sample > size) {
             break;
         }
         double sample_value = 0.0;
         // 根据采样格式进行转换（仅支持当前AudioModel中的两种格式）
         switch (format.sampleFormat()) {
         case QAudioFormat::Int16: {
-            const qint16 *data_ptr = reinterpret_cast<const qint16*>(pcm_data.constData() + i);
+            const qint16 *data_ptr = reinterpret_cast<const qint16*>(pcm_data + i);
             sample_value = static_cast<double>(*data_ptr) / 32768.0; // 归一化到 [-1, 1]
             break;
         }
         case QAudioFormat::Float: {
-            const float *data_ptr = reinterpret_cast<const float*>(pcm_data.constData() + i);
+            const float *data_ptr = reinterpret_cast<const float*>(pcm_data + i);
             sample_value = static_cast<double>(*data_ptr); // float格式已经是 [-1, 1]
             break;
         }
@@ -99,9 +94,8 @@ QList<double> AudioWaveformView::ConvertToDisplayData(const QByteArray &pcm_data
             sample_value = 0.0;
             break;
         }
-        samples.append(sample_value);
+        sample_buffer_.append(sample_value);
     }
-    return samples;
 }
 
 void AudioWaveformView::UpdateDisplay()
@@ -138,6 +132,7 @@ void AudioWaveformView::StopDisplay()
 void AudioWaveformView::ClearDisplay()
 {
     sample_buffer_.clear();
+    refresh_timer_.invalidate();
     waveform_series_->clear();
     axis_x_->setRange(0, kDisplayDuration);
 }
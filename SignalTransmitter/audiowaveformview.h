@@ -4,6 +4,8 @@
 #include <QLineSeries>
 #include <QValueAxis>
 #include <QAudioFormat>
+#include <QElapsedTimer>
+#include "audioblockpool.h"
 
 class AudioWaveformView  : public QChartView
 {
@@ -13,7 +15,7 @@ public:
     AudioWaveformView(QWidget *parent);
     ~AudioWaveformView();
 
-    void UpdateWaveform(const QByteArray &audio_data, const QAudioFormat &format);
+    void UpdateWaveform(const AudioBlockRef &block, const QAudioFormat &format);
     void StartDisplay();
     void StopDisplay();
     void ClearDisplay();
@@ -24,7 +26,7 @@ public:
 private:
     void InitChart();
     void UpdateDisplay();
-    QList<double> ConvertToDisplayData(const QByteArray &pcm_data, const QAudioFormat &format);
+    void AppendDisplayData(const char *pcm_data, qsizetype size, const QAudioFormat &format);
 
 private:
     QLineSeries *waveform_series_;
@@ -35,4 +37,6 @@ private:
     // 状态控制
     QAudioFormat current_format_;
     bool is_displaying_{ false };
+    // 数据块到达比刷新频繁，按显示时长节流重绘
+    QElapsedTimer refresh_timer_;
 };
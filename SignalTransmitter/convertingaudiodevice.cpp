@@ -0,0 +1,73 @@
+﻿#include "convertingaudiodevice.h"
+#include <cstring>
+
+ConvertingAudioDevice::ConvertingAudioDevice(QIODevice *source, QObject *parent)
+    : QIODevice(parent)
+    , source_(source)
+{}
+
+bool ConvertingAudioDevice::Configure(const QAudioFormat &source_format, const QAudioFormat &output_format)
+{
+    if (!converter_.Configure(source_format, output_format, kBlockFrames)) {
+        return false;
+    }
+    // 缓冲区一次分配，播放过程中不再分配内存
+    input_buffer_.resize(static_cast<size_t>(kBlockFrames) * source_format.bytesPerFrame());
+    output_buffer_.resize(static_cast<size_t>(converter_.MaxOutputFrames(kBlockFrames)) * output_format.bytesPerFrame());
+    Reset();
+    return true;
+}
+
+void ConvertingAudioDevice::Reset()
+{
+    converter_.Reset();
+    pending_pos_ = 0;
+    pending_size_ = 0;
+}
+
+bool ConvertingAudioDevice::atEnd() const
+{
+    return pending_pos_ >= pending_size_ && source_->atEnd();
+}
+
+qint64 ConvertingAudioDevice::bytesAvailable() const
+{
+    // 源设备剩余数据按采样率比例折算
+    const auto &in = converter_.get_input_format();
+    const auto &out = converter_.get_output_format();
+    const qint64 source_frames = source_->bytesAvailable() / in.bytesPerFrame();
+    const qint64 frames = source_frames * converter_.get_interpolation() / converter_.get_decimation();
+    return pending_size_ - pending_pos_ + frames * out.bytesPerFrame() + QIODevice::bytesAvailable();
+}
+
+qint64 ConvertingAudioDevice::readData(char *data, qint64 max_size)
+{
+    const int in_frame_bytes = converter_.get_input_format().bytesPerFrame();
+    const int out_frame_bytes = converter_.get_output_format().bytesPerFrame();
+    qint64 copied{ 0 };
+    while (copied < max_size) {
+        if (pending_pos_ >= pending_size_) {
+            // 待读数据用完，从源设备读取一块并转换
+            const qint64 n = source_->read(input_buffer_.data(), static_cast<qint64>(input_buffer_.size()));
+            if (n < in_frame_bytes) {
+                break;
+            }
+            const int frames = converter_.Process(input_buffer_.data(), static_cast<int>(n / in_frame_bytes), output_buffer_.data());
+            pending_pos_ = 0;
+            pending_size_ = static_cast<qint64>(frames) * out_frame_bytes;
+            continue;
+        }
+        const qint64 n = qMin(max_size - copied, pending_size_ - pending_pos_);
+        memcpy(data + copied, output_buffer_.data() + pending_pos_, n);
+        pending_pos_ += n;
+        copied += n;
+    }
+    return copied;
+}
+
+qint64 ConvertingAudioDevice::writeData(const char *data, qint64 max_size)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(max_size);
+    return -1;
+}
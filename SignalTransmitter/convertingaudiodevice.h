@@ -0,0 +1,39 @@
+﻿#pragma once
+
+#include <QIODevice>
+#include <QAudioFormat>
+#include <vector>
+#include "audioconverter.h"
+
+// 格式转换设备：从源设备按块读取，经AudioConverter转换为音频输出设备支持的格式
+// 顺序设备，源设备跳转后须调用Reset清空转换器状态和待读数据
+class ConvertingAudioDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    ConvertingAudioDevice(QIODevice *source, QObject *parent = nullptr);
+
+    bool Configure(const QAudioFormat &source_format, const QAudioFormat &output_format);
+    void Reset();
+
+    bool isSequential() const override { return true; }
+    bool atEnd() const override;
+    qint64 bytesAvailable() const override;
+
+    const QAudioFormat &get_output_format() const { return converter_.get_output_format(); }
+
+    static constexpr int kBlockFrames{ 4096 };   // 每次从源设备读取的帧数
+
+protected:
+    qint64 readData(char *data, qint64 max_size) override;
+    qint64 writeData(const char *data, qint64 max_size) override;
+
+private:
+    QIODevice *source_;
+    AudioConverter converter_;
+    std::vector<char> input_buffer_;
+    std::vector<char> output_buffer_;
+    qint64 pending_pos_{ 0 };
+    qint64 pending_size_{ 0 };
+};
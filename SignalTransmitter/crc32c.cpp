@@ -0,0 +1,104 @@
+﻿#include "crc32c.h"
+#include <QtEndian>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__x86_64__)
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CRC32C_TARGET
+#else
+#define CRC32C_TARGET __attribute__((target("sse4.2")))
+#endif
+#define CRC32C_USE_SSE42
+#endif
+
+namespace {
+
+constexpr quint32 kPolynomial{ 0x82F63B78 };    // 反射形式
+
+struct Crc32cTable {
+    quint32 table[8][256];
+
+    Crc32cTable()
+    {
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (kPolynomial & (0u - (crc & 1)));
+            }
+            table[0][i] = crc;
+        }
+        for (quint32 i = 0; i < 256; ++i) {
+            for (int k = 1; k < 8; ++k) {
+                table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+quint32 SoftwareCrc(quint32 crc, const uchar *data, qint64 size)
+{
+    static const Crc32cTable tables;
+    const auto &t = tables.table;
+    while (size >= 8) {
+        quint32 low, high;
+        memcpy(&low, data, 4);
+        memcpy(&high, data + 4, 4);
+        low = qFromLittleEndian(low) ^ crc;
+        high = qFromLittleEndian(high);
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24]
+            ^ t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+        data += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+#ifdef CRC32C_USE_SSE42
+CRC32C_TARGET quint32 HardwareCrc(quint32 crc, const uchar *data, qint64 size)
+{
+    quint64 crc64 = crc;
+    while (size >= 8) {
+        quint64 value;
+        memcpy(&value, data, 8);
+        crc64 = _mm_crc32_u64(crc64, value);
+        data += 8;
+        size -= 8;
+    }
+    crc = static_cast<quint32>(crc64);
+    while (size-- > 0) {
+        crc = _mm_crc32_u8(crc, *data++);
+    }
+    return crc;
+}
+
+bool HasSse42()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#else
+    return __builtin_cpu_supports("sse4.2");
+#endif
+}
+#endif
+
+}
+
+quint32 Crc32c(const void *data, qint64 size, quint32 crc)
+{
+    const auto *bytes = static_cast<const uchar *>(data);
+    crc = ~crc;
+#ifdef CRC32C_USE_SSE42
+    static const bool has_sse42 = HasSse42();
+    if (has_sse42) {
+        return ~HardwareCrc(crc, bytes, size);
+    }
+#endif
+    return ~SoftwareCrc(crc, bytes, size);
+}
@@ -0,0 +1,7 @@
+﻿#pragma once
+
+#include <QtGlobal>
+
+// CRC32C（Castagnoli多项式），x64下运行时检测SSE4.2使用crc32指令，否则使用slicing-by-8查表
+// crc为前一段数据的结果，可分段计算：Crc32c(b, nb, Crc32c(a, na)) == Crc32c(ab, na + nb)
+quint32 Crc32c(const void *data, qint64 size, quint32 crc = 0);
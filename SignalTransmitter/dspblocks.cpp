@@ -0,0 +1,267 @@
+﻿#include "dspblocks.h"
+#include <algorithm>
+
+TextSourceBlock::TextSourceBlock(const QString &text, DspStream<char16_t> *out)
+    : DspBlock({}, { out })
+    , text_(text)
+    , out_(out)
+{
+}
+
+DspBlock::Status_t TextSourceBlock::Work()
+{
+    if (pos_ >= text_.size()) {
+        return Done();
+    }
+    const auto *data = reinterpret_cast<const char16_t *>(text_.utf16()) + pos_;
+    const size_t n = out_->Write(data, static_cast<size_t>(qMin<qsizetype>(kChunk, text_.size() - pos_)));
+    pos_ += n;
+    return n > 0 ? kProgress : kIdle;
+}
+
+TextDeviceSourceBlock::TextDeviceSourceBlock(QIODevice *device, DspStream<char16_t> *out)
+    : DspBlock({}, { out })
+    , device_(device)
+    , out_(out)
+{
+}
+
+DspBlock::Status_t TextDeviceSourceBlock::Work()
+{
+    if (pos_ >= text_.size()) {
+        // 读取下一段；读取结束或出错时返回空
+        const QByteArray chunk = device_->read(kInputChunk);
+        if (chunk.isEmpty()) {
+            return Done();
+        }
+        if (input_bytes_ == 0) {
+            const auto encoding = QStringConverter::encodingForData(chunk);
+            decoder_ = QStringDecoder(encoding.value_or(QStringConverter::Utf8));
+        }
+        input_bytes_ += chunk.size();
+        text_ = decoder_.decode(chunk);
+        text_.remove(QChar('\r'));
+        pos_ = 0;
+        if (text_.isEmpty()) {
+            return kProgress;
+        }
+    }
+    const auto *data = reinterpret_cast<const char16_t *>(text_.utf16()) + pos_;
+    const size_t n = out_->Write(data, static_cast<size_t>(qMin<qsizetype>(kChunk, text_.size() - pos_)));
+    pos_ += n;
+    return n > 0 ? kProgress : kIdle;
+}
+
+EncoderBlock::EncoderBlock(SignalCore::Encoding_t encoding, DspStream<char16_t> *in, DspStream<uint8_t> *out)
+    : DspBlock({ in }, { out })
+    , encoding_(encoding)
+    , in_(in)
+    , out_(out)
+{
+}
+
+DspBlock::Status_t EncoderBlock::Work()
+{
+    // 先写出上次下游放不下的数据
+    if (!pending_.IsEmpty()) {
+        return pending_.Flush(out_) > 0 ? kProgress : kIdle;
+    }
+    const bool drained = in_->IsDrained();
+    const size_t carried = text_.size();
+    text_.resize(carried + kChunk / 8);
+    const size_t n = in_->Read(text_.data() + carried, kChunk / 8);
+    text_.resize(carried + n);
+    if (text_.empty()) {
+        return drained ? Done() : kIdle;
+    }
+    if (n == 0 && !drained) {
+        return kIdle;
+    }
+    // 输入未结束时，段末的高位代理项等待与下一段的低位代理项一起编码
+    size_t count = text_.size();
+    if (!drained && QChar::isHighSurrogate(text_[count - 1])) {
+        --count;
+        if (count == 0) {
+            return kIdle;
+        }
+    }
+    const QByteArray encoded = SignalCore::EncodeText(QStringView(text_.data(), static_cast<qsizetype>(count)), encoding_);
+    uint8_t *bits = pending_.Prepare(static_cast<size_t>(encoded.size()) * 8);
+    SignalCore::ExpandBits(encoded.constData(), encoded.size(), bits);
+    pending_.Commit(static_cast<size_t>(encoded.size()) * 8);
+    bit_count_ += encoded.size() * 8;
+    text_.erase(text_.begin(), text_.begin() + static_cast<std::ptrdiff_t>(count));
+    pending_.Flush(out_);
+    return kProgress;
+}
+
+ModulatorBlock::ModulatorBlock(SignalCore::Modulation_t modulation, DspStream<uint8_t> *in, DspStream<double> *out)
+    : DspBlock({ in }, { out })
+    , modulation_(modulation)
+    , in_(in)
+    , out_(out)
+    , bits_(kChunk / SignalCore::kSamplesPerBit)
+{
+}
+
+DspBlock::Status_t ModulatorBlock::Work()
+{
+    if (!pending_.IsEmpty()) {
+        return pending_.Flush(out_) > 0 ? kProgress : kIdle;
+    }
+    const bool drained = in_->IsDrained();
+    const size_t n = in_->Read(bits_.data(), bits_.size());
+    if (n == 0) {
+        return drained ? Done() : kIdle;
+    }
+    if (modulation_ == SignalCore::kModulationUnknown) {
+        return kProgress;
+    }
+    double *samples = pending_.Prepare(n * SignalCore::kSamplesPerBit);
+    SignalCore::Modulate(bits_.data(), static_cast<qsizetype>(n), modulation_, samples);
+    pending_.Commit(n * SignalCore::kSamplesPerBit);
+    pending_.Flush(out_);
+    return kProgress;
+}
+
+FirFilterBlock::FirFilterBlock(const std::vector<double> &taps, DspStream<double> *in, DspStream<double> *out)
+    : DspBlock({ in }, { out })
+    , taps_(taps.empty() ? std::vector<double>{ 1.0 } : taps)
+    , in_(in)
+    , out_(out)
+    , history_(taps_.size() - 1, 0.0)
+{
+}
+
+DspBlock::Status_t FirFilterBlock::Work()
+{
+    if (!pending_.IsEmpty()) {
+        return pending_.Flush(out_) > 0 ? kProgress : kIdle;
+    }
+    const bool drained = in_->IsDrained();
+    const size_t order = taps_.size() - 1;
+    history_.resize(order + kChunk);
+    const size_t n = in_->Read(history_.data() + order, kChunk);
+    if (n == 0) {
+        history_.resize(order);
+        return drained ? Done() : kIdle;
+    }
+    // y[i] = sum(taps[k] * x[i - k])，x[i]位于history_[order + i]
+    double *out = pending_.Prepare(n);
+    const double *x = history_.data() + order;
+    const auto tap_count = static_cast<std::ptrdiff_t>(taps_.size());
+    for (size_t i = 0; i < n; ++i) {
+        const double *xi = x + i;
+        double acc{ 0.0 };
+        for (std::ptrdiff_t k = 0; k < tap_count; ++k) {
+            acc += taps_[k] * xi[-k];
+        }
+        out[i] = acc;
+    }
+    pending_.Commit(n);
+    // 保留最后order个输入作为下一段的历史
+    std::copy(history_.begin() + static_cast<std::ptrdiff_t>(n), history_.begin() + static_cast<std::ptrdiff_t>(n + order), history_.begin());
+    history_.resize(order);
+    pending_.Flush(out_);
+    return kProgress;
+}
+
+EncodedFileSinkBlock::EncodedFileSinkBlock(const QString &file_path, DspStream<uint8_t> *in)
+    : DspBlock({ in }, {})
+    , file_(file_path)
+    , in_(in)
+    , bits_(kChunk)
+    , text_(kChunk, '0')
+{
+}
+
+DspBlock::Status_t EncodedFileSinkBlock::Work()
+{
+    if (!file_.isOpen() && !file_.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return Fail(QString("Cannot open file: %1").arg(file_.errorString()));
+    }
+    const bool drained = in_->IsDrained();
+    const size_t n = in_->Read(bits_.data(), bits_.size());
+    if (n == 0) {
+        if (!drained) {
+            return kIdle;
+        }
+        file_.close();
+        return file_.error() == QFileDevice::NoError ? Done() : Fail("写入编码文件失败");
+    }
+    for (size_t i = 0; i < n; ++i) {
+        text_[static_cast<qsizetype>(i)] = bits_[i] ? '1' : '0';
+    }
+    if (file_.write(text_.constData(), static_cast<qint64>(n)) != static_cast<qint64>(n)) {
+        return Fail("写入编码文件失败");
+    }
+    return kProgress;
+}
+
+ModulatedFileSinkBlock::ModulatedFileSinkBlock(const QString &file_path, DspStream<double> *in)
+    : DspBlock({ in }, {})
+    , file_(file_path)
+    , in_(in)
+    , samples_(kChunk)
+{
+}
+
+DspBlock::Status_t ModulatedFileSinkBlock::Work()
+{
+    if (!file_.isOpen()) {
+        if (!file_.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            return Fail(QString("Cannot open file: %1").arg(file_.errorString()));
+        }
+        stream_.setDevice(&file_);
+    }
+    const bool drained = in_->IsDrained();
+    const size_t n = in_->Read(samples_.data(), samples_.size());
+    if (n == 0) {
+        if (!drained) {
+            return kIdle;
+        }
+        stream_.flush();
+        const bool ok = stream_.status() == QTextStream::Ok;
+        stream_.setDevice(nullptr);
+        file_.close();
+        return ok ? Done() : Fail("写入调制文件失败");
+    }
+    for (size_t i = 0; i < n; ++i) {
+        stream_ << samples_[i] << " ";
+    }
+    return stream_.status() == QTextStream::Ok ? kProgress : Fail("写入调制文件失败");
+}
+
+WavSinkBlock::WavSinkBlock(const QString &file_path, int sample_rate, DspStream<double> *in)
+    : DspBlock({ in }, {})
+    , file_path_(file_path)
+    , sample_rate_(sample_rate)
+    , in_(in)
+    , samples_(kChunk)
+    , block_(kChunk)
+{
+}
+
+DspBlock::Status_t WavSinkBlock::Work()
+{
+    if (!writer_.IsOpen()) {
+        if (!writer_.Open(file_path_, sample_rate_, 1, 32, true)) {
+            return Fail("Cannot open file: " + file_path_);
+        }
+    }
+    const bool drained = in_->IsDrained();
+    const size_t n = in_->Read(samples_.data(), samples_.size());
+    if (n == 0) {
+        if (!drained) {
+            return kIdle;
+        }
+        return writer_.Close() ? Done() : Fail("写入WAV文件失败");
+    }
+    for (size_t i = 0; i < n; ++i) {
+        block_[i] = static_cast<float>(samples_[i]);
+    }
+    if (!writer_.Write(reinterpret_cast<const char *>(block_.data()), static_cast<qint64>(n * sizeof(float)))) {
+        return Fail("写入WAV文件失败");
+    }
+    return kProgress;
+}
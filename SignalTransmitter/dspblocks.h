@@ -0,0 +1,260 @@
+﻿#pragma once
+
+#include <QFile>
+#include <QIODevice>
+#include <QList>
+#include <QString>
+#include <QStringDecoder>
+#include <QTextStream>
+#include <algorithm>
+#include <vector>
+#include "dspgraph.h"
+#include "signalcore.h"
+#include "wavstreamwriter.h"
+
+// 常用处理块：源（文本、设备、内存数据）、编码、调制、FIR滤波、分流、汇（内存、文本文件、WAV文件）
+// 新的处理级只需实现DspBlock::Work并用DspStream连接，不需要修改已有的块
+
+// 内存数据源：按段写出，数据隐式共享，不复制
+template <typename T>
+class VectorSourceBlock : public DspBlock
+{
+public:
+    VectorSourceBlock(const QList<T> &data, DspStream<T> *out)
+        : DspBlock({}, { out })
+        , data_(data)
+        , out_(out)
+    {}
+
+    Status_t Work() override
+    {
+        if (pos_ >= data_.size()) {
+            return Done();
+        }
+        const size_t n = out_->Write(data_.constData() + pos_, static_cast<size_t>(qMin<qsizetype>(kChunk, data_.size() - pos_)));
+        pos_ += n;
+        return n > 0 ? kProgress : kIdle;
+    }
+
+private:
+    QList<T> data_;
+    DspStream<T> *out_;
+    qsizetype pos_{ 0 };
+};
+
+// 内存汇：收集全部数据，size_hint为预期长度（用于预分配）
+template <typename T>
+class VectorSinkBlock : public DspBlock
+{
+public:
+    explicit VectorSinkBlock(DspStream<T> *in, qsizetype size_hint = 0)
+        : DspBlock({ in }, {})
+        , in_(in)
+    {
+        data_.reserve(size_hint);
+    }
+
+    Status_t Work() override
+    {
+        const size_t available = qMin(in_->ReadAvailable(), kChunk);
+        if (available == 0) {
+            return in_->IsDrained() ? Done() : kIdle;
+        }
+        const qsizetype pos = data_.size();
+        data_.resize(pos + static_cast<qsizetype>(available));
+        in_->Read(data_.data() + pos, available);
+        return kProgress;
+    }
+
+    QList<T> &get_data() { return data_; }
+
+private:
+    DspStream<T> *in_;
+    QList<T> data_;
+};
+
+// 分流：把输入复制到两个输出，按两个输出中较少的空闲空间读取，较慢的下游限制上游
+template <typename T>
+class TeeBlock : public DspBlock
+{
+public:
+    TeeBlock(DspStream<T> *in, DspStream<T> *out_a, DspStream<T> *out_b)
+        : DspBlock({ in }, { out_a, out_b })
+        , in_(in)
+        , out_a_(out_a)
+        , out_b_(out_b)
+        , buffer_(kChunk)
+    {}
+
+    Status_t Work() override
+    {
+        const bool drained = in_->IsDrained();
+        const size_t n = std::min({ in_->ReadAvailable(), kChunk, out_a_->WriteAvailable(), out_b_->WriteAvailable() });
+        if (n == 0) {
+            return drained ? Done() : kIdle;
+        }
+        in_->Read(buffer_.data(), n);
+        out_a_->Write(buffer_.data(), n);
+        out_b_->Write(buffer_.data(), n);
+        return kProgress;
+    }
+
+private:
+    DspStream<T> *in_;
+    DspStream<T> *out_a_;
+    DspStream<T> *out_b_;
+    std::vector<T> buffer_;
+};
+
+// 丢弃输入（不需要某一级的输出时接在其后，使上游能够结束）
+template <typename T>
+class NullSinkBlock : public DspBlock
+{
+public:
+    explicit NullSinkBlock(DspStream<T> *in)
+        : DspBlock({ in }, {})
+        , in_(in)
+        , buffer_(kChunk)
+    {}
+
+    Status_t Work() override
+    {
+        const bool drained = in_->IsDrained();
+        if (in_->Read(buffer_.data(), buffer_.size()) == 0) {
+            return drained ? Done() : kIdle;
+        }
+        return kProgress;
+    }
+
+private:
+    DspStream<T> *in_;
+    std::vector<T> buffer_;
+};
+
+// 文本源：按段写出UTF-16码元
+class TextSourceBlock : public DspBlock
+{
+public:
+    TextSourceBlock(const QString &text, DspStream<char16_t> *out);
+    Status_t Work() override;
+
+private:
+    QString text_;
+    DspStream<char16_t> *out_;
+    qsizetype pos_{ 0 };
+};
+
+// 设备文本源：从文件或标准输入分段读取并解码，编码按BOM判断，默认UTF-8；
+// 与SignalCore::ReadTextFile以文本方式读取文件一致，去掉回车符
+class TextDeviceSourceBlock : public DspBlock
+{
+public:
+    TextDeviceSourceBlock(QIODevice *device, DspStream<char16_t> *out);
+    Status_t Work() override;
+
+    // 全部块结束后读取
+    qint64 get_input_bytes() const { return input_bytes_; }
+
+    static constexpr qint64 kInputChunk{ 64 * 1024 };
+
+private:
+    QIODevice *device_;
+    DspStream<char16_t> *out_;
+    QStringDecoder decoder_;                // 保留跨段的不完整字符
+    QString text_;
+    qsizetype pos_{ 0 };
+    qint64 input_bytes_{ 0 };
+};
+
+// 编码：文本转换为字节流后按位展开（高位在前）；段末的高位代理项留到下一段，保证UTF-8编码正确
+class EncoderBlock : public DspBlock
+{
+public:
+    EncoderBlock(SignalCore::Encoding_t encoding, DspStream<char16_t> *in, DspStream<uint8_t> *out);
+    Status_t Work() override;
+
+    // 全部块结束后读取
+    qint64 get_bit_count() const { return bit_count_; }
+
+private:
+    SignalCore::Encoding_t encoding_;
+    DspStream<char16_t> *in_;
+    DspStream<uint8_t> *out_;
+    std::vector<char16_t> text_;
+    DspPending<uint8_t> pending_;
+    qint64 bit_count_{ 0 };
+};
+
+// 调制：每位生成SignalCore::kSamplesPerBit个样本，每次处理的位数使输出约为一段
+class ModulatorBlock : public DspBlock
+{
+public:
+    ModulatorBlock(SignalCore::Modulation_t modulation, DspStream<uint8_t> *in, DspStream<double> *out);
+    Status_t Work() override;
+
+private:
+    SignalCore::Modulation_t modulation_;
+    DspStream<uint8_t> *in_;
+    DspStream<double> *out_;
+    std::vector<uint8_t> bits_;
+    DspPending<double> pending_;
+};
+
+// FIR滤波：保留taps - 1个历史样本，分段处理与整段卷积结果相同
+class FirFilterBlock : public DspBlock
+{
+public:
+    FirFilterBlock(const std::vector<double> &taps, DspStream<double> *in, DspStream<double> *out);
+    Status_t Work() override;
+
+private:
+    std::vector<double> taps_;
+    DspStream<double> *in_;
+    DspStream<double> *out_;
+    std::vector<double> history_;           // 前taps - 1个历史样本 + 本段输入
+    DspPending<double> pending_;
+};
+
+// 编码文件汇：每位一个'0'或'1'字符，与SignalCore::WriteEncodedFile格式相同
+class EncodedFileSinkBlock : public DspBlock
+{
+public:
+    EncodedFileSinkBlock(const QString &file_path, DspStream<uint8_t> *in);
+    Status_t Work() override;
+
+private:
+    QFile file_;
+    DspStream<uint8_t> *in_;
+    std::vector<uint8_t> bits_;
+    QByteArray text_;
+};
+
+// 调制文件汇：空格分隔的样本值，与SignalCore::WriteModulatedFile格式相同
+class ModulatedFileSinkBlock : public DspBlock
+{
+public:
+    ModulatedFileSinkBlock(const QString &file_path, DspStream<double> *in);
+    Status_t Work() override;
+
+private:
+    QFile file_;
+    QTextStream stream_;
+    DspStream<double> *in_;
+    std::vector<double> samples_;
+};
+
+// WAV文件汇：32位浮点单声道
+class WavSinkBlock : public DspBlock
+{
+public:
+    WavSinkBlock(const QString &file_path, int sample_rate, DspStream<double> *in);
+    Status_t Work() override;
+
+private:
+    QString file_path_;
+    int sample_rate_{ 0 };
+    DspStream<double> *in_;
+    WavStreamWriter writer_;
+    std::vector<double> samples_;
+    std::vector<float> block_;
+};
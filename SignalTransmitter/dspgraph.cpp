@@ -0,0 +1,143 @@
+﻿#include "dspgraph.h"
+
+DspGraph::~DspGraph()
+{
+    // 提前销毁时先停止仍在运行的块
+    if (pool_) {
+        cancelled_ = true;
+        for (const auto &block : blocks_) {
+            Schedule(block.get());
+        }
+        Wait();
+    }
+}
+
+void DspGraph::Attach(DspBlock *block)
+{
+    for (auto *input : block->inputs_) {
+        input->consumer_ = block;
+    }
+    for (auto *output : block->outputs_) {
+        output->producer_ = block;
+    }
+}
+
+void DspGraph::Start(QThreadPool *pool)
+{
+    pool_ = pool;
+    cancelled_ = false;
+    error_.clear();
+    remaining_ = blocks_.size();
+    for (const auto &block : blocks_) {
+        Schedule(block.get());
+    }
+}
+
+bool DspGraph::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_.wait(lock, [this]() { return remaining_ == 0; });
+    return error_.isEmpty();
+}
+
+void DspGraph::Schedule(DspBlock *block)
+{
+    if (!block) {
+        return;
+    }
+    int state = block->run_state_.load();
+    for (;;) {
+        if (state == DspBlock::kStateIdle) {
+            if (block->run_state_.compare_exchange_weak(state, DspBlock::kStateScheduled)) {
+                pool_->start([this, block]() { RunBlock(block); });
+                return;
+            }
+        } else if (state == DspBlock::kStateScheduled) {
+            // 正在运行：只做标记，由运行它的线程再检查一轮，避免同一块在两个线程上运行
+            if (block->run_state_.compare_exchange_weak(state, DspBlock::kStateWoken)) {
+                return;
+            }
+        } else {
+            return;
+        }
+    }
+}
+
+void DspGraph::RunBlock(DspBlock *block)
+{
+    for (;;) {
+        block->run_state_ = DspBlock::kStateScheduled;
+        if (cancelled_) {
+            FinishBlock(block, false);
+            return;
+        }
+        bool progressed{ false };
+        DspBlock::Status_t status{ DspBlock::kIdle };
+        for (int i = 0; i < kSliceCalls; ++i) {
+            status = block->Work();
+            if (status != DspBlock::kProgress) {
+                break;
+            }
+            progressed = true;
+        }
+        if (status == DspBlock::kDone || status == DspBlock::kFailed) {
+            WakeNeighbors(block);
+            FinishBlock(block, status == DspBlock::kFailed);
+            return;
+        }
+        if (progressed) {
+            WakeNeighbors(block);
+        }
+        if (status == DspBlock::kProgress) {
+            // 用完时间片，重新排队让出线程
+            pool_->start([this, block]() { RunBlock(block); });
+            return;
+        }
+        // 没有可处理的数据时挂起；运行期间被唤醒过则继续。
+        // 挂起成功后块可能立即在其他线程上运行并结束，图随之销毁，此后不能再访问成员
+        int expected = DspBlock::kStateScheduled;
+        if (block->run_state_.compare_exchange_strong(expected, DspBlock::kStateIdle)) {
+            return;
+        }
+    }
+}
+
+void DspGraph::WakeNeighbors(DspBlock *block)
+{
+    // 消耗了输入则上游有了空间，产生了输出则下游有了数据
+    for (auto *input : block->inputs_) {
+        Schedule(input->producer_);
+    }
+    for (auto *output : block->outputs_) {
+        Schedule(output->consumer_);
+    }
+}
+
+void DspGraph::FinishBlock(DspBlock *block, bool failed)
+{
+    block->run_state_ = DspBlock::kStateFinished;
+    for (auto *output : block->outputs_) {
+        output->Finish();
+    }
+    if (failed) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (error_.isEmpty()) {
+                error_ = block->get_error();
+            }
+        }
+        // 唤醒挂起的块，让它们看到取消标志后结束
+        cancelled_ = true;
+        for (const auto &other : blocks_) {
+            Schedule(other.get());
+        }
+    }
+    // 最后一个块结束后图可能立即被销毁，此后不能再访问成员
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--remaining_ == 0) {
+        if (finished_handler_) {
+            finished_handler_(error_.isEmpty());
+        }
+        finished_.notify_all();
+    }
+}
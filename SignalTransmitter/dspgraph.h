@@ -0,0 +1,199 @@
+﻿#pragma once
+
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "spscringbuffer.h"
+
+class DspBlock;
+
+// 数据流图中块之间的连接：固定容量的单生产者/单消费者缓冲区，写满时上游停下（背压）
+// 生产者结束后调用Finish，消费者读空且已结束时即可结束
+class DspStreamBase
+{
+public:
+    virtual ~DspStreamBase() = default;
+
+    void Finish() { finished_.store(true, std::memory_order_release); }
+    bool IsFinished() const { return finished_.load(std::memory_order_acquire); }
+
+private:
+    friend class DspGraph;
+    std::atomic<bool> finished_{ false };
+    DspBlock *producer_{ nullptr };
+    DspBlock *consumer_{ nullptr };
+};
+
+template <typename T>
+class DspStream : public DspStreamBase
+{
+public:
+    explicit DspStream(size_t capacity)
+        : ring_(capacity)
+    {}
+
+    size_t Write(const T *data, size_t count) { return ring_.Write(data, count); }
+    size_t Read(T *out, size_t count) { return ring_.Read(out, count); }
+    size_t ReadAvailable() const { return ring_.ReadAvailable(); }
+    size_t WriteAvailable() const { return ring_.WriteAvailable(); }
+    // 先检查结束标志：看到结束时生产者之前写入的数据都已可见
+    bool IsDrained() const { return IsFinished() && ring_.ReadAvailable() == 0; }
+
+private:
+    SpscRingBuffer<T> ring_;
+};
+
+// 已处理但下游暂时放不下的数据，下次Work时先写出
+template <typename T>
+class DspPending
+{
+public:
+    T *Prepare(size_t count)
+    {
+        data_.resize(count);
+        pos_ = 0;
+        size_ = 0;
+        return data_.data();
+    }
+    void Commit(size_t count) { size_ = count; }
+    // 返回本次写出的元素数；只写出一部分也算有进展，需要唤醒下游
+    size_t Flush(DspStream<T> *out)
+    {
+        const size_t written = out->Write(data_.data() + pos_, size_ - pos_);
+        pos_ += written;
+        return written;
+    }
+    bool IsEmpty() const { return pos_ == size_; }
+
+private:
+    std::vector<T> data_;
+    size_t pos_{ 0 };
+    size_t size_{ 0 };
+};
+
+// 处理块：每次Work处理至多一段数据（约kChunk个元素），工作集保持在缓存中
+// 输入没有数据或输出已满时返回kIdle，调度器在相邻块有进展后再调度它
+class DspBlock
+{
+public:
+    enum Status_t {
+        kProgress,
+        kIdle,
+        kDone,
+        kFailed
+    };
+
+    virtual ~DspBlock() = default;
+    virtual Status_t Work() = 0;
+    const QString &get_error() const { return error_; }
+
+    static constexpr size_t kChunk{ 4096 };
+
+protected:
+    DspBlock(std::initializer_list<DspStreamBase *> inputs, std::initializer_list<DspStreamBase *> outputs)
+        : inputs_(inputs)
+        , outputs_(outputs)
+    {}
+
+    // 结束：通知下游不会再有数据
+    Status_t Done()
+    {
+        for (auto *output : outputs_) {
+            output->Finish();
+        }
+        return kDone;
+    }
+    Status_t Fail(const QString &error)
+    {
+        error_ = error;
+        return kFailed;
+    }
+
+private:
+    friend class DspGraph;
+    enum RunState_t {
+        kStateIdle,
+        kStateScheduled,
+        kStateWoken,        // 运行期间相邻块有进展，挂起前需要再检查一轮
+        kStateFinished
+    };
+
+    std::vector<DspStreamBase *> inputs_;
+    std::vector<DspStreamBase *> outputs_;
+    std::atomic<int> run_state_{ kStateIdle };
+    QString error_;
+};
+
+// 数据流图和调度器
+// 所有块共用一个线程池：块有数据可处理时作为任务提交，每个任务最多连续调用kSliceCalls次Work后让出线程，
+// 因此块数多于线程数时也不会互相等待；相邻的块在不同线程上同时运行，各级之间流水重叠。
+class DspGraph
+{
+public:
+    DspGraph() = default;
+    ~DspGraph();
+
+    DspGraph(const DspGraph &) = delete;
+    DspGraph &operator=(const DspGraph &) = delete;
+
+    template <typename T>
+    DspStream<T> *AddStream(size_t capacity = kStreamCapacity)
+    {
+        auto stream = std::make_unique<DspStream<T>>(capacity);
+        auto *ptr = stream.get();
+        streams_.push_back(std::move(stream));
+        return ptr;
+    }
+
+    template <typename Block, typename... Args>
+    Block *AddBlock(Args &&...args)
+    {
+        auto block = std::make_unique<Block>(std::forward<Args>(args)...);
+        auto *ptr = block.get();
+        Attach(ptr);
+        blocks_.push_back(std::move(block));
+        return ptr;
+    }
+
+    // 所有块结束时在线程池线程中调用，参数为是否成功；Start前设置。
+    // 调用时持有图的锁，Wait和析构等它返回后才继续，因此其中不能调用Wait或销毁图（可投递到其他线程处理）
+    void set_finished_handler(std::function<void(bool)> handler) { finished_handler_ = std::move(handler); }
+    // 启动后立即返回，块在线程池中运行；不要在同一线程池的任务中调用Run（会占用一个线程等待）
+    // 界面线程不要调用Wait/Run，应使用finished_handler得知结束
+    void Start(QThreadPool *pool = QThreadPool::globalInstance());
+    // 等待所有块结束，任一块失败时返回false，其余块随之停止
+    bool Wait();
+    bool Run(QThreadPool *pool = QThreadPool::globalInstance())
+    {
+        Start(pool);
+        return Wait();
+    }
+    const QString &get_error() const { return error_; }
+
+    static constexpr size_t kStreamCapacity{ 4 * DspBlock::kChunk };
+    static constexpr int kSliceCalls{ 16 };
+
+private:
+    void Attach(DspBlock *block);
+    void Schedule(DspBlock *block);
+    void RunBlock(DspBlock *block);
+    void WakeNeighbors(DspBlock *block);
+    void FinishBlock(DspBlock *block, bool failed);
+
+private:
+    std::vector<std::unique_ptr<DspStreamBase>> streams_;
+    std::vector<std::unique_ptr<DspBlock>> blocks_;
+    QThreadPool *pool_{ nullptr };
+    std::atomic<bool> cancelled_{ false };
+    std::mutex mutex_;
+    std::condition_variable finished_;
+    size_t remaining_{ 0 };
+    QString error_;
+    std::function<void(bool)> finished_handler_;
+};
@@ -0,0 +1,267 @@
+﻿#include "eyediagramview.h"
+#include <QPainter>
+#include <QMouseEvent>
+#include <QtConcurrent>
+#include <QtMath>
+
+EyeDiagramView::EyeDiagramView(QWidget *parent)
+    : QWidget(parent)
+    , watcher_(new QFutureWatcher<void>(this))
+    , refresh_timer_(new QTimer(this))
+    , eye_image_(kEyeWidth, kEyeHeight, QImage::Format_RGB32)
+    , constellation_image_(kConstellationSize, kConstellationSize, QImage::Format_RGB32)
+{
+    // 密度色表：由黑到绿再到白
+    color_table_.resize(256);
+    for (int i = 0; i < 256; ++i) {
+        const int g = qMin(255, i * 2);
+        const int rb = qMax(0, i * 2 - 255);
+        color_table_[i] = qRgb(rb, g, rb);
+    }
+    eye_image_.fill(color_table_.first());
+    constellation_image_.fill(color_table_.first());
+    // 累积过程中定时刷新，结束时再刷新一次
+    connect(refresh_timer_, &QTimer::timeout, this, &EyeDiagramView::RenderImages);
+    connect(watcher_, &QFutureWatcher<void>::finished, this, [this]() {
+        refresh_timer_->stop();
+        RenderImages();
+    });
+    setMinimumSize(200, 150);
+}
+
+EyeDiagramView::~EyeDiagramView()
+{
+    CancelAccumulation();
+    watcher_->waitForFinished();
+}
+
+void EyeDiagramView::SignalSource::Read(qsizetype begin, qsizetype end, float *out) const
+{
+    if (pcm_data) {
+        // 录音数据只取第一个声道
+        const int frame_size = format.bytesPerFrame();
+        const uchar *data = pcm_data;
+        for (qsizetype n = begin; n < end; ++n) {
+            out[n - begin] = format.normalizedSampleValue(data + n * frame_size);
+        }
+    } else {
+        const double *data = samples.constData();
+        for (qsizetype n = begin; n < end; ++n) {
+            out[n - begin] = static_cast<float>(data[n]);
+        }
+    }
+}
+
+void EyeDiagramView::AccumulateSignal(const QList<double> &samples, double sample_rate, double samples_per_symbol, double carrier_freq)
+{
+    auto job = std::make_shared<AccumulationJob>();
+    job->source.samples = samples;
+    job->source.sample_count = samples.size();
+    job->sample_rate = sample_rate;
+    job->samples_per_symbol = samples_per_symbol;
+    job->carrier_freq = carrier_freq;
+    StartJob(job);
+}
+
+void EyeDiagramView::AccumulateSignal(const QString &file_path, qint64 data_offset, const QAudioFormat &format, double samples_per_symbol, double carrier_freq)
+{
+    if (format.bytesPerFrame() <= 0) {
+        ResetJob();
+        return;
+    }
+    // 映射随任务一起释放，长时间录音也不需要读入内存
+    auto file = std::make_shared<QFile>(file_path);
+    if (!file->open(QIODevice::ReadOnly) || file->size() <= data_offset) {
+        ResetJob();
+        return;
+    }
+    const qint64 data_size = file->size() - data_offset;
+    const uchar *mapped = file->map(data_offset, data_size);
+    if (!mapped) {
+        ResetJob();
+        return;
+    }
+    auto job = std::make_shared<AccumulationJob>();
+    job->source.mapped_file = file;
+    job->source.pcm_data = mapped;
+    job->source.format = format;
+    job->source.sample_count = data_size / format.bytesPerFrame();
+    job->sample_rate = format.sampleRate();
+    job->samples_per_symbol = samples_per_symbol;
+    job->carrier_freq = carrier_freq;
+    StartJob(job);
+}
+
+void EyeDiagramView::CancelAccumulation()
+{
+    // 只停止调度剩余分块，正在执行的分块写入的是各自任务的状态，不影响下一次累积
+    watcher_->cancel();
+    refresh_timer_->stop();
+}
+
+void EyeDiagramView::ResetJob()
+{
+    // 新信号无法分析时清除上一个信号的结果，避免误认为属于新信号
+    CancelAccumulation();
+    job_.reset();
+    eye_image_.fill(color_table_.first());
+    constellation_image_.fill(color_table_.first());
+    update();
+}
+
+void EyeDiagramView::StartJob(const std::shared_ptr<AccumulationJob> &job)
+{
+    CancelAccumulation();
+    if (job->samples_per_symbol < 2.0 || job->source.sample_count < 2 * job->samples_per_symbol) {
+        ResetJob();
+        return;
+    }
+    job->total_symbols = static_cast<qsizetype>(job->source.sample_count / job->samples_per_symbol);
+    job->eye_histogram.assign(kEyeWidth * kEyeHeight, 0);
+    job->constellation_histogram.assign(kConstellationSize * kConstellationSize, 0);
+    for (qsizetype s = 0; s < job->total_symbols; s += kSymbolsPerChunk) {
+        job->chunk_starts.append(s);
+    }
+    job_ = job;
+    // 分块在全局线程池中并行执行，任务持有job的引用，视图重新开始时旧任务可以安全地继续收尾
+    watcher_->setFuture(QtConcurrent::map(job->chunk_starts, [job](const qsizetype &first_symbol) {
+        AccumulateChunk(*job, first_symbol);
+    }));
+    refresh_timer_->start(kRefreshInterval);
+    RenderImages();
+}
+
+void EyeDiagramView::AccumulateChunk(AccumulationJob &job, qsizetype first_symbol)
+{
+    const double sps = job.samples_per_symbol;
+    const qsizetype last_symbol = qMin(first_symbol + kSymbolsPerChunk, job.total_symbols);
+    // 眼图每条轨迹跨两个符号周期
+    const qsizetype begin = static_cast<qsizetype>(first_symbol * sps);
+    const qsizetype end = qMin(job.source.sample_count, static_cast<qsizetype>(last_symbol * sps + 2 * sps) + 2);
+    std::vector<float> buffer(end - begin);
+    job.source.Read(begin, end, buffer.data());
+
+    std::vector<quint32> eye(kEyeWidth * kEyeHeight, 0);
+    std::vector<quint32> constellation(kConstellationSize * kConstellationSize, 0);
+    const double y_scale = kEyeHeight / (2.0 * kAmplitudeRange);
+    const double c_scale = kConstellationSize / (2.0 * kAmplitudeRange);
+    const double omega = 2.0 * M_PI * job.carrier_freq / job.sample_rate;
+    for (qsizetype s = first_symbol; s < last_symbol; ++s) {
+        const double symbol_start = s * sps - begin;
+        // 眼图：按列线性插值，得到连续的轨迹
+        if (symbol_start + 2 * sps + 1 < static_cast<double>(buffer.size())) {
+            for (int x = 0; x < kEyeWidth; ++x) {
+                const double t = symbol_start + x * 2.0 * sps / kEyeWidth;
+                const auto i = static_cast<qsizetype>(t);
+                const double f = t - i;
+                const double v = buffer[i] * (1.0 - f) + buffer[i + 1] * f;
+                const int y = static_cast<int>((kAmplitudeRange - v) * y_scale);
+                if (y >= 0 && y < kEyeHeight) {
+                    ++eye[y * kEyeWidth + x];
+                }
+            }
+        }
+        // 星座图：在一个符号内与同相/正交载波做相关
+        const auto n0 = static_cast<qsizetype>(s * sps);
+        const auto n1 = qMin(static_cast<qsizetype>((s + 1) * sps), end);
+        if (n1 <= n0) {
+            continue;
+        }
+        double cos_phase = cos(omega * n0), sin_phase = sin(omega * n0);
+        const double cos_step = cos(omega), sin_step = sin(omega);
+        double i_sum{ 0.0 }, q_sum{ 0.0 };
+        for (qsizetype n = n0; n < n1; ++n) {
+            const double v = buffer[n - begin];
+            i_sum += v * cos_phase;
+            q_sum -= v * sin_phase;
+            // 旋转递推载波相位，避免逐点三角函数
+            const double c = cos_phase * cos_step - sin_phase * sin_step;
+            sin_phase = sin_phase * cos_step + cos_phase * sin_step;
+            cos_phase = c;
+        }
+        const double norm = 2.0 / (n1 - n0);
+        const int cx = static_cast<int>((i_sum * norm + kAmplitudeRange) * c_scale);
+        const int cy = static_cast<int>((kAmplitudeRange - q_sum * norm) * c_scale);
+        if (cx >= 0 && cx < kConstellationSize && cy >= 0 && cy < kConstellationSize) {
+            ++constellation[cy * kConstellationSize + cx];
+        }
+    }
+    // 合并到共享直方图
+    QMutexLocker locker(&job.mutex);
+    for (size_t i = 0; i < eye.size(); ++i) {
+        job.eye_histogram[i] += eye[i];
+    }
+    for (size_t i = 0; i < constellation.size(); ++i) {
+        job.constellation_histogram[i] += constellation[i];
+    }
+    job.processed_symbols += last_symbol - first_symbol;
+}
+
+void EyeDiagramView::RenderImages()
+{
+    if (!job_) {
+        return;
+    }
+    std::vector<quint32> eye, constellation;
+    {
+        QMutexLocker locker(&job_->mutex);
+        eye = job_->eye_histogram;
+        constellation = job_->constellation_histogram;
+    }
+    // 对数密度映射，使稀疏轨迹和密集区域都可见
+    auto render = [this](const std::vector<quint32> &histogram, QImage &image) {
+        quint32 max_count{ 1 };
+        for (auto count : histogram) {
+            max_count = qMax(max_count, count);
+        }
+        const double scale = 255.0 / log1p(static_cast<double>(max_count));
+        for (int y = 0; y < image.height(); ++y) {
+            auto *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+            for (int x = 0; x < image.width(); ++x) {
+                const auto count = histogram[y * image.width() + x];
+                line[x] = color_table_[count ? qBound(1, static_cast<int>(log1p(count) * scale), 255) : 0];
+            }
+        }
+    };
+    render(eye, eye_image_);
+    render(constellation, constellation_image_);
+    update();
+}
+
+void EyeDiagramView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::white);
+    // 字体设置
+    QFont font = painter.font();
+    font.setBold(true);
+    painter.setFont(font);
+    const int title_height = painter.fontMetrics().height() + 4;
+    QString title = (display_mode_ == kEyeDiagram) ? "Eye Diagram" : "Constellation";
+    if (job_) {
+        title += QString(" (%1 / %2 symbols)").arg(job_->processed_symbols.load()).arg(job_->total_symbols);
+    }
+    painter.drawText(QRect(0, 0, width(), title_height), Qt::AlignCenter, title);
+    const QRect area(4, title_height, width() - 8, height() - title_height - 4);
+    if (area.width() <= 0 || area.height() <= 0) {
+        return;
+    }
+    if (display_mode_ == kEyeDiagram) {
+        painter.drawImage(area, eye_image_);
+    } else {
+        // 星座图保持正方形
+        const int side = qMin(area.width(), area.height());
+        const QRect square(area.left() + (area.width() - side) / 2, area.top() + (area.height() - side) / 2, side, side);
+        painter.drawImage(square, constellation_image_);
+        painter.setPen(QPen(Qt::gray, 1, Qt::DashLine));
+        painter.drawLine(square.center().x(), square.top(), square.center().x(), square.bottom());
+        painter.drawLine(square.left(), square.center().y(), square.right(), square.center().y());
+    }
+}
+
+void EyeDiagramView::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    set_display_mode(display_mode_ == kEyeDiagram ? kConstellation : kEyeDiagram);
+    event->accept();
+}
@@ -0,0 +1,87 @@
+﻿#pragma once
+
+#include <QWidget>
+#include <QImage>
+#include <QTimer>
+#include <QMutex>
+#include <QFutureWatcher>
+#include <QAudioFormat>
+#include <QFile>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class EyeDiagramView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    enum DisplayMode_t {
+        kEyeDiagram,
+        kConstellation
+    };
+
+public:
+    EyeDiagramView(QWidget *parent);
+    ~EyeDiagramView();
+
+    void set_display_mode(DisplayMode_t mode) { display_mode_ = mode; update(); }
+    DisplayMode_t get_display_mode() const { return display_mode_; }
+
+    // 对整段信号在后台分块并行累积眼图和星座图
+    void AccumulateSignal(const QList<double> &samples, double sample_rate, double samples_per_symbol, double carrier_freq);
+    // 从PCM文件中data_offset处开始的音频数据（内存映射读取）
+    void AccumulateSignal(const QString &file_path, qint64 data_offset, const QAudioFormat &format, double samples_per_symbol, double carrier_freq);
+    void CancelAccumulation();
+
+public:
+    static constexpr int kEyeWidth{ 256 };              // 眼图横向分辨率（两个符号周期）
+    static constexpr int kEyeHeight{ 160 };             // 眼图纵向分辨率
+    static constexpr int kConstellationSize{ 160 };     // 星座图分辨率
+    static constexpr double kAmplitudeRange{ 1.25 };    // 显示幅度范围 [-range, range]
+    static constexpr qsizetype kSymbolsPerChunk{ 8192 }; // 每个并行任务处理的符号数
+    static constexpr int kRefreshInterval{ 100 };       // 增量刷新间隔（毫秒）
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    // 双击切换眼图/星座图
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+    // 待分析的信号（隐式共享，不复制样本）
+    struct SignalSource {
+        QList<double> samples;
+        std::shared_ptr<QFile> mapped_file;
+        const uchar *pcm_data{ nullptr };
+        QAudioFormat format;
+        qsizetype sample_count{ 0 };
+        void Read(qsizetype begin, qsizetype end, float *out) const;
+    };
+    // 一次累积任务的共享状态，由各个并行分块共同写入
+    struct AccumulationJob {
+        SignalSource source;
+        double sample_rate{ 0.0 };
+        double samples_per_symbol{ 0.0 };
+        double carrier_freq{ 0.0 };
+        qsizetype total_symbols{ 0 };
+        QList<qsizetype> chunk_starts;
+        QMutex mutex;
+        std::vector<quint32> eye_histogram;
+        std::vector<quint32> constellation_histogram;
+        std::atomic<qsizetype> processed_symbols{ 0 };
+    };
+
+    void StartJob(const std::shared_ptr<AccumulationJob> &job);
+    void ResetJob();
+    static void AccumulateChunk(AccumulationJob &job, qsizetype first_symbol);
+    void RenderImages();
+
+private:
+    DisplayMode_t display_mode_{ kEyeDiagram };
+    std::shared_ptr<AccumulationJob> job_;
+    QFutureWatcher<void> *watcher_;
+    QTimer *refresh_timer_;
+    QImage eye_image_;
+    QImage constellation_image_;
+    QList<QRgb> color_table_;
+};
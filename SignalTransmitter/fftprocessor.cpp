@@ -0,0 +1,132 @@
+﻿#include "fftprocessor.h"
+#include <QtMath>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define FFT_USE_SSE
+#endif
+
+FftProcessor::FftProcessor(int fft_size)
+    : fft_size_(fft_size)
+    , half_size_(fft_size / 2)
+{
+    // 汉宁窗，并计算使满幅正弦波对应0 dBFS的幅度修正系数
+    window_.resize(fft_size_);
+    double window_sum{ 0.0 };
+    for (int n = 0; n < fft_size_; ++n) {
+        window_[n] = static_cast<float>(0.5 - 0.5 * cos(2.0 * M_PI * n / fft_size_));
+        window_sum += window_[n];
+    }
+    window_scale_ = static_cast<float>(2.0 / window_sum);
+    // 位反转表
+    bit_reverse_.resize(half_size_);
+    int bits{ 0 };
+    while ((1 << bits) < half_size_) {
+        ++bits;
+    }
+    for (int i = 0; i < half_size_; ++i) {
+        int r{ 0 };
+        for (int b = 0; b < bits; ++b) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        bit_reverse_[i] = r;
+    }
+    // 各级旋转因子，第m级（半跨度为m）需要m个，按级连续存放便于向量化读取
+    twiddle_re_.resize(qMax(1, half_size_ - 1));
+    twiddle_im_.resize(qMax(1, half_size_ - 1));
+    for (int m = 1; m < half_size_; m *= 2) {
+        for (int j = 0; j < m; ++j) {
+            const double angle = -M_PI * j / m;
+            twiddle_re_[m - 1 + j] = static_cast<float>(cos(angle));
+            twiddle_im_[m - 1 + j] = static_cast<float>(sin(angle));
+        }
+    }
+    // 实数FFT后处理旋转因子
+    post_re_.resize(half_size_ + 1);
+    post_im_.resize(half_size_ + 1);
+    for (int k = 0; k <= half_size_; ++k) {
+        const double angle = -2.0 * M_PI * k / fft_size_;
+        post_re_[k] = static_cast<float>(cos(angle));
+        post_im_[k] = static_cast<float>(sin(angle));
+    }
+    work_re_.resize(half_size_);
+    work_im_.resize(half_size_);
+}
+
+void FftProcessor::ComplexFft(float *re, float *im) const
+{
+    const int n = half_size_;
+    // 位反转重排
+    for (int i = 0; i < n; ++i) {
+        const int j = bit_reverse_[i];
+        if (j > i) {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+    // 逐级蝶形运算
+    for (int m = 1; m < n; m *= 2) {
+        const float *wr = twiddle_re_.data() + m - 1;
+        const float *wi = twiddle_im_.data() + m - 1;
+        for (int k = 0; k < n; k += 2 * m) {
+            float *ar = re + k;
+            float *ai = im + k;
+            float *br = re + k + m;
+            float *bi = im + k + m;
+            int j{ 0 };
+#ifdef FFT_USE_SSE
+            for (; j + 4 <= m; j += 4) {
+                const __m128 vwr = _mm_loadu_ps(wr + j);
+                const __m128 vwi = _mm_loadu_ps(wi + j);
+                const __m128 vbr = _mm_loadu_ps(br + j);
+                const __m128 vbi = _mm_loadu_ps(bi + j);
+                const __m128 tr = _mm_sub_ps(_mm_mul_ps(vbr, vwr), _mm_mul_ps(vbi, vwi));
+                const __m128 ti = _mm_add_ps(_mm_mul_ps(vbr, vwi), _mm_mul_ps(vbi, vwr));
+                const __m128 var = _mm_loadu_ps(ar + j);
+                const __m128 vai = _mm_loadu_ps(ai + j);
+                _mm_storeu_ps(br + j, _mm_sub_ps(var, tr));
+                _mm_storeu_ps(bi + j, _mm_sub_ps(vai, ti));
+                _mm_storeu_ps(ar + j, _mm_add_ps(var, tr));
+                _mm_storeu_ps(ai + j, _mm_add_ps(vai, ti));
+            }
+#endif
+            for (; j < m; ++j) {
+                const float tr = br[j] * wr[j] - bi[j] * wi[j];
+                const float ti = br[j] * wi[j] + bi[j] * wr[j];
+                br[j] = ar[j] - tr;
+                bi[j] = ai[j] - ti;
+                ar[j] += tr;
+                ai[j] += ti;
+            }
+        }
+    }
+}
+
+void FftProcessor::ComputePowerSpectrum(const float *input, float *power_db)
+{
+    // 偶数下标样本作实部、奇数下标样本作虚部，打包成N/2点复数序列
+    float *re = work_re_.data();
+    float *im = work_im_.data();
+    for (int n = 0; n < half_size_; ++n) {
+        re[n] = input[2 * n] * window_[2 * n];
+        im[n] = input[2 * n + 1] * window_[2 * n + 1];
+    }
+    ComplexFft(re, im);
+    // 拆分出实数序列的频谱 X[k] = E[k] + W^k * O[k]
+    const float scale2 = window_scale_ * window_scale_;
+    for (int k = 0; k <= half_size_; ++k) {
+        const int k0 = (k == half_size_) ? 0 : k;
+        const int k1 = (k == 0) ? 0 : half_size_ - k;
+        const float zr = re[k0], zi = im[k0];
+        const float cr = re[k1], ci = -im[k1];
+        const float er = 0.5f * (zr + cr);
+        const float ei = 0.5f * (zi + ci);
+        const float o_r = 0.5f * (zi - ci);
+        const float o_i = -0.5f * (zr - cr);
+        const float xr = er + post_re_[k] * o_r - post_im_[k] * o_i;
+        const float xi = ei + post_re_[k] * o_i + post_im_[k] * o_r;
+        const float power = (xr * xr + xi * xi) * scale2;
+        power_db[k] = 10.0f * log10f(power + 1e-12f);
+    }
+}
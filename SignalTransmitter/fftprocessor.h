@@ -0,0 +1,37 @@
+﻿#pragma once
+
+#include <vector>
+
+// 实数FFT处理器
+// 构造时预先计算窗函数、位反转表和各级旋转因子（即FFT计划），之后每帧只做蝶形运算
+// 实数FFT通过N/2点复数FFT加后处理实现，蝶形运算在x64下使用SSE每次处理4个点
+class FftProcessor
+{
+public:
+    explicit FftProcessor(int fft_size);
+
+    int get_fft_size() const { return fft_size_; }
+    int get_bin_count() const { return fft_size_ / 2 + 1; }
+
+    // 对fft_size个实数样本加汉宁窗，输出bin_count个功率谱值（dBFS）
+    void ComputePowerSpectrum(const float *input, float *power_db);
+
+private:
+    void ComplexFft(float *re, float *im) const;
+
+private:
+    int fft_size_;
+    int half_size_;
+    std::vector<float> window_;
+    float window_scale_{ 1.0f };
+    // N/2点复数FFT的计划
+    std::vector<int> bit_reverse_;
+    std::vector<float> twiddle_re_;     // 按级连续存放，第m级从下标m-1开始
+    std::vector<float> twiddle_im_;
+    // 实数FFT后处理旋转因子 e^{-j2πk/N}
+    std::vector<float> post_re_;
+    std::vector<float> post_im_;
+    // 工作缓冲区（避免每帧分配）
+    std::vector<float> work_re_;
+    std::vector<float> work_im_;
+};
@@ -0,0 +1,118 @@
+﻿#include "filepreview.h"
+#include <QFileInfo>
+#include <QPainter>
+#include <cstring>
+
+FilePreview::~FilePreview()
+{
+    // 关闭文件同时解除映射
+    file_.close();
+}
+
+bool FilePreview::Open(const QString &file_path)
+{
+    file_.close();
+    data_ = nullptr;
+    size_ = 0;
+    text_offset_ = 0;
+    is_wav_ = false;
+    is_binary_ = false;
+    error_.clear();
+    file_.setFileName(file_path);
+    if (!file_.open(QIODevice::ReadOnly)) {
+        error_ = QString("无法打开文件: %1").arg(file_.errorString());
+        return false;
+    }
+    size_ = file_.size();
+    if (size_ == 0) {
+        error_ = "文件为空";
+        return false;
+    }
+    // 映射不读取文件内容，只有访问到的页面才从磁盘读入
+    data_ = file_.map(0, size_);
+    if (!data_) {
+        error_ = QString("无法映射文件: %1").arg(file_.errorString());
+        return false;
+    }
+    // 解析头部只访问各块的块头所在页面
+    is_wav_ = ParseWavHeader(data_, size_, wav_info_) && wav_info_.block_align > 0;
+    if (!is_wav_) {
+        // 文本编码按BOM判断，默认UTF-8
+        const auto encoding = QStringConverter::encodingForData(QByteArrayView(data_, qMin<qint64>(size_, 4)));
+        decoder_ = QStringDecoder(encoding.value_or(QStringConverter::Utf8));
+        is_binary_ = !encoding && memchr(data_, 0, static_cast<size_t>(qMin(size_, kBinaryProbeBytes))) != nullptr;
+    }
+    return true;
+}
+
+QString FilePreview::ReadText(qint64 max_bytes)
+{
+    if (!data_ || is_wav_ || is_binary_ || IsTextAtEnd()) {
+        return QString();
+    }
+    const qint64 count = qMin(max_bytes, qMin(size_, kMaxTextBytes) - text_offset_);
+    // 解码器保留跨段的不完整字符
+    QString text = decoder_.decode(QByteArrayView(data_ + text_offset_, count));
+    text_offset_ += count;
+    text.remove(QChar('\r'));
+    return text;
+}
+
+QString FilePreview::WavSummary() const
+{
+    if (!is_wav_) {
+        return QString();
+    }
+    const qint64 frames = wav_info_.get_frame_count();
+    const double seconds = wav_info_.sample_rate > 0 ? static_cast<double>(frames) / wav_info_.sample_rate : 0.0;
+    return QString("%1\n格式: %2%3 位%4\n采样率: %5 Hz, 声道数: %6\n时长: %7 秒 (%8 帧)\n文件大小: %9 字节")
+        .arg(QFileInfo(file_.fileName()).fileName())
+        .arg(wav_info_.is_rf64 ? "RF64, " : "")
+        .arg(wav_info_.bits_per_sample)
+        .arg(wav_info_.format_tag == WavInfo::kFormatFloat ? "浮点" : "PCM")
+        .arg(wav_info_.sample_rate)
+        .arg(wav_info_.channels)
+        .arg(seconds, 0, 'f', 2)
+        .arg(frames)
+        .arg(size_);
+}
+
+QImage FilePreview::WavThumbnail(const QSize &size) const
+{
+    if (!is_wav_ || size.isEmpty()) {
+        return QImage();
+    }
+    QImage image(size, QImage::Format_RGB32);
+    image.fill(Qt::white);
+    QPainter painter(&image);
+    const int w = size.width();
+    const int h = size.height();
+    const double mid = h / 2.0;
+    painter.setPen(Qt::lightGray);
+    painter.drawLine(0, qRound(mid), w, qRound(mid));
+    const qint64 frames = wav_info_.get_frame_count();
+    if (frames <= 0) {
+        return image;
+    }
+    // 每列只取起始处的一小段连续样本（第一声道），大文件每列只访问一两个页面
+    const double frames_per_column = static_cast<double>(frames) / w;
+    const qint64 span = qMax<qint64>(1, qMin<qint64>(kThumbnailFramesPerColumn, static_cast<qint64>(frames_per_column)));
+    const uchar *samples = data_ + wav_info_.data_offset;
+    painter.setPen(QColor(0, 102, 204));
+    for (int x = 0; x < w; ++x) {
+        const qint64 first = static_cast<qint64>(x * frames_per_column);
+        const qint64 last = qMin(frames, first + span);
+        float lo = 1.0f;
+        float hi = -1.0f;
+        for (qint64 frame = first; frame < last; ++frame) {
+            const float v = LoadNormalizedSample(samples + frame * wav_info_.block_align, wav_info_);
+            lo = qMin(lo, v);
+            hi = qMax(hi, v);
+        }
+        if (lo > hi) {
+            continue;
+        }
+        painter.drawLine(x, qRound(mid - qBound(-1.0f, hi, 1.0f) * mid), x, qRound(mid - qBound(-1.0f, lo, 1.0f) * mid));
+    }
+    return image;
+}
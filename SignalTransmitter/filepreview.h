@@ -0,0 +1,54 @@
+﻿#pragma once
+
+#include <QFile>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QStringDecoder>
+#include "wavfile.h"
+
+// 待传输文件的预览
+// 文件只做映射，不整体读入：文本按需分段解码（滚动到末尾时再取下一段），最多解码kMaxTextBytes；
+// WAV文件显示头部信息，缩略图每列只读取一小段样本，大文件也只访问少量页面。
+// Open在界面线程调用，WavThumbnail可在后台线程调用（只读访问映射）。
+class FilePreview
+{
+public:
+    FilePreview() = default;
+    ~FilePreview();
+
+    bool Open(const QString &file_path);
+    bool IsOpen() const { return data_ != nullptr; }
+    const QString &get_error() const { return error_; }
+    qint64 get_file_size() const { return size_; }
+
+    // 开头含有NUL字节且没有UTF-16/32 BOM的非WAV文件（如.stfl）不作为文本预览
+    bool IsBinary() const { return is_binary_; }
+    // 文本：解码下一段（至多max_bytes字节），到达文件末尾或上限后返回空字符串
+    QString ReadText(qint64 max_bytes = kTextChunk);
+    bool IsTextAtEnd() const { return text_offset_ >= qMin(size_, kMaxTextBytes); }
+    // 是否因超过上限而未预览到文件末尾
+    bool IsTextTruncated() const { return IsTextAtEnd() && text_offset_ < size_; }
+
+    // WAV文件
+    bool IsWav() const { return is_wav_; }
+    const WavInfo &get_wav_info() const { return wav_info_; }
+    QString WavSummary() const;
+    QImage WavThumbnail(const QSize &size) const;
+
+    static constexpr qint64 kTextChunk{ 64 * 1024 };                // 每次解码的文本字节数（约数屏）
+    static constexpr qint64 kMaxTextBytes{ 16 * 1024 * 1024 };      // 文本预览的总上限
+    static constexpr qint64 kBinaryProbeBytes{ 4096 };
+    static constexpr int kThumbnailFramesPerColumn{ 256 };          // 缩略图每列读取的帧数
+
+private:
+    QFile file_;
+    const uchar *data_{ nullptr };
+    qint64 size_{ 0 };
+    QString error_;
+    QStringDecoder decoder_;
+    qint64 text_offset_{ 0 };
+    bool is_wav_{ false };
+    bool is_binary_{ false };
+    WavInfo wav_info_;
+};
@@ -0,0 +1,128 @@
+﻿#include "ingestwriter.h"
+#include <QtConcurrent>
+#include <cstring>
+#include <limits>
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+
+IngestWriter::IngestWriter()
+{}
+
+IngestWriter::~IngestWriter()
+{
+    Close();
+}
+
+bool IngestWriter::Open(const QString &file_path, qint64 expected_size)
+{
+    Close();
+    file_.setFileName(file_path);
+    // 自行缓冲，关闭QFile的内部缓冲避免二次拷贝
+    if (!file_.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        return false;
+    }
+    for (auto &buffer : buffers_) {
+        if (!buffer) {
+            buffer.reset(static_cast<char *>(::operator new[](kBufferSize, std::align_val_t(kBufferAlignment))));
+        }
+    }
+    current_ = 0;
+    buffered_ = 0;
+    bytes_written_ = 0;
+    allocated_ = 0;
+    failed_ = false;
+    Preallocate(expected_size >= 0 ? expected_size : kPreallocateStep);
+    return true;
+}
+
+void IngestWriter::Preallocate(qint64 size)
+{
+    if (size <= allocated_) {
+        return;
+    }
+#ifdef Q_OS_LINUX
+    // 只分配磁盘空间，不改变文件长度；文件系统不支持时忽略
+    if (fallocate(file_.handle(), FALLOC_FL_KEEP_SIZE, allocated_, size - allocated_) != 0) {
+        allocated_ = std::numeric_limits<qint64>::max();
+        return;
+    }
+#else
+    // 其他平台先设置文件长度，关闭时截断到实际大小；改变长度前等待线程池中的写入完成
+    if (!WaitPending() || !file_.resize(size)) {
+        allocated_ = std::numeric_limits<qint64>::max();
+        return;
+    }
+#endif
+    allocated_ = size;
+}
+
+bool IngestWriter::Write(const char *data, qint64 size)
+{
+    if (!file_.isOpen() || failed_) {
+        return false;
+    }
+    bytes_written_ += size;
+    if (bytes_written_ > allocated_) {
+        Preallocate(bytes_written_ + kPreallocateStep);
+    }
+    while (size > 0) {
+        const qint64 n = qMin(size, kBufferSize - buffered_);
+        memcpy(buffers_[current_].get() + buffered_, data, static_cast<size_t>(n));
+        buffered_ += n;
+        data += n;
+        size -= n;
+        if (buffered_ == kBufferSize && !SubmitBuffer()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IngestWriter::SubmitBuffer()
+{
+    // 另一块缓冲区写完后才能交出当前块，保证写入顺序
+    if (!WaitPending()) {
+        return false;
+    }
+    QFile *file = &file_;
+    const char *data = buffers_[current_].get();
+    const qint64 size = buffered_;
+    pending_ = QtConcurrent::run([file, data, size]() {
+        return file->write(data, size) == size;
+    });
+    current_ = 1 - current_;
+    buffered_ = 0;
+    return true;
+}
+
+bool IngestWriter::WaitPending()
+{
+    if (pending_.isValid()) {
+        pending_.waitForFinished();
+        if (!pending_.result()) {
+            failed_ = true;
+        }
+        pending_ = QFuture<bool>();
+    }
+    return !failed_;
+}
+
+bool IngestWriter::Close()
+{
+    if (!file_.isOpen()) {
+        return !failed_;
+    }
+    // 线程池中的写入完成后才能写出剩余数据和调整文件长度
+    bool ok = WaitPending();
+    if (ok && buffered_ > 0) {
+        ok = file_.write(buffers_[current_].get(), buffered_) == buffered_;
+    }
+    buffered_ = 0;
+#ifndef Q_OS_LINUX
+    ok = file_.resize(bytes_written_) && ok;
+#endif
+    file_.close();
+    failed_ = !ok;
+    return ok;
+}
@@ -0,0 +1,51 @@
+﻿#pragma once
+
+#include <QFile>
+#include <QFuture>
+#include <QString>
+#include <memory>
+#include <new>
+
+// 上传文件写入器
+// 数据先复制到按页对齐的大块缓冲区，写满后整块交给线程池写入磁盘，同时继续填充另一块（双缓冲），
+// 网络线程只在磁盘慢于网络时等待。打开时按预期大小预分配空间（Linux下fallocate，不改变文件长度），
+// 大小未知时按kPreallocateStep逐段扩展，多个客户端同时上传时文件也不易产生碎片。
+class IngestWriter
+{
+public:
+    IngestWriter();
+    ~IngestWriter();
+
+    // expected_size小于0表示大小未知（实时流）
+    bool Open(const QString &file_path, qint64 expected_size);
+    bool Write(const char *data, qint64 size);
+    // 写出剩余数据并关闭，文件长度为实际写入的字节数
+    bool Close();
+    bool IsOpen() const { return file_.isOpen(); }
+
+    QString get_file_path() const { return file_.fileName(); }
+    qint64 get_bytes_written() const { return bytes_written_; }
+
+    static constexpr qint64 kBufferSize{ 4 * 1024 * 1024 };
+    static constexpr size_t kBufferAlignment{ 4096 };
+    static constexpr qint64 kPreallocateStep{ 64 * 1024 * 1024 };
+
+private:
+    bool SubmitBuffer();
+    bool WaitPending();
+    void Preallocate(qint64 size);
+
+private:
+    struct AlignedDeleter {
+        void operator()(char *p) const { ::operator delete[](p, std::align_val_t(kBufferAlignment)); }
+    };
+
+    QFile file_;
+    std::unique_ptr<char[], AlignedDeleter> buffers_[2];
+    int current_{ 0 };
+    qint64 buffered_{ 0 };
+    QFuture<bool> pending_;             // 正在写入磁盘的另一块缓冲区
+    qint64 bytes_written_{ 0 };         // 已接收的字节数（含尚在缓冲区中的）
+    qint64 allocated_{ 0 };
+    bool failed_{ false };
+};
@@ -0,0 +1,651 @@
+﻿#include "losslesscodec.h"
+#include "wavfile.h"
+#include "wavstreamwriter.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <QtMath>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+enum SubframeType_t {
+    kSubframeVerbatim = 0,
+    kSubframeFixed = 1,
+    kSubframeLpc = 2
+};
+
+// 高位在前的位写入器
+class BitWriter
+{
+public:
+    void Write(quint64 value, int bits) {
+        for (int i = bits - 1; i >= 0; --i) {
+            WriteBit((value >> i) & 1);
+        }
+    }
+    void WriteSigned(qint64 value, int bits) { Write(static_cast<quint64>(value) & ((bits == 64) ? ~0ULL : ((1ULL << bits) - 1)), bits); }
+    void WriteUnary(quint64 zeros) {
+        for (quint64 i = 0; i < zeros; ++i) {
+            WriteBit(0);
+        }
+        WriteBit(1);
+    }
+    QByteArray Finish() {
+        if (bit_count_ > 0) {
+            bytes_.append(static_cast<char>(current_ << (8 - bit_count_)));
+            current_ = 0;
+            bit_count_ = 0;
+        }
+        return bytes_;
+    }
+
+private:
+    void WriteBit(int bit) {
+        current_ = static_cast<quint8>((current_ << 1) | bit);
+        if (++bit_count_ == 8) {
+            bytes_.append(static_cast<char>(current_));
+            current_ = 0;
+            bit_count_ = 0;
+        }
+    }
+
+private:
+    QByteArray bytes_;
+    quint8 current_{ 0 };
+    int bit_count_{ 0 };
+};
+
+class BitReader
+{
+public:
+    BitReader(const uchar *data, qint64 size) : data_(data), size_bits_(size * 8) {}
+
+    bool Read(int bits, quint64 &value) {
+        if (position_ + bits > size_bits_) {
+            return false;
+        }
+        value = 0;
+        for (int i = 0; i < bits; ++i, ++position_) {
+            value = (value << 1) | ((data_[position_ >> 3] >> (7 - (position_ & 7))) & 1);
+        }
+        return true;
+    }
+    bool ReadSigned(int bits, qint64 &value) {
+        quint64 raw;
+        if (!Read(bits, raw)) {
+            return false;
+        }
+        // 符号扩展
+        const int shift = 64 - bits;
+        value = static_cast<qint64>(raw << shift) >> shift;
+        return true;
+    }
+    bool ReadUnary(quint64 &zeros) {
+        zeros = 0;
+        while (position_ < size_bits_) {
+            const int bit = (data_[position_ >> 3] >> (7 - (position_ & 7))) & 1;
+            ++position_;
+            if (bit) {
+                return true;
+            }
+            ++zeros;
+        }
+        return false;
+    }
+
+private:
+    const uchar *data_;
+    qint64 size_bits_;
+    qint64 position_{ 0 };
+};
+
+inline quint64 ZigZag(qint64 v) { return (static_cast<quint64>(v) << 1) ^ static_cast<quint64>(v >> 63); }
+inline qint64 UnZigZag(quint64 u) { return static_cast<qint64>(u >> 1) ^ -static_cast<qint64>(u & 1); }
+
+// 单个分区选取最优Rice参数，返回编码位数
+qint64 BestRiceParameter(const quint64 *values, int count, int &parameter)
+{
+    quint64 sum{ 0 };
+    for (int i = 0; i < count; ++i) {
+        sum += values[i];
+    }
+    // 以均值的对数为初值，在附近搜索精确位数最少的参数
+    int guess{ 0 };
+    const quint64 mean = count > 0 ? sum / count : 0;
+    while (guess < 30 && (1ULL << (guess + 1)) <= mean) {
+        ++guess;
+    }
+    qint64 best_bits{ -1 };
+    for (int k = qMax(0, guess - 1); k <= qMin(30, guess + 1); ++k) {
+        qint64 bits = static_cast<qint64>(count) * (k + 1);
+        for (int i = 0; i < count; ++i) {
+            bits += static_cast<qint64>(values[i] >> k);
+        }
+        if (best_bits < 0 || bits < best_bits) {
+            best_bits = bits;
+            parameter = k;
+        }
+    }
+    return best_bits + 5;
+}
+
+qint64 ResidualBits(const std::vector<quint64> &residual)
+{
+    qint64 bits{ 0 };
+    for (size_t start = 0; start < residual.size(); start += LosslessCodec::kPartitionSamples) {
+        const int count = static_cast<int>(qMin<size_t>(LosslessCodec::kPartitionSamples, residual.size() - start));
+        int k{ 0 };
+        bits += BestRiceParameter(residual.data() + start, count, k);
+    }
+    return bits;
+}
+
+void WriteResidual(BitWriter &writer, const std::vector<quint64> &residual)
+{
+    for (size_t start = 0; start < residual.size(); start += LosslessCodec::kPartitionSamples) {
+        const int count = static_cast<int>(qMin<size_t>(LosslessCodec::kPartitionSamples, residual.size() - start));
+        int k{ 0 };
+        BestRiceParameter(residual.data() + start, count, k);
+        writer.Write(k, 5);
+        for (int i = 0; i < count; ++i) {
+            const quint64 u = residual[start + i];
+            writer.WriteUnary(u >> k);
+            writer.Write(u & ((1ULL << k) - 1), k);
+        }
+    }
+}
+
+bool ReadResidual(BitReader &reader, qint64 *residual, int count)
+{
+    for (int start = 0; start < count; start += LosslessCodec::kPartitionSamples) {
+        const int n = qMin(LosslessCodec::kPartitionSamples, count - start);
+        quint64 k;
+        if (!reader.Read(5, k)) {
+            return false;
+        }
+        for (int i = 0; i < n; ++i) {
+            quint64 q, r;
+            if (!reader.ReadUnary(q) || !reader.Read(static_cast<int>(k), r)) {
+                return false;
+            }
+            residual[start + i] = UnZigZag((q << k) | r);
+        }
+    }
+    return true;
+}
+
+// 固定多项式预测残差
+void FixedResidual(const qint32 *x, int n, int order, std::vector<quint64> &residual)
+{
+    residual.resize(n - order);
+    for (int i = order; i < n; ++i) {
+        qint64 prediction{ 0 };
+        switch (order) {
+        case 1: prediction = x[i - 1]; break;
+        case 2: prediction = 2LL * x[i - 1] - x[i - 2]; break;
+        case 3: prediction = 3LL * x[i - 1] - 3LL * x[i - 2] + x[i - 3]; break;
+        case 4: prediction = 4LL * x[i - 1] - 6LL * x[i - 2] + 4LL * x[i - 3] - x[i - 4]; break;
+        default: break;
+        }
+        residual[i - order] = ZigZag(x[i] - prediction);
+    }
+}
+
+qint64 FixedPrediction(const qint64 *x, int i, int order)
+{
+    switch (order) {
+    case 1: return x[i - 1];
+    case 2: return 2 * x[i - 1] - x[i - 2];
+    case 3: return 3 * x[i - 1] - 3 * x[i - 2] + x[i - 3];
+    case 4: return 4 * x[i - 1] - 6 * x[i - 2] + 4 * x[i - 3] - x[i - 4];
+    default: return 0;
+    }
+}
+
+// 加窗自相关后用Levinson-Durbin递推求各阶预测系数，lpc[m]为m+1阶的系数
+void ComputeLpc(const qint32 *x, int n, int max_order, std::vector<std::vector<double>> &lpc)
+{
+    std::vector<double> windowed(n);
+    for (int i = 0; i < n; ++i) {
+        const double w = 0.5 - 0.5 * std::cos(2.0 * M_PI * (i + 0.5) / n);
+        windowed[i] = x[i] * w;
+    }
+    std::vector<double> r(max_order + 1, 0.0);
+    for (int lag = 0; lag <= max_order; ++lag) {
+        double sum{ 0.0 };
+        for (int i = lag; i < n; ++i) {
+            sum += windowed[i] * windowed[i - lag];
+        }
+        r[lag] = sum;
+    }
+    lpc.clear();
+    if (r[0] <= 0.0) {
+        return;
+    }
+    std::vector<double> a(max_order + 1, 0.0), previous(max_order + 1, 0.0);
+    double error = r[0];
+    for (int m = 1; m <= max_order; ++m) {
+        double acc = r[m];
+        for (int j = 1; j < m; ++j) {
+            acc -= previous[j] * r[m - j];
+        }
+        const double k = acc / error;
+        a[m] = k;
+        for (int j = 1; j < m; ++j) {
+            a[j] = previous[j] - k * previous[m - j];
+        }
+        error *= (1.0 - k * k);
+        lpc.emplace_back(a.begin() + 1, a.begin() + m + 1);
+        previous = a;
+        if (error <= 0.0) {
+            break;
+        }
+    }
+}
+
+// 系数量化为定点整数，返回右移位数
+int QuantizeLpc(const std::vector<double> &coefficients, std::vector<qint32> &quantized)
+{
+    double max_abs{ 0.0 };
+    for (double c : coefficients) {
+        max_abs = qMax(max_abs, std::abs(c));
+    }
+    int exponent{ 0 };
+    std::frexp(max_abs, &exponent);
+    const int shift = qBound(0, LosslessCodec::kLpcPrecision - 1 - exponent, 31);
+    const qint32 q_max = (1 << (LosslessCodec::kLpcPrecision - 1)) - 1;
+    quantized.resize(coefficients.size());
+    // 误差反馈量化，减小舍入误差的累积
+    double error{ 0.0 };
+    for (size_t i = 0; i < coefficients.size(); ++i) {
+        // shift最大为31，1 << 31溢出为负数，用ldexp精确乘以2的幂
+        error += std::ldexp(coefficients[i], shift);
+        const qint32 q = qBound(-q_max - 1, static_cast<qint32>(std::lround(error)), q_max);
+        quantized[i] = q;
+        error -= q;
+    }
+    return shift;
+}
+
+void LpcResidual(const qint32 *x, int n, const std::vector<qint32> &q, int shift, std::vector<quint64> &residual)
+{
+    const int order = static_cast<int>(q.size());
+    residual.resize(n - order);
+    for (int i = order; i < n; ++i) {
+        qint64 sum{ 0 };
+        for (int j = 0; j < order; ++j) {
+            sum += static_cast<qint64>(q[j]) * x[i - 1 - j];
+        }
+        residual[i - order] = ZigZag(x[i] - (sum >> shift));
+    }
+}
+
+void EncodeSubframe(BitWriter &writer, const qint32 *x, int n, int bits, bool predictable)
+{
+    if (!predictable) {
+        writer.Write(kSubframeVerbatim, 2);
+        for (int i = 0; i < n; ++i) {
+            writer.WriteSigned(x[i], bits);
+        }
+        return;
+    }
+    // 原样保存的位数作为基准
+    qint64 best_bits = static_cast<qint64>(n) * bits;
+    int best_type{ kSubframeVerbatim };
+    int best_order{ 0 };
+    std::vector<quint64> residual, best_residual;
+    // 固定多项式预测
+    for (int order = 0; order <= 4 && order < n; ++order) {
+        FixedResidual(x, n, order, residual);
+        const qint64 total = 3 + static_cast<qint64>(order) * bits + ResidualBits(residual);
+        if (total < best_bits) {
+            best_bits = total;
+            best_type = kSubframeFixed;
+            best_order = order;
+            best_residual.swap(residual);
+        }
+    }
+    // LPC预测
+    std::vector<std::vector<double>> lpc;
+    std::vector<qint32> quantized, best_quantized;
+    int best_shift{ 0 };
+    ComputeLpc(x, n, qMin(LosslessCodec::kMaxLpcOrder, n - 1), lpc);
+    for (const auto &coefficients : lpc) {
+        const int order = static_cast<int>(coefficients.size());
+        const int shift = QuantizeLpc(coefficients, quantized);
+        LpcResidual(x, n, quantized, shift, residual);
+        const qint64 total = 5 + 4 + 5 + static_cast<qint64>(order) * (LosslessCodec::kLpcPrecision + bits) + ResidualBits(residual);
+        if (total < best_bits) {
+            best_bits = total;
+            best_type = kSubframeLpc;
+            best_order = order;
+            best_shift = shift;
+            best_quantized = quantized;
+            best_residual.swap(residual);
+        }
+    }
+    writer.Write(best_type, 2);
+    if (best_type == kSubframeVerbatim) {
+        for (int i = 0; i < n; ++i) {
+            writer.WriteSigned(x[i], bits);
+        }
+        return;
+    }
+    if (best_type == kSubframeFixed) {
+        writer.Write(best_order, 3);
+    } else {
+        writer.Write(best_order - 1, 5);
+        writer.Write(LosslessCodec::kLpcPrecision - 1, 4);
+        writer.Write(best_shift, 5);
+        for (qint32 q : best_quantized) {
+            writer.WriteSigned(q, LosslessCodec::kLpcPrecision);
+        }
+    }
+    // 预热样本原样保存
+    for (int i = 0; i < best_order; ++i) {
+        writer.WriteSigned(x[i], bits);
+    }
+    WriteResidual(writer, best_residual);
+}
+
+bool DecodeSubframe(BitReader &reader, qint64 *x, int n, int bits)
+{
+    quint64 type;
+    if (!reader.Read(2, type)) {
+        return false;
+    }
+    if (type == kSubframeVerbatim) {
+        for (int i = 0; i < n; ++i) {
+            if (!reader.ReadSigned(bits, x[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    quint64 order{ 0 }, shift{ 0 };
+    qint32 quantized[32]{};
+    if (type == kSubframeFixed) {
+        if (!reader.Read(3, order) || order > 4) {
+            return false;
+        }
+    } else if (type == kSubframeLpc) {
+        quint64 precision;
+        if (!reader.Read(5, order) || !reader.Read(4, precision) || !reader.Read(5, shift)) {
+            return false;
+        }
+        order += 1;
+        precision += 1;
+        for (quint64 j = 0; j < order; ++j) {
+            qint64 q;
+            if (!reader.ReadSigned(static_cast<int>(precision), q)) {
+                return false;
+            }
+            quantized[j] = static_cast<qint32>(q);
+        }
+    } else {
+        return false;
+    }
+    if (static_cast<int>(order) > n) {
+        return false;
+    }
+    for (quint64 i = 0; i < order; ++i) {
+        if (!reader.ReadSigned(bits, x[i])) {
+            return false;
+        }
+    }
+    // 残差先解到x中，再原地加上预测值
+    if (!ReadResidual(reader, x + order, n - static_cast<int>(order))) {
+        return false;
+    }
+    for (int i = static_cast<int>(order); i < n; ++i) {
+        if (type == kSubframeFixed) {
+            x[i] += FixedPrediction(x, i, static_cast<int>(order));
+        } else {
+            qint64 sum{ 0 };
+            for (quint64 j = 0; j < order; ++j) {
+                sum += static_cast<qint64>(quantized[j]) * x[i - 1 - j];
+            }
+            x[i] += sum >> shift;
+        }
+    }
+    return true;
+}
+
+// 样本在文件中的字节数与读写
+inline qint32 LoadSample(const uchar *p, int bits)
+{
+    switch (bits) {
+    case 8: return static_cast<qint32>(*p) - 128;
+    case 16: return qFromLittleEndian<qint16>(p);
+    case 24: return static_cast<qint32>((quint32(p[0]) << 8) | (quint32(p[1]) << 16) | (quint32(p[2]) << 24)) >> 8;
+    default: return qFromLittleEndian<qint32>(p);
+    }
+}
+
+inline void StoreSample(uchar *p, int bits, qint64 v)
+{
+    switch (bits) {
+    case 8: *p = static_cast<uchar>(v + 128); break;
+    case 16: qToLittleEndian<qint16>(static_cast<qint16>(v), p); break;
+    case 24: p[0] = static_cast<uchar>(v); p[1] = static_cast<uchar>(v >> 8); p[2] = static_cast<uchar>(v >> 16); break;
+    default: qToLittleEndian<qint32>(static_cast<qint32>(v), p); break;
+    }
+}
+
+bool ReadHeader(const uchar *data, qint64 size, LosslessCodec::Header &header, int &block_count)
+{
+    if (size < LosslessCodec::kHeaderSize || memcmp(data, LosslessCodec::kMagic, 4) != 0
+        || qFromLittleEndian<quint16>(data + 4) != LosslessCodec::kVersion) {
+        return false;
+    }
+    header.channels = qFromLittleEndian<quint16>(data + 6);
+    header.sample_rate = static_cast<int>(qFromLittleEndian<quint32>(data + 8));
+    header.bits_per_sample = qFromLittleEndian<quint16>(data + 12);
+    header.format_tag = qFromLittleEndian<quint16>(data + 14);
+    header.block_frames = static_cast<int>(qFromLittleEndian<quint32>(data + 16));
+    header.total_frames = static_cast<qint64>(qFromLittleEndian<quint64>(data + 20));
+    const qint64 stored_block_count = qFromLittleEndian<quint32>(data + 28);
+    const int bits = header.bits_per_sample;
+    // 文件可能来自网络：块长、声道数有上限（解码缓冲区大小有界），块数必须与总帧数一致（每块帧数为正）
+    if (header.channels <= 0 || header.channels > LosslessCodec::kMaxChannels || header.sample_rate <= 0
+        || header.block_frames <= 0 || header.block_frames > LosslessCodec::kBlockFrames
+        || header.total_frames < 0 || !(bits == 8 || bits == 16 || bits == 24 || bits == 32)
+        || stored_block_count != header.total_frames / header.block_frames + (header.total_frames % header.block_frames != 0)
+        || size < LosslessCodec::kHeaderSize + stored_block_count * LosslessCodec::kIndexEntrySize) {
+        return false;
+    }
+    block_count = static_cast<int>(stored_block_count);
+    return true;
+}
+
+}
+
+QByteArray LosslessCodec::EncodeBlock(const Header &header, const uchar *data, int frames)
+{
+    const int channels = header.channels;
+    const int bits = header.bits_per_sample;
+    const int sample_bytes = bits / 8;
+    // 32位和浮点样本只能原样保存
+    const bool predictable = header.format_tag == WavInfo::kFormatPcm && bits <= 24;
+    std::vector<qint32> samples(frames);
+    BitWriter writer;
+    for (int c = 0; c < channels; ++c) {
+        for (int i = 0; i < frames; ++i) {
+            samples[i] = LoadSample(data + (static_cast<qsizetype>(i) * channels + c) * sample_bytes, bits);
+        }
+        EncodeSubframe(writer, samples.data(), frames, bits, predictable);
+    }
+    return writer.Finish();
+}
+
+bool LosslessCodec::DecodeBlock(const Header &header, const uchar *block, qint64 block_size, int frames, uchar *output)
+{
+    const int channels = header.channels;
+    const int bits = header.bits_per_sample;
+    const int sample_bytes = bits / 8;
+    std::vector<qint64> samples(frames);
+    BitReader reader(block, block_size);
+    for (int c = 0; c < channels; ++c) {
+        if (!DecodeSubframe(reader, samples.data(), frames, bits)) {
+            return false;
+        }
+        for (int i = 0; i < frames; ++i) {
+            StoreSample(output + (static_cast<qsizetype>(i) * channels + c) * sample_bytes, bits, samples[i]);
+        }
+    }
+    return true;
+}
+
+bool LosslessCodec::IsCompressedFile(const QString &file_path)
+{
+    QFile file(file_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    return file.read(4) == QByteArray(kMagic, 4);
+}
+
+bool LosslessCodec::EncodeWavFile(const QString &wav_path, const QString &output_path)
+{
+    QFile input(wav_path);
+    if (!input.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const uchar *mapped = input.map(0, input.size());
+    WavInfo info;
+    if (!mapped || !ParseWavHeader(mapped, input.size(), info) || info.bits_per_sample > 32 || info.channels > kMaxChannels) {
+        return false;
+    }
+    Header header;
+    header.channels = info.channels;
+    header.sample_rate = info.sample_rate;
+    header.bits_per_sample = info.bits_per_sample;
+    header.format_tag = info.format_tag;
+    header.block_frames = kBlockFrames;
+    header.total_frames = info.get_frame_count();
+    const int block_count = static_cast<int>((header.total_frames + kBlockFrames - 1) / kBlockFrames);
+
+    // 写入临时文件，全部成功后才替换目标文件；失败时原文件保持不变，也不留下不完整的文件
+    QSaveFile output(output_path);
+    if (!output.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    // 文件头和块索引，索引在全部块写完后回填
+    uchar file_header[kHeaderSize]{};
+    memcpy(file_header, kMagic, 4);
+    qToLittleEndian<quint16>(kVersion, file_header + 4);
+    qToLittleEndian<quint16>(header.channels, file_header + 6);
+    qToLittleEndian<quint32>(header.sample_rate, file_header + 8);
+    qToLittleEndian<quint16>(header.bits_per_sample, file_header + 12);
+    qToLittleEndian<quint16>(header.format_tag, file_header + 14);
+    qToLittleEndian<quint32>(header.block_frames, file_header + 16);
+    qToLittleEndian<quint64>(header.total_frames, file_header + 20);
+    qToLittleEndian<quint32>(block_count, file_header + 28);
+    QByteArray index(qsizetype(block_count) * kIndexEntrySize, 0);
+    if (output.write(reinterpret_cast<const char *>(file_header), kHeaderSize) != kHeaderSize || output.write(index) != index.size()) {
+        return false;
+    }
+    // 分批并行编码，按顺序写出
+    const uchar *audio = mapped + info.data_offset;
+    qint64 offset = kHeaderSize + index.size();
+    for (int first = 0; first < block_count; first += kBatchBlocks) {
+        QList<int> blocks;
+        for (int b = first; b < qMin(block_count, first + kBatchBlocks); ++b) {
+            blocks.append(b);
+        }
+        const auto encoded = QtConcurrent::blockingMapped<QList<QByteArray>>(blocks, [&](int b) {
+            const qint64 start = qint64(b) * kBlockFrames;
+            const int frames = static_cast<int>(qMin<qint64>(kBlockFrames, header.total_frames - start));
+            return EncodeBlock(header, audio + start * info.block_align, frames);
+        });
+        for (int i = 0; i < encoded.size(); ++i) {
+            uchar *entry = reinterpret_cast<uchar *>(index.data()) + qsizetype(blocks[i]) * kIndexEntrySize;
+            qToLittleEndian<quint64>(offset, entry);
+            qToLittleEndian<quint32>(encoded[i].size(), entry + 8);
+            if (output.write(encoded[i]) != encoded[i].size()) {
+                return false;
+            }
+            offset += encoded[i].size();
+        }
+    }
+    return output.seek(kHeaderSize) && output.write(index) == index.size() && output.commit();
+}
+
+bool LosslessCodec::DecodeToWavFile(const QString &input_path, const QString &wav_path)
+{
+    QFile input(input_path);
+    if (!input.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const uchar *mapped = input.map(0, input.size());
+    Header header;
+    int block_count{ 0 };
+    if (!mapped || !ReadHeader(mapped, input.size(), header, block_count)) {
+        return false;
+    }
+    // 24位样本在WAV中以32位整数保存（流式写入器只支持Qt的样本格式）
+    QAudioFormat format;
+    format.setChannelCount(header.channels);
+    format.setSampleRate(header.sample_rate);
+    if (header.format_tag == WavInfo::kFormatFloat) {
+        format.setSampleFormat(QAudioFormat::Float);
+    } else if (header.bits_per_sample == 8) {
+        format.setSampleFormat(QAudioFormat::UInt8);
+    } else if (header.bits_per_sample == 16) {
+        format.setSampleFormat(QAudioFormat::Int16);
+    } else {
+        format.setSampleFormat(QAudioFormat::Int32);
+    }
+    WavStreamWriter writer;
+    if (!writer.Open(wav_path, format)) {
+        return false;
+    }
+    const int frame_bytes = header.channels * header.bits_per_sample / 8;
+    const uchar *index = mapped + kHeaderSize;
+    for (int first = 0; first < block_count; first += kBatchBlocks) {
+        const int batch = qMin(kBatchBlocks, block_count - first);
+        QByteArray pcm(qsizetype(batch) * header.block_frames * frame_bytes, Qt::Uninitialized);
+        QList<int> blocks;
+        for (int b = first; b < first + batch; ++b) {
+            blocks.append(b);
+        }
+        std::atomic<bool> ok{ true };
+        QtConcurrent::blockingMap(blocks, [&](int b) {
+            const uchar *entry = index + qsizetype(b) * kIndexEntrySize;
+            const qint64 offset = static_cast<qint64>(qFromLittleEndian<quint64>(entry));
+            const qint64 size = qFromLittleEndian<quint32>(entry + 8);
+            const qint64 start = qint64(b) * header.block_frames;
+            const int frames = static_cast<int>(qMin<qint64>(header.block_frames, header.total_frames - start));
+            uchar *out = reinterpret_cast<uchar *>(pcm.data()) + qsizetype(b - first) * header.block_frames * frame_bytes;
+            if (offset < 0 || offset + size > input.size() || !DecodeBlock(header, mapped + offset, size, frames, out)) {
+                ok = false;
+            }
+        });
+        if (!ok) {
+            writer.Close();
+            return false;
+        }
+        const qint64 batch_frames = qMin<qint64>(qint64(batch) * header.block_frames, header.total_frames - qint64(first) * header.block_frames);
+        if (header.bits_per_sample == 24) {
+            // 24位解码结果扩展为32位整数
+            QByteArray widened(batch_frames * header.channels * 4, Qt::Uninitialized);
+            const uchar *src = reinterpret_cast<const uchar *>(pcm.constData());
+            uchar *dst = reinterpret_cast<uchar *>(widened.data());
+            for (qint64 i = 0; i < batch_frames * header.channels; ++i) {
+                qToLittleEndian<qint32>(LoadSample(src + i * 3, 24) * 256, dst + i * 4);
+            }
+            pcm = widened;
+        } else {
+            pcm.truncate(batch_frames * frame_bytes);
+        }
+        if (!writer.Write(pcm.constData(), pcm.size())) {
+            writer.Close();
+            return false;
+        }
+    }
+    return writer.Close();
+}
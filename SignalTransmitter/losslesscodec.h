@@ -0,0 +1,44 @@
+﻿#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <vector>
+
+// 无损音频压缩（.stfl格式）
+// 每块4096帧独立编码：每个声道分别尝试固定多项式预测（0~4阶）和LPC预测（Levinson-Durbin求解，最高12阶），
+// 取编码后最短者，预测残差按256个样本分区进行Rice编码。块之间没有依赖，编解码按块在线程池中并行。
+// 8/16/24位整数PCM可压缩，32位整数和浮点样本按原样保存。
+//
+// 文件结构：文件头(32字节) + 块索引(每块偏移8字节、长度4字节) + 各块数据
+class LosslessCodec
+{
+public:
+    struct Header {
+        int channels{ 0 };
+        int sample_rate{ 0 };
+        int bits_per_sample{ 0 };
+        int format_tag{ 0 };            // 与WAV相同：1为整数PCM，3为浮点
+        int block_frames{ 0 };
+        qint64 total_frames{ 0 };
+    };
+
+    // WAV文件与压缩文件互相转换
+    static bool EncodeWavFile(const QString &wav_path, const QString &output_path);
+    static bool DecodeToWavFile(const QString &input_path, const QString &wav_path);
+    static bool IsCompressedFile(const QString &file_path);
+
+    // 单块编解码，data为交错格式的原始样本
+    static QByteArray EncodeBlock(const Header &header, const uchar *data, int frames);
+    static bool DecodeBlock(const Header &header, const uchar *block, qint64 block_size, int frames, uchar *output);
+
+    static constexpr char kMagic[4]{ 'S', 'T', 'F', 'L' };
+    static constexpr int kVersion{ 1 };
+    static constexpr int kHeaderSize{ 32 };
+    static constexpr int kIndexEntrySize{ 12 };
+    static constexpr int kBlockFrames{ 4096 };          // 每块帧数，也是解码时接受的上限
+    static constexpr int kMaxChannels{ 64 };
+    static constexpr int kBatchBlocks{ 64 };            // 每批并行处理的块数
+    static constexpr int kMaxLpcOrder{ 12 };
+    static constexpr int kLpcPrecision{ 14 };           // LPC系数量化位数
+    static constexpr int kPartitionSamples{ 256 };      // Rice编码分区大小
+};
@@ -1,20 +1,78 @@
 ﻿#include "mainwindow.h"
 #include "QFileDialog"
 #include "QMessageBox"
+#include <QMouseEvent>
+#include <QDir>
+#include <QScrollBar>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QtConcurrent>
+#include "losslesscodec.h"
+
+namespace {
+
+// 调制样本按固定宽度显示（每个样本6个字符），编辑文本后可以直接按样本下标定位
+QString FormatSamples(const double *samples, qsizetype count)
+{
+    QString text;
+    text.reserve(count * 6);
+    for (qsizetype i = 0; i < count; ++i) {
+        text.append(QString("%1 ").arg(samples[i], 5, 'f', 2));
+    }
+    return text;
+}
+
+// 只替换文本框中变化的部分，不重新设置全部内容
+void ReplaceBrowserText(QTextBrowser *browser, qsizetype position, qsizetype removed, const QString &inserted)
+{
+    QTextCursor cursor(browser->document());
+    cursor.setPosition(static_cast<int>(position));
+    cursor.setPosition(static_cast<int>(position + removed), QTextCursor::KeepAnchor);
+    cursor.insertText(inserted);
+}
+
+}
 
 MainWindow::MainWindow(QWidget *parent)
     : QWidget(parent)
     , ui(new Ui::MainWindowClass())
     , txt_model_(new TxtModel(this))
-    , network_model_(new NetworkModel(this))
+    , network_model_(new NetworkModel(nullptr))
+    , network_thread_(new QThread(this))
     , audio_model_(new AudioModel(this))
+    , thumbnail_watcher_(new QFutureWatcher<QImage>(this))
+    , compress_watcher_(new QFutureWatcher<CompressResult>(this))
+    , save_watcher_(new QFutureWatcher<bool>(this))
+    , decode_watcher_(new QFutureWatcher<bool>(this))
 {
     ui->setupUi(this);
     ui->label_sample_rate->setText("采样率: " + QString::number(txt_model_->kSampleRate) + " Hz"
     + " 传信率: " + QString::number(txt_model_->kSampleRate / txt_model_->kSamplesPerBit) + " bps"
     + " 载波: " + QString::number(txt_model_->kCarrierFreq) + " Hz");
     ui->time_view_encoded->set_txt_model(txt_model_);
+    connect(txt_model_, &TxtModel::ErrorOccurred, this, [this](const QString &message) {
+        QMessageBox::warning(this, "Error", message);
+    });
     ui->time_view_modulated->set_txt_model(txt_model_);
+    // 编辑文本时只重新编码、调制变化的部分，文本框和波形只更新受影响的范围
+    connect(ui->textBrowser_txt->document(), &QTextDocument::contentsChange, this, &MainWindow::OnTxtContentsChange);
+    connect(txt_model_, &TxtModel::EncodingFinished, this, &MainWindow::OnTxtEncoded);
+    connect(txt_model_, &TxtModel::ModulationFinished, this, &MainWindow::OnTxtModulated);
+    connect(txt_model_, &TxtModel::EncodedDataChanged, this, [this](qsizetype first, qsizetype removed, qsizetype added) {
+        const auto &data = txt_model_->get_txt_encoded_data();
+        QString bits;
+        bits.reserve(added);
+        for (qsizetype i = first; i < first + added; ++i) {
+            bits.append(QChar(u'0' + data[i]));
+        }
+        ReplaceBrowserText(ui->textBrowser_encoded, first, removed, bits);
+        ui->time_view_encoded->UpdateRange(first, removed, added);
+    });
+    connect(txt_model_, &TxtModel::ModulatedDataChanged, this, [this](qsizetype first, qsizetype removed, qsizetype added) {
+        const auto &data = txt_model_->get_txt_modulated_data();
+        ReplaceBrowserText(ui->textBrowser_modulated, first * 6, removed * 6, FormatSamples(data.constData() + first, added));
+        ui->time_view_modulated->UpdateRange(first, removed, added);
+    });
     // 初始化音频设置
     InitAudioSettings();
     // 连接音频模型的录音时长信号
@@ -25,35 +83,193 @@ MainWindow::MainWindow(QWidget *parent)
                                               .arg(minutes, 2, 10, QChar('0'))
                                               .arg(secs, 2, 10, QChar('0')));
             });
+    // 连接采集统计信号，鼠标悬停在录音时长上可查看丢失的音频
+    connect(audio_model_, &AudioModel::CaptureStatsChanged, [this](qint64 overrun_count) {
+        ui->label_recording_duration->setToolTip(QString("采集溢出: %1 次（丢弃 %2 字节）")
+                                                 .arg(overrun_count)
+                                                 .arg(audio_model_->get_capture_dropped_bytes()));
+    });
     // 连接音频模型的实时数据信号到波形显示
-    connect(audio_model_, &AudioModel::AudioDataReady, ui->audio_waveform_view, &AudioWaveformView::UpdateWaveform);
+    connect(audio_model_, &AudioModel::AudioBlockReady, ui->audio_waveform_view, &AudioWaveformView::UpdateWaveform);
+    // 连接录音和播放的实时数据到频谱显示
+    connect(audio_model_, &AudioModel::AudioBlockReady, ui->spectrum_view, &SpectrumView::AppendAudioBlock);
+    connect(audio_model_, &AudioModel::PlaybackDataReady, ui->spectrum_view, &SpectrumView::AppendAudioData);
     // 连接播放进度信号
     connect(audio_model_, &AudioModel::PlaybackPositionChanged, this, &MainWindow::UpdatePlaybackProgress);
     connect(audio_model_, &AudioModel::PlaybackFinished, this, &MainWindow::OnPlaybackFinished);
+    // 在播放进度条上点击或拖动可跳转和擦洗
+    ui->progressBar_playback->setRange(0, kPlaybackProgressRange);
+    ui->progressBar_playback->installEventFilter(this);
+    // 播放缓冲时长设置
+    connect(ui->spinBox_playback_buffer, &QSpinBox::valueChanged, [this](int milliseconds) {
+        audio_model_->set_playback_buffer_duration(milliseconds);
+    });
+    audio_model_->set_playback_buffer_duration(ui->spinBox_playback_buffer->value());
+    // 波形概览显示播放位置，点击或拖动可跳转
+    connect(audio_model_, &AudioModel::PlaybackPositionChanged, ui->waveform_overview, &WaveformOverview::SetPlayhead);
+    connect(ui->waveform_overview, &WaveformOverview::SeekRequested, audio_model_, &AudioModel::SeekPlayback);
+    // 网络模型运行在独立线程中，传输不受界面重绘和音频处理影响；信号以队列方式回到界面线程
+    network_model_->moveToThread(network_thread_);
+    connect(network_thread_, &QThread::finished, network_model_, &QObject::deleteLater);
+    network_thread_->start();
     // 连接网络模型的信号到槽
-    connect(network_model_, &NetworkModel::connectionEstablished, [this](const QString &client_info) {
+    connect(network_model_, &NetworkModel::connectionEstablished, this, [this](const QString &client_info) {
         ui->textBrowser_link_info->append("连接已建立");
         ui->textBrowser_link_info->append(QString("客户端: %1").arg(client_info));
     });
-    connect(network_model_, &NetworkModel::transferProgress, [this](qint64 bytes_sent, qint64 total_bytes) {
-        static int last_progress = -1;
-        int progress = static_cast<int>((bytes_sent * 100) / total_bytes);
-        // 只在进度变化超过1%时更新显示，避免过于频繁的更新
-        if (progress != last_progress && (progress - last_progress >= 1 || progress == 100)) {
-            ui->textBrowser_link_info->append(QString("传输进度: %1% (%2/%3 字节)")
+    connect(network_model_, &NetworkModel::transferProgress, this, [this](const TransferSnapshot &snapshot) {
+        const int progress = static_cast<int>((snapshot.bytes_sent * 100) / snapshot.total_bytes);
+        // 只在进度变化时更新显示，快照本身已限制频率
+        if (progress != last_transfer_progress_) {
+            ui->textBrowser_link_info->append(QString("传输进度: %1% (%2/%3 字节, %4 个客户端, %5 MB/s)")
                                              .arg(progress)
-                                             .arg(bytes_sent)
-                                             .arg(total_bytes));
-            last_progress = progress;
+                                             .arg(snapshot.bytes_sent)
+                                             .arg(snapshot.total_bytes)
+                                             .arg(snapshot.active_clients)
+                                             .arg(snapshot.throughput / (1024 * 1024), 0, 'f', 1));
+            last_transfer_progress_ = progress;
         }
     });
-    connect(network_model_, &NetworkModel::transferCompleted, [this]() {
+    connect(network_model_, &NetworkModel::connectionClosed, this, [this](const QString &client_info) {
+        ui->textBrowser_link_info->append(QString("客户端 %1 已断开").arg(client_info));
+    });
+    connect(network_model_, &NetworkModel::clientTransferCompleted, this, [this](const QString &client_info) {
+        ui->textBrowser_link_info->append(QString("客户端 %1 接收完成").arg(client_info));
+    });
+    connect(network_model_, &NetworkModel::clientTransferError, this, [this](const QString &client_info, const QString &error_message) {
+        ui->textBrowser_link_info->append(QString("客户端 %1 传输错误: %2").arg(client_info, error_message));
+    });
+    connect(network_model_, &NetworkModel::clientResumed, this, [this](const QString &client_info, qint64 offset) {
+        ui->textBrowser_link_info->append(QString("客户端 %1 从 %2 字节处续传").arg(client_info).arg(offset));
+    });
+    connect(network_model_, &NetworkModel::transferCompleted, this, [this]() {
         ui->textBrowser_link_info->append("文件传输完成");
         ui->btn_start_trans->setEnabled(true);
+        RemoveTransferTempFiles();
+        audio_model_->ReleaseRecordingFile();
     });
-    connect(network_model_, &NetworkModel::transferError, [this](const QString &error_message) {
+    connect(network_model_, &NetworkModel::transferError, this, [this](const QString &error_message) {
         ui->textBrowser_link_info->append("传输错误: " + error_message);
         ui->btn_start_trans->setEnabled(true);
+        RemoveTransferTempFiles();
+        audio_model_->ReleaseRecordingFile();
+    });
+    // 发送策略：吞吐优先或延迟优先
+    connect(ui->comboBox_socket_profile, &QComboBox::currentIndexChanged, [this](int index) {
+        const auto profile = index == 1 ? NetworkModel::kLatencyProfile : NetworkModel::kThroughputProfile;
+        QMetaObject::invokeMethod(network_model_, [this, profile]() {
+            network_model_->set_socket_profile(profile);
+        });
+    });
+    // 传输文件预览：文本按需加载，WAV缩略图生成后插入到信息下方
+    connect(ui->textBrowser_txt_preview->verticalScrollBar(), &QScrollBar::valueChanged, this, [this](int value) {
+        const auto *scroll_bar = ui->textBrowser_txt_preview->verticalScrollBar();
+        if (value + scroll_bar->pageStep() >= scroll_bar->maximum()) {
+            AppendPreviewText();
+        }
+    });
+    connect(thumbnail_watcher_, &QFutureWatcher<QImage>::finished, this, [this]() {
+        const QImage image = thumbnail_watcher_->result();
+        if (image.isNull() || thumbnail_preview_.lock() != preview_) {
+            return;
+        }
+        auto *document = ui->textBrowser_txt_preview->document();
+        document->addResource(QTextDocument::ImageResource, QUrl("preview://thumbnail"), image);
+        QTextCursor cursor(document);
+        cursor.movePosition(QTextCursor::End);
+        cursor.insertBlock();
+        cursor.insertImage("preview://thumbnail");
+    });
+    connect(compress_watcher_, &QFutureWatcher<CompressResult>::finished, this, [this]() {
+        const CompressResult result = compress_watcher_->result();
+        for (const auto &message : result.messages) {
+            ui->textBrowser_link_info->append(message);
+        }
+        if (!result.failed_file.isEmpty()) {
+            RemoveTransferTempFiles();
+            ui->btn_start_trans->setEnabled(true);
+            QMessageBox::warning(this, "压缩失败", "无法压缩WAV文件，请检查文件格式: " + result.failed_file);
+            return;
+        }
+        QList<TransferSourcePtr> sources;
+        for (const auto &path : result.transfer_paths) {
+            sources.append(std::make_shared<FileTransferSource>(path));
+        }
+        StartTransfer(sources, result.description);
+    });
+    connect(save_watcher_, &QFutureWatcher<bool>::finished, this, [this]() {
+        ui->btn_save_recorded_file->setEnabled(true);
+        ui->btn_record_switch->setEnabled(true);
+        if (save_watcher_->result()) {
+            QMessageBox::information(this, "保存成功",
+                                     QString("录音文件已保存: %1").arg(saving_file_));
+        } else {
+            QMessageBox::warning(this, "保存失败", "无法保存录音文件，请检查文件路径和权限。");
+        }
+    });
+    connect(decode_watcher_, &QFutureWatcher<bool>::finished, this, [this]() {
+        ui->btn_open_recorded_file->setEnabled(true);
+        // 解码文件交给音频模型管理
+        const QString decoded_file = decoded_file_;
+        decoded_file_.clear();
+        FinishLoadAudioFile(decoding_file_, decode_watcher_->result() && audio_model_->LoadDecodedFile(decoded_file));
+    });
+    // 实时音频流：网络线程直接读取采集线程的流通道，界面卡顿不会增加延迟
+    auto *stream_channel = audio_model_->get_stream_channel();
+    connect(stream_channel, &AudioCaptureChannel::DataAvailable, network_model_, [this, stream_channel]() {
+        stream_channel->AcknowledgeData();
+        const QAudioFormat format = stream_channel->get_format();
+        for (auto block = stream_channel->Pop(); !block.IsNull(); block = stream_channel->Pop()) {
+            network_model_->SlotStreamAudioBlock(block, format);
+        }
+    });
+    connect(ui->checkBox_live_stream, &QCheckBox::toggled, [this](bool checked) {
+        QMetaObject::invokeMethod(network_model_, [this, checked]() {
+            network_model_->set_streaming_enabled(checked);
+        });
+    });
+    connect(network_model_, &NetworkModel::streamEnded, this, [this](const QString &client_info, qint64 sent_frames, qint64 dropped_frames,
+                                                                      qint64 average_latency_us, qint64 max_latency_us) {
+        ui->textBrowser_link_info->append(QString("客户端 %1 音频流结束: 发送 %2 帧, 丢弃 %3 帧, 采集到发送延迟 平均 %4 ms / 最大 %5 ms")
+                                         .arg(client_info)
+                                         .arg(sent_frames)
+                                         .arg(dropped_frames)
+                                         .arg(average_latency_us / 1000.0, 0, 'f', 1)
+                                         .arg(max_latency_us / 1000.0, 0, 'f', 1));
+    });
+    connect(ui->checkBox_wire_compression, &QCheckBox::toggled, [this](bool checked) {
+        QMetaObject::invokeMethod(network_model_, [this, checked]() {
+            network_model_->set_compression_enabled(checked);
+        });
+    });
+    // 接收上传：文件保存到接收目录，音频可实时播放，完整的音频显示眼图
+    connect(ui->checkBox_ingest, &QCheckBox::toggled, [this](bool checked) {
+        QMetaObject::invokeMethod(network_model_, [this, checked]() {
+            network_model_->set_ingest_enabled(checked);
+        });
+    });
+    connect(ui->checkBox_ingest_playback, &QCheckBox::toggled, [this](bool checked) {
+        QMetaObject::invokeMethod(network_model_, [this, checked]() {
+            network_model_->set_ingest_playback_enabled(checked);
+        });
+        if (!checked) {
+            audio_model_->StopLivePlayback();
+        }
+    });
+    connect(network_model_, &NetworkModel::ingestStarted, this, [this](const QString &client_info, const QString &name, qint64 size) {
+        ui->textBrowser_link_info->append(size >= 0 ? QString("客户端 %1 开始上传 %2 (%3 字节)").arg(client_info, name).arg(size)
+                                                    : QString("客户端 %1 开始上传 %2").arg(client_info, name));
+    });
+    connect(network_model_, &NetworkModel::ingestCompleted, this, [this](const QString &client_info, const QString &file_path, qint64 bytes) {
+        ui->textBrowser_link_info->append(QString("客户端 %1 上传完成: %2 (%3 字节)").arg(client_info, file_path).arg(bytes));
+    });
+    connect(network_model_, &NetworkModel::ingestError, this, [this](const QString &client_info, const QString &error_message) {
+        ui->textBrowser_link_info->append(QString("客户端 %1 上传错误: %2").arg(client_info, error_message));
+    });
+    connect(network_model_, &NetworkModel::ingestAudioData, audio_model_, &AudioModel::PlayLiveAudio);
+    connect(network_model_, &NetworkModel::ingestAudioFileReady, this, [this](const QString &file_path, qint64 data_offset, const QAudioFormat &format) {
+        const double samples_per_symbol = format.sampleRate() * txt_model_->kSamplesPerBit / txt_model_->kSampleRate;
+        ui->eye_diagram_view->AccumulateSignal(file_path, data_offset, format, samples_per_symbol, txt_model_->kCarrierFreq);
     });
     // 添加使用说明
     ui->textBrowser_instructions->setMarkdown(
@@ -64,26 +280,45 @@ MainWindow::MainWindow(QWidget *parent)
 1. 加载或手动输入文本。
 2. 选择编码方式，点击“开始编码”。
 3. 选择调制方式，点击“开始调制”。
-4. 可保存原始、编码或调制后的文件。
+4. 可保存原始、编码或调制后的文件，或直接通过声卡播放调制信号。
+5. 右侧显示完整调制信号的眼图，双击切换为星座图。
 
 ### 音频采集
 1. 选择音频设备和参数。
-2. 点击“开始录音”按钮进行录音，实时显示波形。
-3. 再次点击停止录音，可保存为WAV文件。
-4. 可打开WAV文件进行播放，显示播放进度。
+2. 点击“开始录音”按钮进行录音，实时显示波形和频谱（滚轮缩放频率范围）。
+3. 再次点击停止录音，可保存为WAV文件或.stfl无损压缩文件（语音通常可减小40%~60%）。
+4. 可打开WAV文件进行播放，显示整个文件的波形概览、播放进度和频谱；点击或拖动进度条、波形概览可跳转，调整缓冲时长可降低延迟。
 
 ### 网络传输
 1. 在“服务器操作”中输入端口号，点击“开始监听端口”。
-2. 在接收端启动客户端并连接到此端口。
-3. 点击“选择传输的文件”按钮选择要发送的文件（支持.txt和.wav）。
-4. 点击“开始传输”按钮发送文件。
+2. 在接收端启动客户端并连接到此端口，可同时连接多个客户端。
+3. 点击“选择传输的文件”按钮选择要发送的文件（支持.txt和.wav），可一次选择多个文件。
+4. 点击“开始传输”按钮将文件同时发送给所有已连接的客户端，勾选“WAV文件无损压缩后传输”可减少传输时间。
+   多个文件只发送给使用分帧协议的客户端，文件依次连续发送，每个文件附带名称、类型、采样率和当前编码、调制参数等元数据。
+   “发送策略”选择吞吐优先（大文件）或延迟优先（交互式、小数据），块大小会按实测吞吐量自动调整。
 5. 传输进度和状态信息将在下方显示。
+6. 支持校验扩展的客户端会收到每1 MB数据块的CRC32C和整文件摘要，断线重连后可从最后校验通过的位置续传。
+7. 勾选“按链路速度自动压缩传输数据”后，对支持解压的客户端根据文件可压缩性和链路速度决定是否压缩（文本导出文件通常压缩效果很好）。
+8. 勾选“录音时向客户端实时推送音频”后，录音期间采集的音频以带序号和时间戳的帧实时发送给未在接收文件的客户端，网络较慢时丢弃最旧的数据以保持低延迟。
+9. “传输内容”可直接发送当前的编码数据、调制信号（64位浮点WAV）或最近一次录音，不需要先保存为文件。
+10. 勾选“接收客户端上传的文件和音频”后，分帧协议的客户端可向本机上传文件或实时音频流，保存在临时目录的SignalTransmitter_ingest中；
+    勾选“实时播放上传的音频”可边接收边播放，上传的音频接收完成后在“文本采集”页显示眼图。
 )"
     );
 }
 
 MainWindow::~MainWindow()
 {
+    thumbnail_watcher_->waitForFinished();
+    compress_watcher_->waitForFinished();
+    save_watcher_->waitForFinished();
+    decode_watcher_->waitForFinished();
+    // 退出时尚未加载的解码文件
+    if (!decoded_file_.isEmpty()) {
+        QFile::remove(decoded_file_);
+    }
+    network_thread_->quit();
+    network_thread_->wait();
     delete ui;
 }
 
@@ -104,13 +339,32 @@ void MainWindow::on_btn_load_txt_clicked()
     auto file_name = QFileDialog::getOpenFileName(this, "Open TXT File", "", "Text Files (*.txt)");
     if (!file_name.isEmpty()) {
         if (txt_model_->LoadTxtFile(file_name)) {
-            ui->textBrowser_txt->setText(txt_model_->get_txt_raw_data());
+            // 载入的内容已在模型中，不作为编辑处理
+            const QSignalBlocker blocker(ui->textBrowser_txt->document());
+            ui->textBrowser_txt->setPlainText(txt_model_->get_txt_raw_data());
             ui->btn_encode->setEnabled(true);
             ui->btn_save_txt->setEnabled(true);
         }
     }
 }
 
+void MainWindow::OnTxtContentsChange(int position, int chars_removed, int chars_added)
+{
+    // 文档末尾有一个不属于文本的段落分隔符，变化范围可能包含它
+    auto *document = ui->textBrowser_txt->document();
+    const int end = qMin(position + chars_added, document->characterCount() - 1);
+    QTextCursor cursor(document);
+    cursor.setPosition(position);
+    cursor.setPosition(qMax(end, position), QTextCursor::KeepAnchor);
+    // 选中文本中的换行为段落分隔符，Shift+Enter插入的是行分隔符，与toPlainText一致都转换为'\n'
+    const QString inserted = cursor.selectedText()
+                                 .replace(QChar::ParagraphSeparator, u'\n')
+                                 .replace(QChar::LineSeparator, u'\n');
+    txt_model_->ReplaceText(position, chars_removed, inserted);
+    ui->btn_encode->setEnabled(true);
+    ui->btn_save_txt->setEnabled(true);
+}
+
 void MainWindow::on_btn_save_txt_clicked()
 {
     QString file_name = QFileDialog::getSaveFileName(this, "Save TXT File", "", "Text Files (*.txt)");
@@ -121,14 +375,19 @@ void MainWindow::on_btn_save_txt_clicked()
 
 void MainWindow::on_btn_encode_clicked()
 {
-    txt_model_->EncodeTxtFile(ui->comboBox_encoding->currentText());
+    // 编码和调制在文本模型的线程池中流水进行，完成后由OnTxtEncoded、OnTxtModulated更新显示
+    txt_model_->EncodeTxtFile(ui->comboBox_encoding->currentText(), ui->comboBox_modulation->currentText());
+}
+
+void MainWindow::OnTxtEncoded()
+{
     // 以二进制形式显示编码后的数据，每个样本点为0或1
     const auto &data = txt_model_->get_txt_encoded_data();
     QString bin_str;
     for (auto bit : data) {
         bin_str.append(QString::number(bit));
     }
-    ui->textBrowser_encoded->setText(bin_str.trimmed());
+    ui->textBrowser_encoded->setPlainText(bin_str);
     ui->btn_modulate->setEnabled(true);
     ui->btn_save_encoded_file->setEnabled(true);
     // 更新编码波形
@@ -138,17 +397,32 @@ void MainWindow::on_btn_encode_clicked()
 void MainWindow::on_btn_modulate_clicked()
 {
     txt_model_->ModulateTxtFile(ui->comboBox_modulation->currentText());
+}
+
+void MainWindow::OnTxtModulated()
+{
     const auto &data = txt_model_->get_txt_modulated_data();
-    QString mod_str;
-    for (auto bit : data) {
-        mod_str.append(QString::number(bit, 'f', 2)); // 保留两位小数
-        mod_str.append(" ");
-    }
-    ui->textBrowser_modulated->setText(mod_str.trimmed());
+    ui->textBrowser_modulated->setPlainText(FormatSamples(data.constData(), data.size())); // 保留两位小数
     ui->btn_save_modulated_file->setEnabled(true);
+    ui->btn_play_modulated->setEnabled(true);
     // 更新调制波形
     ui->time_view_modulated->set_modulation_type(ui->comboBox_modulation->currentText());
     ui->time_view_modulated->UpdateView();
+    // 对完整调制信号累积眼图和星座图
+    ui->eye_diagram_view->AccumulateSignal(data, txt_model_->kSampleRate, txt_model_->kSamplesPerBit, txt_model_->kCarrierFreq);
+}
+
+void MainWindow::on_btn_play_modulated_clicked()
+{
+    // 调制信号采样率远低于声卡支持的采样率，播放时自动重采样
+    if (!audio_model_->LoadGeneratedSignal(txt_model_->get_txt_modulated_data(), static_cast<int>(txt_model_->kSampleRate))) {
+        QMessageBox::warning(this, "播放失败", "无法生成调制信号的音频文件。");
+        return;
+    }
+    ui->lineEdit_wav_file_path->setText("调制信号");
+    ui->waveform_overview->LoadFile(audio_model_->get_playback_file_path());
+    OnPlaybackFinished();
+    on_btn_play_wav_clicked();
 }
 
 void MainWindow::on_btn_save_encoded_file_clicked()
@@ -175,7 +449,11 @@ void MainWindow::on_btn_port_listening_clicked(bool isChecked)
         ui->btn_port_listening->setText("端口监听中...");
         ui->textBrowser_link_info->append("当前监听端口号: " + port_str);
 
-        switch (network_model_->StartListening(port_str)) {
+        auto result = NetworkModel::kNoError;
+        QMetaObject::invokeMethod(network_model_, [this, &result, port_str]() {
+            result = network_model_->StartListening(port_str);
+        }, Qt::BlockingQueuedConnection);
+        switch (result) {
         case NetworkModel::kNoError:
             ui->textBrowser_link_info->append("端口监听成功");
             break;
@@ -197,29 +475,65 @@ void MainWindow::on_btn_port_listening_clicked(bool isChecked)
         ui->btn_port_listening->setText("开始监听端口");
         ui->textBrowser_link_info->append("端口监听已停止");
 
-        network_model_->StopListening();
+        QMetaObject::invokeMethod(network_model_, [this]() {
+            network_model_->StopListening();
+        }, Qt::BlockingQueuedConnection);
     }
 }
 
 void MainWindow::on_btn_load_trans_file_clicked()
 {
-    const auto file_name = QFileDialog::getOpenFileName(this, "Open Transmit File", "", "Text Files (*.txt);;WAV Files (*.wav)");
-    ui->lineEdit_trans_file_path->setText(file_name);
-    if (file_name.isEmpty()) {
+    transfer_files_ = QFileDialog::getOpenFileNames(this, "Open Transmit Files", "", "Text Files (*.txt);;WAV Files (*.wav);;Lossless Audio (*.stfl);;All Files (*)");
+    if (transfer_files_.size() > 1) {
+        ui->lineEdit_trans_file_path->setText(QString("%1 个文件: %2").arg(transfer_files_.size()).arg(transfer_files_.join("; ")));
+    } else {
+        ui->lineEdit_trans_file_path->setText(transfer_files_.value(0));
+    }
+    if (transfer_files_.isEmpty()) {
         return;
     }
-    network_model_->set_preview_file(file_name);
-    if (file_name.endsWith(".txt")) {
-        ui->textBrowser_txt_preview->setText(network_model_->get_preview_file());
-    } else if (file_name.endsWith(".wav")) {
-        ui->textBrowser_txt_preview->setText("WAV文件预览暂时不可用!");
+    // 预览第一个文件：只映射文件，文本先显示开头一段，WAV显示头部信息和缩略图
+    const auto file_name = transfer_files_.first();
+    preview_ = std::make_shared<FilePreview>();
+    preview_->Open(file_name);
+    const auto preview = preview_;
+    thumbnail_preview_.reset();
+    ui->textBrowser_txt_preview->clear();
+    if (!preview->IsOpen()) {
+        ui->textBrowser_txt_preview->setPlainText(preview->get_error());
+    } else if (preview->IsWav()) {
+        ui->textBrowser_txt_preview->setPlainText(preview->WavSummary());
+        const QSize size(qMax(ui->textBrowser_txt_preview->viewport()->width() - 20, 100), kThumbnailHeight);
+        thumbnail_preview_ = preview;
+        thumbnail_watcher_->setFuture(QtConcurrent::run([preview, size]() {
+            return preview->WavThumbnail(size);
+        }));
+    } else if (preview->IsBinary()) {
+        ui->textBrowser_txt_preview->setPlainText(QString("二进制文件，不提供预览（%1 字节）").arg(preview->get_file_size()));
+    } else {
+        AppendPreviewText();
+    }
+}
+
+void MainWindow::AppendPreviewText()
+{
+    const auto preview = preview_;
+    if (!preview || !preview->IsOpen() || preview->IsWav() || preview->IsBinary() || preview->IsTextAtEnd()) {
+        return;
+    }
+    // 在末尾追加，不改变当前的滚动位置
+    QTextCursor cursor(ui->textBrowser_txt_preview->document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(preview->ReadText());
+    if (preview->IsTextTruncated()) {
+        cursor.insertText(QString("\n……（仅预览前 %1 MB）").arg(FilePreview::kMaxTextBytes / (1024 * 1024)));
     }
 }
 
 void MainWindow::on_btn_start_trans_clicked()
 {
-    const auto file_name = ui->lineEdit_trans_file_path->text();
-    if (file_name.isEmpty()) {
+    const int source_type = ui->comboBox_trans_source->currentIndex();
+    if (source_type == kSourceFiles && transfer_files_.isEmpty()) {
         QMessageBox::warning(this, "文件未选择", "请先选择要传输的文件。");
         return;
     }
@@ -231,10 +545,87 @@ void MainWindow::on_btn_start_trans_clicked()
         QMessageBox::warning(this, "传输进行中", "文件正在传输中，请等待完成。");
         return;
     }
+    // 编码数据、调制信号和录音直接从内存或录音临时文件发送，不需要先另存为文件
+    QList<TransferSourcePtr> sources;
+    if (source_type == kSourceEncoded) {
+        if (txt_model_->get_txt_encoded_data().isEmpty()) {
+            QMessageBox::warning(this, "没有数据", "请先编码文本。");
+            return;
+        }
+        sources.append(std::make_shared<BitTransferSource>("encoded.txt", txt_model_->get_txt_encoded_data()));
+    } else if (source_type == kSourceModulated) {
+        if (txt_model_->get_txt_modulated_data().isEmpty()) {
+            QMessageBox::warning(this, "没有数据", "请先调制信号。");
+            return;
+        }
+        sources.append(std::make_shared<SignalTransferSource>("modulated.wav", txt_model_->get_txt_modulated_data(),
+                                                              static_cast<int>(txt_model_->kSampleRate)));
+    } else if (source_type == kSourceRecording) {
+        if (audio_model_->IsRecording() || audio_model_->get_recording_file_path().isEmpty()) {
+            QMessageBox::warning(this, "没有数据", "请先完成录音。");
+            return;
+        }
+        // 传输期间开始新录音不会覆盖或删除正在发送的文件
+        audio_model_->RetainRecordingFile();
+        sources.append(std::make_shared<FileTransferSource>(audio_model_->get_recording_file_path()));
+    } else if (ui->checkBox_compress_audio->isChecked()) {
+        // WAV文件可先无损压缩再传输，接收端解码得到完全相同的音频；压缩在线程池中进行，完成后开始传输
+        transfer_temp_dir_ = std::make_unique<QTemporaryDir>();
+        if (!transfer_temp_dir_->isValid()) {
+            RemoveTransferTempFiles();
+            QMessageBox::warning(this, "压缩失败", "无法创建临时目录。");
+            return;
+        }
+        ui->btn_start_trans->setEnabled(false);
+        ui->textBrowser_link_info->append("正在压缩WAV文件...");
+        const QDir temp_dir(transfer_temp_dir_->path());
+        compress_watcher_->setFuture(QtConcurrent::run([files = transfer_files_, temp_dir]() {
+            CompressResult result;
+            result.description = files.join("; ");
+            for (const auto &file_name : files) {
+                if (!file_name.endsWith(".wav", Qt::CaseInsensitive)) {
+                    result.transfer_paths.append(file_name);
+                    continue;
+                }
+                const auto transfer_path = temp_dir.filePath(QFileInfo(file_name).completeBaseName() + ".stfl");
+                if (!LosslessCodec::EncodeWavFile(file_name, transfer_path)) {
+                    result.failed_file = file_name;
+                    return result;
+                }
+                result.messages.append(QString("无损压缩: %1 → %2 字节")
+                                       .arg(QFileInfo(file_name).size())
+                                       .arg(QFileInfo(transfer_path).size()));
+                result.transfer_paths.append(transfer_path);
+            }
+            return result;
+        }));
+        return;
+    } else {
+        for (const auto &file_name : std::as_const(transfer_files_)) {
+            sources.append(std::make_shared<FileTransferSource>(file_name));
+        }
+    }
+    StartTransfer(sources, source_type == kSourceFiles ? transfer_files_.join("; ") : ui->comboBox_trans_source->currentText());
+}
+
+void MainWindow::StartTransfer(const QList<TransferSourcePtr> &sources, const QString &description)
+{
+    // 当前的编码、调制参数作为元数据随每个文件发送，接收端可据此解调
+    QVariantMap metadata;
+    metadata.insert(TransferProtocol::kKeyEncoding, ui->comboBox_encoding->currentText());
+    metadata.insert(TransferProtocol::kKeyModulation, ui->comboBox_modulation->currentText());
+    metadata.insert(TransferProtocol::kKeyCarrierFrequency, txt_model_->kCarrierFreq);
+    metadata.insert(TransferProtocol::kKeySamplesPerBit, static_cast<qint64>(txt_model_->kSamplesPerBit));
     // 开始传输文件
     ui->btn_start_trans->setEnabled(false);
-    ui->textBrowser_link_info->append("开始传输文件: " + file_name);
-    network_model_->StartFileTransfer(file_name);
+    ui->textBrowser_link_info->append(QString("开始向 %1 个客户端传输 %2 个文件: %3")
+                                     .arg(network_model_->get_client_count())
+                                     .arg(sources.size())
+                                     .arg(description));
+    last_transfer_progress_ = -1;
+    QMetaObject::invokeMethod(network_model_, [this, sources, metadata]() {
+        network_model_->StartSourceTransfer(sources, metadata);
+    });
 }
 
 void MainWindow::on_btn_refresh_devices_clicked()
@@ -267,6 +658,7 @@ void MainWindow::on_btn_record_switch_clicked(bool isChecked)
         }
         // 开始波形显示
         ui->audio_waveform_view->StartDisplay();
+        ui->spectrum_view->ClearDisplay();
 
         ui->label_recording_duration->setText(QString("录音时长: 00:00"));
         ui->btn_record_switch->setText("停止录音");
@@ -278,13 +670,22 @@ void MainWindow::on_btn_record_switch_clicked(bool isChecked)
         ui->btn_refresh_devices->setEnabled(false);    } else {
         // 停止录音
         audio_model_->StopRecording();
+        QMetaObject::invokeMethod(network_model_, [this]() {
+            network_model_->EndStream();
+        });
         // 停止波形显示
         ui->audio_waveform_view->StopDisplay();
         // 显示录音完成信息
-        const auto recorded_data = audio_model_->get_recorded_data();
-        if (!recorded_data.isEmpty()) {
+        const auto recorded_bytes = audio_model_->get_recorded_bytes();
+        if (recorded_bytes > 0) {
+            // 按照文本调制的传信率和载波分析录音信号的眼图和星座图
+            const auto &format = audio_model_->get_audio_format();
+            const double samples_per_symbol = format.sampleRate() * txt_model_->kSamplesPerBit / txt_model_->kSampleRate;
+            ui->eye_diagram_view->AccumulateSignal(audio_model_->get_recording_file_path(), audio_model_->get_recording_data_offset(),
+                                                   format, samples_per_symbol, txt_model_->kCarrierFreq);
             QMessageBox::information(this, "录音完成",
-                                     QString("录音已保存到缓冲区，数据大小: %1 KB").arg(recorded_data.size() / 1024.0, 0, 'f', 2));
+                                     QString("录音已写入临时文件，数据大小: %1 KB\n采集溢出: %2 次").arg(recorded_bytes / 1024.0, 0, 'f', 2)
+                                     .arg(audio_model_->get_capture_overrun_count()));
         }
 
         ui->btn_record_switch->setText("开始录音");
@@ -303,48 +704,62 @@ void MainWindow::on_btn_save_recorded_file_clicked()
         QMessageBox::warning(this, "保存失败", "录音正在进行中，请先停止录音。");
         return;
     }
-    const auto recorded_data = audio_model_->get_recorded_data();
-    if (recorded_data.isEmpty()) {
+    if (audio_model_->get_recorded_bytes() == 0) {
         QMessageBox::warning(this, "保存失败", "没有录音数据可以保存。");
         return;
     }
-    const auto file_name = QFileDialog::getSaveFileName(this, "保存录音文件", "", "WAV Files (*.wav)");
+    const auto file_name = QFileDialog::getSaveFileName(this, "保存录音文件", "", "WAV Files (*.wav);;Lossless Audio (*.stfl)");
     if (file_name.isEmpty()) {
         return;
     }
-
-    if (audio_model_->SaveRecordedWavFile(file_name)) {
-        QMessageBox::information(this, "保存成功",
-                                 QString("录音文件已保存: %1").arg(file_name));
-    } else {
-        QMessageBox::warning(this, "保存失败", "无法保存录音文件，请检查文件路径和权限。");
-    }
+    // 保存期间不能开始新录音，录音文件保持不变
+    ui->btn_save_recorded_file->setEnabled(false);
+    ui->btn_record_switch->setEnabled(false);
+    saving_file_ = file_name;
+    save_watcher_->setFuture(QtConcurrent::run([recording_path = audio_model_->get_recording_file_path(), file_name]() {
+        return AudioModel::SaveRecordedWavFile(recording_path, file_name);
+    }));
 }
 
 void MainWindow::on_btn_open_recorded_file_clicked()
 {
-    const auto file_name = QFileDialog::getOpenFileName(this, "Open WAV File", "", "WAV Files (*.wav)");
+    const auto file_name = QFileDialog::getOpenFileName(this, "Open WAV File", "", "Audio Files (*.wav *.stfl)");
     if (file_name.isEmpty()) {
         return;
     }
     ui->lineEdit_wav_file_path->setText(file_name);
-    if (audio_model_->LoadWavFile(file_name)) {
-        const int total_duration = audio_model_->get_playback_total_duration();
-        const int minutes = total_duration / 60;
-        const int seconds = total_duration % 60;
+    if (LosslessCodec::IsCompressedFile(file_name)) {
+        // 无损压缩文件在线程池中解码为临时WAV文件，完成后再加载；当前文件在此期间仍可播放
+        ui->btn_open_recorded_file->setEnabled(false);
+        decoding_file_ = file_name;
+        decoded_file_ = AudioModel::NewDecodedFilePath();
+        decode_watcher_->setFuture(QtConcurrent::run([file_name, wav_path = decoded_file_]() {
+            const bool ok = LosslessCodec::DecodeToWavFile(file_name, wav_path);
+            if (!ok) {
+                QFile::remove(wav_path);
+            }
+            return ok;
+        }));
+        return;
+    }
+    FinishLoadAudioFile(file_name, audio_model_->LoadWavFile(file_name));
+}
 
-        ui->label_playback->setText(QString("00:00 / %1:%2")
-                                    .arg(minutes, 2, 10, QChar('0'))
-                                    .arg(seconds, 2, 10, QChar('0')));
-        ui->progressBar_playback->setValue(0);
+void MainWindow::FinishLoadAudioFile(const QString &file_name, bool loaded)
+{
+    // 解码期间可能开始了其他播放，加载新文件时已停止
+    OnPlaybackFinished();
+    if (loaded) {
+        UpdatePlaybackProgress(0, audio_model_->get_playback_total_frames());
+        ui->waveform_overview->LoadFile(audio_model_->get_playback_file_path());
 
         QMessageBox::information(this, "文件加载成功",
-                                 QString("WAV文件已加载: %1\n时长: %2:%3")
+                                 QString("WAV文件已加载: %1\n时长: %2")
                                  .arg(QFileInfo(file_name).fileName())
-                                 .arg(minutes, 2, 10, QChar('0'))
-                                 .arg(seconds, 2, 10, QChar('0')));
+                                 .arg(FormatPlaybackTime(audio_model_->get_playback_total_frames())));
     } else {
         ui->lineEdit_wav_file_path->clear();
+        ui->waveform_overview->ClearDisplay();
         QMessageBox::warning(this, "文件加载失败", "无法加载WAV文件，请检查文件格式。");
     }
 }
@@ -356,6 +771,7 @@ void MainWindow::on_btn_play_wav_clicked()
         return;
     }
     if (audio_model_->StartPlayback()) {
+        ui->spectrum_view->ClearDisplay();
         ui->btn_play_wav->setEnabled(false);
         ui->btn_pause_wav->setEnabled(true);
         ui->btn_close_wav->setEnabled(true);
@@ -381,21 +797,15 @@ void MainWindow::on_btn_close_wav_clicked()
     OnPlaybackFinished();
 }
 
-void MainWindow::UpdatePlaybackProgress(int current_seconds, int total_seconds)
+void MainWindow::UpdatePlaybackProgress(qint64 position_frames, qint64 total_frames)
 {
-    const int current_minutes = current_seconds / 60;
-    const int current_secs = current_seconds % 60;
-    const int total_minutes = total_seconds / 60;
-    const int total_secs = total_seconds % 60;
     // 更新时间标签
-    ui->label_playback->setText(QString("%1:%2 / %3:%4")
-                                .arg(current_minutes, 2, 10, QChar('0'))
-                                .arg(current_secs, 2, 10, QChar('0'))
-                                .arg(total_minutes, 2, 10, QChar('0'))
-                                .arg(total_secs, 2, 10, QChar('0')));
+    ui->label_playback->setText(QString("%1 / %2")
+                                .arg(FormatPlaybackTime(position_frames))
+                                .arg(FormatPlaybackTime(total_frames)));
     // 更新进度条
-    if (total_seconds > 0) {
-        const int progress = (current_seconds * 100) / total_seconds;
+    if (total_frames > 0) {
+        const int progress = static_cast<int>(position_frames * kPlaybackProgressRange / total_frames);
         ui->progressBar_playback->setValue(progress);
     }
 }
@@ -407,12 +817,37 @@ void MainWindow::OnPlaybackFinished()
     ui->btn_close_wav->setEnabled(false);
     ui->btn_pause_wav->setText("暂停");
     ui->btn_open_recorded_file->setEnabled(true);
-    ui->progressBar_playback->setValue(0);
-
-    const int total_duration = audio_model_->get_playback_total_duration();
-    const int minutes = total_duration / 60;
-    const int seconds = total_duration % 60;
-    ui->label_playback->setText(QString("00:00 / %1:%2")
-                                .arg(minutes, 2, 10, QChar('0'))
-                                .arg(seconds, 2, 10, QChar('0')));
+    UpdatePlaybackProgress(0, audio_model_->get_playback_total_frames());
+}
+
+QString MainWindow::FormatPlaybackTime(qint64 frames) const
+{
+    const int sample_rate = audio_model_->get_playback_sample_rate();
+    const qint64 milliseconds = sample_rate > 0 ? frames * 1000 / sample_rate : 0;
+    return QString("%1:%2.%3")
+        .arg(milliseconds / 60000, 2, 10, QChar('0'))
+        .arg(milliseconds / 1000 % 60, 2, 10, QChar('0'))
+        .arg(milliseconds / 100 % 10);
+}
+
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == ui->progressBar_playback) {
+        const auto type = event->type();
+        if (type == QEvent::MouseButtonPress || type == QEvent::MouseMove || type == QEvent::MouseButtonRelease) {
+            const auto mouse_event = static_cast<QMouseEvent *>(event);
+            if (type == QEvent::MouseMove && !(mouse_event->buttons() & Qt::LeftButton)) {
+                return false;
+            }
+            // 按鼠标位置换算为帧，拖动时限制跳转频率，松开时跳到最终位置
+            if (type == QEvent::MouseMove && scrub_timer_.isValid() && scrub_timer_.elapsed() < kScrubInterval) {
+                return true;
+            }
+            scrub_timer_.start();
+            const double ratio = qBound(0.0, mouse_event->position().x() / ui->progressBar_playback->width(), 1.0);
+            audio_model_->SeekPlayback(static_cast<qint64>(ratio * audio_model_->get_playback_total_frames()));
+            return true;
+        }
+    }
+    return QWidget::eventFilter(watched, event);
 }
@@ -1,11 +1,21 @@
 ﻿#pragma once
 
 #include <QtWidgets/QWidget>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QTemporaryDir>
+#include <memory>
 #include "ui_mainwindow.h"
 #include "txtmodel.h"
 #include "networkmodel.h"
 #include "audiomodel.h"
 #include "audiowaveformview.h"
+#include "spectrumview.h"
+#include "eyediagramview.h"
+#include "waveformoverview.h"
+#include "filepreview.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindowClass; };
@@ -19,14 +29,69 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
 private:
     void InitAudioSettings();
+    QString FormatPlaybackTime(qint64 frames) const;
+    // 传输文件预览：文本滚动到底部时加载下一段
+    void AppendPreviewText();
+    // 文本框内容被编辑，把变化的部分交给文本模型
+    void OnTxtContentsChange(int position, int chars_removed, int chars_added);
+    // 文本模型完成编码、调制后更新显示
+    void OnTxtEncoded();
+    void OnTxtModulated();
+    // 附带当前编码、调制参数，在网络线程中开始传输
+    void StartTransfer(const QList<TransferSourcePtr> &sources, const QString &description);
+    // 传输结束后删除压缩生成的临时文件
+    void RemoveTransferTempFiles() { transfer_temp_dir_.reset(); }
+    // 音频文件加载完成（.stfl文件在后台解码后），更新播放界面
+    void FinishLoadAudioFile(const QString &file_name, bool loaded);
 
 private:
     Ui::MainWindowClass *ui;
     TxtModel *txt_model_;
     NetworkModel *network_model_;
+    QThread *network_thread_;
     AudioModel *audio_model_;
+    // 拖动播放进度条擦洗时限制跳转频率
+    QElapsedTimer scrub_timer_;
+    int last_transfer_progress_{ -1 };
+    QStringList transfer_files_;                // 选择的待传输文件，可以多个
+    // 传输文件预览只在界面线程中使用，与网络模型无关；每次选择文件创建新的预览，
+    // 后台线程中生成缩略图时持有旧预览的引用，映射不会提前解除
+    std::shared_ptr<FilePreview> preview_;
+    // WAV预览缩略图在后台生成，完成时只显示给仍在预览的文件
+    QFutureWatcher<QImage> *thumbnail_watcher_;
+    std::weak_ptr<FilePreview> thumbnail_preview_;
+    // 传输前在线程池中无损压缩WAV文件，压缩文件放在本次传输的临时目录中
+    struct CompressResult {
+        QStringList transfer_paths;
+        QStringList messages;
+        QString description;                    // 压缩开始时选择的文件
+        QString failed_file;                    // 压缩失败的文件，为空表示全部成功
+    };
+    QFutureWatcher<CompressResult> *compress_watcher_;
+    std::unique_ptr<QTemporaryDir> transfer_temp_dir_;
+    // 保存录音（复制或无损压缩）和解码.stfl文件同样在线程池中进行，界面不等待
+    QFutureWatcher<bool> *save_watcher_;
+    QString saving_file_;
+    QFutureWatcher<bool> *decode_watcher_;
+    QString decoding_file_;                     // 正在解码的.stfl文件
+    QString decoded_file_;                      // 解码输出的临时WAV文件，加载后由音频模型管理
+
+    // 传输内容（与comboBox_trans_source的选项顺序一致）
+    enum TransferSource_t {
+        kSourceFiles = 0,
+        kSourceEncoded,
+        kSourceModulated,
+        kSourceRecording
+    };
+
+    static constexpr int kPlaybackProgressRange{ 1000 };
+    static constexpr int kScrubInterval{ 40 };   // 毫秒
+    static constexpr int kThumbnailHeight{ 120 };
 
 private slots:
     // 文本模型
@@ -36,6 +101,7 @@ private slots:
     void on_btn_modulate_clicked();
     void on_btn_save_encoded_file_clicked();
     void on_btn_save_modulated_file_clicked();
+    void on_btn_play_modulated_clicked();
     // 网络模型
     void on_btn_port_listening_clicked(bool isChecked);
     void on_btn_load_trans_file_clicked();
@@ -49,6 +115,6 @@ private slots:
     void on_btn_pause_wav_clicked();
     void on_btn_close_wav_clicked();
 
-    void UpdatePlaybackProgress(int current_seconds, int total_seconds);
+    void UpdatePlaybackProgress(qint64 position_frames, qint64 total_frames);
     void OnPlaybackFinished();
 };
@@ -0,0 +1,109 @@
+﻿#include "mappedaudiodevice.h"
+#include <cstring>
+
+MappedAudioDevice::MappedAudioDevice(QObject *parent)
+    : QIODevice(parent)
+{}
+
+MappedAudioDevice::~MappedAudioDevice()
+{
+    close();
+}
+
+bool MappedAudioDevice::Open(const QString &file_path)
+{
+    close();
+    file_.setFileName(file_path);
+    if (!file_.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    // 映射整个文件，页面按需载入，打开大文件不需要等待读取
+    mapped_ = file_.map(0, file_.size());
+    if (!mapped_ || !ParseWavHeader(mapped_, file_.size(), info_)) {
+        close();
+        return false;
+    }
+    format_ = info_.ToAudioFormat();
+    in_sample_bytes_ = info_.bits_per_sample / 8;
+    out_sample_bytes_ = format_.bytesPerSample();
+    // 不使用QIODevice内部缓冲，读取位置与音频设备消费位置一致
+    return QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+void MappedAudioDevice::close()
+{
+    if (isOpen()) {
+        QIODevice::close();
+    }
+    if (mapped_) {
+        file_.unmap(const_cast<uchar *>(mapped_));
+        mapped_ = nullptr;
+    }
+    file_.close();
+    info_ = WavInfo();
+}
+
+qint64 MappedAudioDevice::size() const
+{
+    if (!mapped_) {
+        return 0;
+    }
+    return info_.data_size / in_sample_bytes_ * out_sample_bytes_;
+}
+
+QByteArray MappedAudioDevice::PeekAt(qint64 pos, qint64 max_size) const
+{
+    const qint64 n = qBound<qint64>(0, qMin(max_size, size() - pos), size());
+    QByteArray result(n, Qt::Uninitialized);
+    result.truncate(CopyOut(pos, result.data(), n));
+    return result;
+}
+
+qint64 MappedAudioDevice::readData(char *data, qint64 max_size)
+{
+    return CopyOut(pos(), data, max_size);
+}
+
+qint64 MappedAudioDevice::writeData(const char *data, qint64 max_size)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(max_size);
+    return -1;
+}
+
+qint64 MappedAudioDevice::CopyOut(qint64 pos, char *out, qint64 max_size) const
+{
+    if (!mapped_ || pos < 0) {
+        return 0;
+    }
+    const qint64 remain = size() - pos;
+    if (remain <= 0) {
+        return 0;
+    }
+    const uchar *src = mapped_ + info_.data_offset;
+    if (!info_.NeedsConversion()) {
+        const qint64 n = qMin(max_size, remain);
+        memcpy(out, src + pos, n);
+        return n;
+    }
+    // 需要转换时按整样本处理
+    const qint64 first = pos / out_sample_bytes_;
+    const qint64 count = qMin(max_size, remain) / out_sample_bytes_;
+    const uchar *in = src + first * in_sample_bytes_;
+    if (info_.bits_per_sample == 24) {
+        // 24位小端整数放到32位整数的高24位
+        for (qint64 i = 0; i < count; ++i, in += 3, out += 4) {
+            const quint32 v = (quint32(in[0]) << 8) | (quint32(in[1]) << 16) | (quint32(in[2]) << 24);
+            memcpy(out, &v, 4);
+        }
+    } else {
+        // 64位浮点转换为32位浮点
+        for (qint64 i = 0; i < count; ++i, in += 8, out += 4) {
+            double v;
+            memcpy(&v, in, sizeof(v));
+            const float f = static_cast<float>(v);
+            memcpy(out, &f, 4);
+        }
+    }
+    return count * out_sample_bytes_;
+}
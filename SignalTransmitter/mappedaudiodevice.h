@@ -0,0 +1,46 @@
+﻿#pragma once
+
+#include <QIODevice>
+#include <QFile>
+#include <QAudioFormat>
+#include "wavfile.h"
+
+// 以内存映射方式读取WAV文件音频数据的只读设备
+// 数据直接从映射区复制给音频设备，不整体读入内存；24位PCM和64位浮点在读取时转换为播放格式
+class MappedAudioDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    MappedAudioDevice(QObject *parent = nullptr);
+    ~MappedAudioDevice();
+
+    // 映射文件并解析WAV头部，成功后设备以只读方式打开
+    bool Open(const QString &file_path);
+    void close() override;
+
+    bool isSequential() const override { return false; }
+    qint64 size() const override;
+
+    const WavInfo &get_wav_info() const { return info_; }
+    QString get_file_path() const { return file_.fileName(); }
+    // 设备输出的音频格式
+    const QAudioFormat &get_audio_format() const { return format_; }
+    // 读取指定位置的数据（按输出格式），不改变读取位置
+    QByteArray PeekAt(qint64 pos, qint64 max_size) const;
+
+protected:
+    qint64 readData(char *data, qint64 max_size) override;
+    qint64 writeData(const char *data, qint64 max_size) override;
+
+private:
+    qint64 CopyOut(qint64 pos, char *out, qint64 max_size) const;
+
+private:
+    QFile file_;
+    const uchar *mapped_{ nullptr };
+    WavInfo info_;
+    QAudioFormat format_;
+    int in_sample_bytes_{ 0 };      // 文件中每个样本的字节数
+    int out_sample_bytes_{ 0 };     // 输出每个样本的字节数
+};
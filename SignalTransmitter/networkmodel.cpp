@@ -1,16 +1,46 @@
 ﻿#include "networkmodel.h"
+#include "crc32c.h"
+#include "wavfile.h"
 #include <QFileInfo>
-#include <QMessageBox>
+#include <QDir>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QtEndian>
+#include <QtConcurrent>
+#include <QThread>
+#include <limits>
+#include <algorithm>
+#include <QDataStream>
+#ifdef Q_OS_LINUX
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <cerrno>
+#endif
 
 NetworkModel::NetworkModel(QObject *parent)
     : QObject(parent)
     , server_(new QTcpServer(this))
+    , progress_timer_(new QTimer(this))
 {
+    qRegisterMetaType<TransferSnapshot>();
     connect(server_, &QTcpServer::newConnection, this, &NetworkModel::SlotNewConnection);
+    progress_timer_->setInterval(kProgressInterval);
+    connect(progress_timer_, &QTimer::timeout, this, [this]() {
+        if (progress_dirty_) {
+            EmitProgressSnapshot();
+        }
+    });
+    set_socket_profile(kThroughputProfile);
+    ingest_dir_ = QDir::temp().filePath("SignalTransmitter_ingest");
 }
 
 NetworkModel::~NetworkModel()
-{}
+{
+    qDeleteAll(sessions_);
+    ReleaseTransferFile();
+}
 
 NetworkModel::PortError_t NetworkModel::StartListening(const QString &port)
 {
@@ -36,138 +66,1387 @@ void NetworkModel::StopListening()
 
 void NetworkModel::SlotNewConnection()
 {
-    if (server_->hasPendingConnections()) {
-        socket_ = server_->nextPendingConnection();
-        connect(socket_, &QTcpSocket::disconnected, this, &NetworkModel::SlotSocketDisconnected);
-        connect(socket_, &QTcpSocket::bytesWritten, this, &NetworkModel::SlotBytesWritten);
-        const auto client_info = QString("%1:%2")
-            .arg(socket_->peerAddress().toString())
-            .arg(socket_->peerPort());
-        emit connectionEstablished(client_info);
+    while (server_->hasPendingConnections()) {
+        auto *session = new ClientSession;
+        session->socket = server_->nextPendingConnection();
+        session->client_info = QString("%1:%2")
+            .arg(session->socket->peerAddress().toString())
+            .arg(session->socket->peerPort());
+        sessions_.insert(session->socket, session);
+        client_count_ = sessions_.size();
+        connect(session->socket, &QTcpSocket::disconnected, this, &NetworkModel::SlotSocketDisconnected);
+        connect(session->socket, &QTcpSocket::bytesWritten, this, &NetworkModel::SlotBytesWritten);
+        connect(session->socket, &QTcpSocket::readyRead, this, &NetworkModel::SlotReadyRead);
+        ApplySocketProfile(session->socket);
+        emit connectionEstablished(session->client_info);
     }
 }
 
-void NetworkModel::StartFileTransfer(const QString &file_path)
+void NetworkModel::set_socket_profile(SocketProfile_t profile)
 {
-    if (!socket_ || socket_->state() != QTcpSocket::ConnectedState) {
-        emit transferError("无连接的客户端");
+    socket_profile_ = profile;
+    if (profile == kLatencyProfile) {
+        set_watermarks(64 * 1024, 256 * 1024);
+    } else {
+        set_watermarks(2 * 1024 * 1024, 8 * 1024 * 1024);
+    }
+    for (auto *session : std::as_const(sessions_)) {
+        ApplySocketProfile(session->socket);
+    }
+}
+
+void NetworkModel::set_watermarks(qint64 low_watermark, qint64 high_watermark)
+{
+    high_watermark_ = qMax(high_watermark, kMinChunkSize);
+    low_watermark_ = qBound<qint64>(0, low_watermark, high_watermark_);
+    for (auto *session : std::as_const(sessions_)) {
+        session->effective_high_watermark = high_watermark_;
+    }
+}
+
+void NetworkModel::ApplySocketProfile(QTcpSocket *socket)
+{
+    if (socket_profile_ == kLatencyProfile) {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, 64 * 1024);
+    } else {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 0);
+        socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, 4 * 1024 * 1024);
+        // 接收上传时大接收窗口，磁盘偶尔变慢不会立即让发送端停下
+        socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 4 * 1024 * 1024);
+    }
+}
+
+void NetworkModel::UpdateThroughput(ClientSession *session, qint64 bytes)
+{
+    session->rate_window_bytes += bytes;
+    const qint64 elapsed = session->rate_timer.elapsed();
+    if (elapsed < kRateWindow) {
         return;
     }
-    if (transfer_file_) {
-        transfer_file_->close();
-        delete transfer_file_;
+    // 吞吐量做指数平滑，块大小约为kChunkInterval毫秒的发送量（取2的幂）
+    const double rate = session->rate_window_bytes * 1000.0 / elapsed;
+    session->throughput = session->throughput > 0.0 ? session->throughput * 0.5 + rate * 0.5 : rate;
+    session->rate_window_bytes = 0;
+    session->rate_timer.start();
+    qint64 chunk = kMinChunkSize;
+    while (chunk < kMaxChunkSize && chunk < session->throughput * kChunkInterval / 1000.0) {
+        chunk *= 2;
+    }
+    session->chunk_size = fixed_chunk_size_ > 0 ? fixed_chunk_size_ : chunk;
+#ifdef Q_OS_LINUX
+    // 高水位至少为两倍带宽时延积，保证等待回调期间链路不空闲
+    struct tcp_info info {};
+    socklen_t length = sizeof(info);
+    if (getsockopt(static_cast<int>(session->socket->socketDescriptor()), IPPROTO_TCP, TCP_INFO, &info, &length) == 0) {
+        session->rtt_us = info.tcpi_rtt;
+    }
+#endif
+    if (session->rtt_us > 0) {
+        const qint64 bdp = static_cast<qint64>(session->throughput * session->rtt_us / 1e6);
+        session->effective_high_watermark = qBound(high_watermark_, 2 * bdp, 16 * high_watermark_);
     }
+}
+
+bool NetworkModel::OpenTransferFile(const QString &file_path)
+{
+    ReleaseTransferFile();
     transfer_file_ = new QFile(file_path, this);
     if (!transfer_file_->open(QIODevice::ReadOnly)) {
-        emit transferError("无法打开文件: " + file_path);
-        delete transfer_file_;
-        transfer_file_ = nullptr;
-        return;
+        ReleaseTransferFile();
+        return false;
     }
     QFileInfo file_info(file_path);
-    total_bytes_ = file_info.size();
-    bytes_written_ = 0;
-    file_bytes_written_ = 0;
-    transfer_state_ = kTransferring;
+    total_bytes_ = transfer_file_->size();
+    // 文件只读取一次：优先映射，映射失败时整体读入内存
+    if (total_bytes_ > 0) {
+        file_data_ = transfer_file_->map(0, total_bytes_);
+        if (!file_data_) {
+            file_buffer_ = transfer_file_->readAll();
+            if (file_buffer_.size() != total_bytes_) {
+                ReleaseTransferFile();
+                return false;
+            }
+            file_data_ = reinterpret_cast<const uchar *>(file_buffer_.constData());
+        }
+    }
+    transfer_file_path_ = file_path;
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(file_info.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(total_bytes_));
+    hash.addData(QByteArray::number(file_info.lastModified().toMSecsSinceEpoch()));
+    file_id_ = qMax<quint64>(qFromBigEndian<quint64>(hash.result().constData()), 1);
+    PrepareTransferData(file_info.fileName());
+    return true;
+}
+
+bool NetworkModel::OpenTransferSource(const TransferSourcePtr &source)
+{
+    if (!source->file_path().isEmpty()) {
+        return OpenTransferFile(source->file_path());
+    }
+    // 旧版客户端的协议要求连续的文件内容，内存数据源发送时按块读取，与分帧客户端一样不复制整份数据；
+    // 内存数据可能随时变化，不支持续传
+    ReleaseTransferFile();
+    transfer_file_path_.clear();
+    file_id_ = 0;
+    if (!source->Open()) {
+        source->Close();
+        return false;
+    }
+    transfer_source_ = source;
+    total_bytes_ = source->size();
+    PrepareTransferData(source->metadata().value(TransferProtocol::kKeyName).toString());
+    return true;
+}
+
+QByteArray NetworkModel::TransferData(qint64 offset, qint64 length) const
+{
+    if (file_data_) {
+        return QByteArray::fromRawData(reinterpret_cast<const char *>(file_data_ + offset), length);
+    }
+    if (!transfer_source_) {
+        return QByteArray();
+    }
+    QByteArray data = transfer_source_->Read(offset, length);
+    if (!data.isEmpty() && data.size() < length) {
+        // Read返回的数据在下一次Read之前有效，需要拼接时先复制
+        data.detach();
+    }
+    while (!data.isEmpty() && data.size() < length) {
+        const QByteArray chunk = transfer_source_->Read(offset + data.size(), length - data.size());
+        if (chunk.isEmpty()) {
+            break;
+        }
+        data.append(chunk);
+    }
+    return data;
+}
+
+void NetworkModel::PrepareTransferData(const QString &file_name)
+{
+    const auto blocks = static_cast<size_t>((total_bytes_ + kHashBlockSize - 1) / kHashBlockSize);
+    block_crcs_.assign(blocks, 0);
+    block_crc_ready_.assign(blocks, 0);
+    compression_level_ = -1;
     // 发送文件头信息：文件名长度 + 文件名 + 文件大小
-    QByteArray header;
-    QDataStream stream(&header, QIODevice::WriteOnly);
+    header_.clear();
+    QDataStream stream(&header_, QIODevice::WriteOnly);
     stream.setVersion(QDataStream::Qt_6_0);
-
-    QString file_name = file_info.fileName();
     stream << file_name << total_bytes_;
+}
+
+void NetworkModel::StartFileTransfer(const QString &file_path)
+{
+    StartBatchTransfer(QStringList{ file_path });
+}
 
-    header_size_ = header.size();
-    socket_->write(header);
-    // 开始发送文件内容
-    SendNextChunk();
+void NetworkModel::StartBatchTransfer(const QStringList &file_paths, const QVariantMap &metadata)
+{
+    QList<TransferSourcePtr> sources;
+    for (const auto &file_path : file_paths) {
+        sources.append(std::make_shared<FileTransferSource>(file_path));
+    }
+    StartSourceTransfer(sources, metadata);
 }
 
-void NetworkModel::SendNextChunk()
+void NetworkModel::StartSourceTransfer(const QList<TransferSourcePtr> &sources, const QVariantMap &metadata)
 {
-    if (!transfer_file_ || !socket_) {
+    QList<ClientSession *> clients;
+    for (auto *session : std::as_const(sessions_)) {
+        if (session->socket->state() == QTcpSocket::ConnectedState) {
+            clients.append(session);
+        }
+    }
+    if (clients.isEmpty()) {
+        emit transferError("无连接的客户端");
         return;
     }
-    const qint64 chunk_size = 64 * 1024; // 64KB块大小
-    QByteArray chunk = transfer_file_->read(chunk_size);
-    qint64 bytes_written = socket_->write(chunk);
-    if (bytes_written == -1) {
-        transfer_state_ = kTransferError;
-        emit transferError("写入套接字失败");
-        // 发生错误时清理文件资源
-        if (transfer_file_) {
-            transfer_file_->close();
-            delete transfer_file_;
-            transfer_file_ = nullptr;
+    if (transfer_state_ == kTransferring) {
+        emit transferError("文件正在传输中");
+        return;
+    }
+    if (sources.isEmpty()) {
+        emit transferError("未选择文件");
+        return;
+    }
+    // 单个数据源时旧版客户端也能接收（文件可续传）；多个只能用分帧协议发送
+    const bool legacy_clients = std::any_of(clients.cbegin(), clients.cend(), [](const ClientSession *session) {
+        return !session->framed;
+    });
+    if (sources.size() == 1 && legacy_clients) {
+        if (!OpenTransferSource(sources.first())) {
+            emit transferError("无法打开数据源: " + sources.first()->metadata().value(TransferProtocol::kKeyName).toString());
+            return;
         }
+    } else {
+        ReleaseTransferFile();
+        transfer_file_path_.clear();
+        file_id_ = 0;
+    }
+    batch_total_bytes_ = 0;
+    for (int i = 0; i < sources.size(); ++i) {
+        BatchFile file;
+        file.source = sources.at(i);
+        file.size = file.source->size();
+        file.metadata = file.source->metadata();
+        file.metadata.insert(metadata);
+        file.metadata.insert(TransferProtocol::kKeyBatchIndex, i);
+        file.metadata.insert(TransferProtocol::kKeyBatchCount, static_cast<int>(sources.size()));
+        batch_total_bytes_ += file.size;
+        batch_files_.append(file);
+    }
+    QList<ClientSession *> receivers;
+    for (auto *session : std::as_const(clients)) {
+        if (!session->framed && batch_files_.size() > 1) {
+            emit clientTransferError(session->client_info, "客户端不支持批量传输");
+            continue;
+        }
+        receivers.append(session);
+    }
+    if (receivers.isEmpty()) {
+        ReleaseTransferFile();
+        emit transferError("没有支持批量传输的客户端");
         return;
     }
+    // 先标记所有客户端再开始发送，避免某个客户端立即失败时提前释放文件
+    transfer_state_ = kTransferring;
+    completed_clients_ = 0;
+    progress_timer_->start();
+    for (auto *session : std::as_const(sessions_)) {
+        session->state = kIdle;
+    }
+    for (auto *session : std::as_const(receivers)) {
+        session->state = kTransferring;
+    }
+    for (auto *session : std::as_const(receivers)) {
+        if (session->framed) {
+            StartFramedSession(session);
+        } else {
+            StartSession(session, 0);
+        }
+    }
 }
 
-void NetworkModel::SlotSocketDisconnected()
+void NetworkModel::ResetSessionTransfer(ClientSession *session)
 {
-    if (transfer_state_ == kTransferring) {
+    // 字节计数从连接开始累计，本次传输从当前写入位置算起
+    session->state = kTransferring;
+    session->transfer_base = session->bytes_queued;
+    session->header_size = 0;
+    session->all_queued = false;
+    session->block_marks.clear();
+    session->chunk_size = fixed_chunk_size_ > 0 ? fixed_chunk_size_ : kDefaultChunkSize;
+    session->effective_high_watermark = high_watermark_;
+    session->rate_window_bytes = 0;
+    session->throughput = 0.0;
+    session->rate_timer.start();
+    session->compressed = false;
+}
+
+void NetworkModel::StartSession(ClientSession *session, qint64 offset)
+{
+    // 文件与音频流不能交错发送，先结束该客户端的音频流
+    EndSessionStream(session);
+    ResetSessionTransfer(session);
+    session->start_offset = qBound<qint64>(0, offset / kHashBlockSize * kHashBlockSize, total_bytes_);
+    session->total_bytes = total_bytes_;
+    session->file_bytes_queued = session->start_offset;
+    session->file_bytes_written = session->start_offset;
+    QByteArray header = header_;
+    if (session->verified) {
+        QDataStream stream(&header, QIODevice::WriteOnly | QIODevice::Append);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream << kExtensionMagic << static_cast<quint32>(kHashBlockSize) << file_id_ << session->start_offset;
+        if (session->protocol_version >= 2) {
+            // 同一次传输的所有客户端使用相同的压缩级别，压缩结果可以共用
+            if (compression_level_ < 0) {
+                compression_level_ = compression_enabled_ ? ChooseCompressionLevel() : 0;
+            }
+            session->compressed = compression_level_ > 0;
+            stream << (session->compressed ? kCodecZlib : kCodecNone);
+        }
+    }
+    session->header_size = header.size();
+    if (!WriteToSession(session, header.constData(), header.size())) {
+        return;
+    }
+#ifdef Q_OS_LINUX
+    // 文件内容等文件头写出后用sendfile发送；校验扩展需要在数据中插入CRC，走普通发送
+    session->zero_copy = zero_copy_enabled_ && !session->verified && total_bytes_ > 0
+        && transfer_file_ && transfer_file_->handle() >= 0 && session->socket->socketDescriptor() >= 0;
+#endif
+    if (!session->zero_copy) {
+        // 开始发送文件内容
+        FillSendPipeline(session);
+    }
+}
+
+bool NetworkModel::WriteToSession(ClientSession *session, const void *data, qint64 size)
+{
+    if (session->socket->write(static_cast<const char *>(data), size) != size) {
+        FinishSession(session, kTransferError, "写入套接字失败");
+        return false;
+    }
+    session->bytes_queued += size;
+    return true;
+}
+
+bool NetworkModel::WriteFrameHeader(ClientSession *session, TransferProtocol::FrameType_t type, quint16 stream_id,
+                                    quint32 sequence, qint64 length, quint8 flags)
+{
+    TransferProtocol::FrameHeader header;
+    header.type = type;
+    header.flags = flags;
+    header.stream_id = stream_id;
+    header.length = static_cast<quint32>(length);
+    header.sequence = sequence;
+    uchar buffer[TransferProtocol::kFrameHeaderSize];
+    TransferProtocol::EncodeFrameHeader(header, buffer);
+    return WriteToSession(session, buffer, TransferProtocol::kFrameHeaderSize);
+}
+
+void NetworkModel::StartFramedSession(ClientSession *session)
+{
+    // 分帧客户端的音频流与文件帧交错发送，不需要结束
+    ResetSessionTransfer(session);
+    session->total_bytes = batch_total_bytes_;
+    session->file_bytes_queued = 0;
+    session->file_bytes_written = 0;
+    session->batch_index = 0;
+    session->batch_offset = 0;
+    session->file_begun = false;
+    session->zero_copy = false;
+    FillFramedPipeline(session);
+}
+
+void NetworkModel::FillFramedPipeline(ClientSession *session)
+{
+    if (batch_files_.isEmpty() || session->state != kTransferring) {
+        return;
+    }
+    // 音频帧优先写入，文件帧填充到高水位；各文件依次发送，不等待客户端应答
+    FlushStream(session);
+    while (!session->all_queued && session->socket->bytesToWrite() < session->effective_high_watermark) {
+        if (session->batch_index == batch_files_.size()) {
+            uchar count[4];
+            qToBigEndian(static_cast<quint32>(batch_files_.size()), count);
+            if (!WriteFrameHeader(session, TransferProtocol::kFrameBatchEnd, 0, 0, 4) || !WriteToSession(session, count, 4)) {
+                return;
+            }
+            session->all_queued = true;
+            session->transfer_end = session->bytes_queued;
+            break;
+        }
+        BatchFile &file = batch_files_[session->batch_index];
+        // 流编号0留给音频流
+        const auto stream_id = static_cast<quint16>(session->batch_index % 0xFFFF + 1);
+        if (!session->file_begun) {
+            if (!file.loaded && !LoadBatchFile(file)) {
+                FinishSession(session, kTransferError, "无法读取: " + file.metadata.value(TransferProtocol::kKeyName).toString());
+                return;
+            }
+            const QByteArray frame = TransferProtocol::MakeFrame(TransferProtocol::kFrameFileBegin, stream_id, 0,
+                                                                 TransferProtocol::EncodeMetadata(file.metadata));
+            if (!WriteToSession(session, frame.constData(), frame.size())) {
+                return;
+            }
+            session->file_begun = true;
+            session->batch_offset = 0;
+            session->frame_sequence = 0;
+            continue;
+        }
+        if (session->batch_offset < file.size) {
+            // 数据源按需映射或序列化一段，内存数据不整体复制
+            const QByteArray data = file.source->Read(session->batch_offset, qMin(session->chunk_size, file.size - session->batch_offset));
+            if (data.isEmpty()) {
+                FinishSession(session, kTransferError, "无法读取: " + file.metadata.value(TransferProtocol::kKeyName).toString());
+                return;
+            }
+            const qint64 length = data.size();
+            if (!WriteFrameHeader(session, TransferProtocol::kFrameFileData, stream_id, session->frame_sequence, length)
+                || !WriteToSession(session, data.constData(), length)) {
+                return;
+            }
+            ++session->frame_sequence;
+            // 其他客户端已计算过的部分不再重复计算（已计算的范围总是从文件开头连续的）
+            const qint64 end = session->batch_offset + length;
+            if (end > file.crc_bytes) {
+                const qint64 skip = file.crc_bytes - session->batch_offset;
+                file.crc = Crc32c(data.constData() + skip, length - skip, file.crc);
+                file.crc_bytes = end;
+            }
+            session->batch_offset += length;
+            session->file_bytes_queued += length;
+            session->block_marks.append({ session->bytes_queued, session->file_bytes_queued });
+            continue;
+        }
+        uchar crc[4];
+        qToBigEndian(file.crc, crc);
+        if (!WriteFrameHeader(session, TransferProtocol::kFrameFileEnd, stream_id, session->frame_sequence, 4)
+            || !WriteToSession(session, crc, 4)) {
+            return;
+        }
+        session->file_begun = false;
+        ++session->batch_index;
+        ReleasePassedBatchFiles();
+    }
+}
+
+bool NetworkModel::LoadBatchFile(BatchFile &file)
+{
+    // 数据源大小在开始传输时确定，之后变化（如文件被修改）则不再发送
+    file.loaded = file.source->Open() && file.source->size() == file.size;
+    if (!file.loaded) {
+        file.source->Close();
+    }
+    return file.loaded;
+}
+
+void NetworkModel::UnloadBatchFile(BatchFile &file)
+{
+    file.source->Close();
+    file.loaded = false;
+}
+
+void NetworkModel::ReleasePassedBatchFiles()
+{
+    // 所有分帧客户端都已发送过的文件不再需要
+    int first_needed = static_cast<int>(batch_files_.size());
+    for (const auto *session : std::as_const(sessions_)) {
+        if (session->state == kTransferring && session->framed) {
+            first_needed = qMin(first_needed, session->batch_index);
+        }
+    }
+    // 只检查上次释放位置之后的文件，每个文件完成时不必从头扫描
+    for (; batch_released_ < first_needed; ++batch_released_) {
+        if (batch_files_[batch_released_].loaded) {
+            UnloadBatchFile(batch_files_[batch_released_]);
+        }
+    }
+}
+
+void NetworkModel::SlotReadyRead()
+{
+    auto *socket = qobject_cast<QTcpSocket *>(sender());
+    ClientSession *session = sessions_.value(socket);
+    if (!session) {
+        return;
+    }
+    // 分帧客户端在请求之后发送的都是上传帧
+    if (session->framed) {
+        if (session->ingest_buffer.isEmpty()) {
+            session->ingest_buffer = socket->readAll();
+        } else {
+            session->ingest_buffer += socket->readAll();
+        }
+        ParseIngestFrames(session);
+        return;
+    }
+    session->request += socket->readAll();
+    if (session->request.size() >= kResumeRequestSize) {
+        const QByteArray rest = session->request.mid(kResumeRequestSize);
+        session->request.truncate(kResumeRequestSize);
+        HandleClientRequest(session);
+        session->request.clear();
+        if (session->framed && !rest.isEmpty()) {
+            session->ingest_buffer = rest;
+            ParseIngestFrames(session);
+        }
+    }
+}
+
+void NetworkModel::HandleClientRequest(ClientSession *session)
+{
+    QDataStream stream(session->request);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic{ 0 };
+    quint32 version{ 0 };
+    quint64 file_id{ 0 };
+    qint64 offset{ 0 };
+    stream >> magic >> version >> file_id >> offset;
+    if (magic != kResumeRequestMagic || version < kMinProtocolVersion) {
+        return;
+    }
+    session->verified = true;
+    session->protocol_version = qMin(version, kProtocolVersion);
+    if (session->protocol_version >= TransferProtocol::kVersion && !session->framed && session->state != kTransferring) {
+        // 切换到分帧协议，之前按旧格式开始的音频流先结束
+        EndSessionStream(session);
+        session->framed = true;
+        QVariantMap hello;
+        hello.insert(TransferProtocol::kKeyProtocolVersion, TransferProtocol::kVersion);
+        const QByteArray frame = TransferProtocol::MakeFrame(TransferProtocol::kFrameHello, 0, 0, TransferProtocol::EncodeMetadata(hello));
+        WriteToSession(session, frame.constData(), frame.size());
+    }
+    if (session->framed) {
+        if (file_id != 0) {
+            emit clientTransferError(session->client_info, "无法续传: 分帧协议不支持续传");
+        }
+        return;
+    }
+    if (file_id == 0 || session->state == kTransferring) {
+        // 新客户端只开启校验，等待下一次广播
+        return;
+    }
+    // 重连的客户端从最后一个校验通过的块继续接收
+    if (transfer_state_ != kTransferring) {
+        if (transfer_file_path_.isEmpty() || !OpenTransferFile(transfer_file_path_)) {
+            emit clientTransferError(session->client_info, "无法续传: 文件不可用");
+            return;
+        }
+        if (file_id != file_id_) {
+            ReleaseTransferFile();
+            emit clientTransferError(session->client_info, "无法续传: 文件已变化");
+            return;
+        }
+        transfer_state_ = kTransferring;
+        completed_clients_ = 0;
+        progress_timer_->start();
+    } else if (file_id != file_id_) {
+        emit clientTransferError(session->client_info, "无法续传: 正在传输其他文件");
+        return;
+    }
+    StartSession(session, offset);
+    emit clientResumed(session->client_info, session->start_offset);
+}
+
+void NetworkModel::set_ingest_playback_enabled(bool enabled)
+{
+    ingest_playback_enabled_ = enabled;
+    if (!enabled) {
+        playback_upload_ = nullptr;
+    }
+}
+
+void NetworkModel::ParseIngestFrames(ClientSession *session)
+{
+    // 在缓冲区中原地解析完整的帧，最后一次性移除已处理的部分
+    const QByteArray &buffer = session->ingest_buffer;
+    qsizetype pos{ 0 };
+    while (buffer.size() - pos >= TransferProtocol::kFrameHeaderSize) {
+        TransferProtocol::FrameHeader header;
+        if (!TransferProtocol::DecodeFrameHeader(reinterpret_cast<const uchar *>(buffer.constData() + pos), header)
+            || header.length > kMaxIngestFrame) {
+            emit ingestError(session->client_info, "上传数据格式错误");
+            session->ingest_buffer.clear();
+            // 不能在读取回调中同步断开（会删除会话）
+            QTcpSocket *socket = session->socket;
+            QMetaObject::invokeMethod(socket, [socket]() { socket->abort(); }, Qt::QueuedConnection);
+            return;
+        }
+        const qint64 frame_size = TransferProtocol::kFrameHeaderSize + static_cast<qint64>(header.length);
+        if (buffer.size() - pos < frame_size) {
+            break;
+        }
+        HandleIngestFrame(session, header, buffer.constData() + pos + TransferProtocol::kFrameHeaderSize);
+        pos += frame_size;
+    }
+    session->ingest_buffer.remove(0, pos);
+}
+
+void NetworkModel::HandleIngestFrame(ClientSession *session, const TransferProtocol::FrameHeader &header, const char *payload)
+{
+    switch (header.type) {
+    case TransferProtocol::kFrameFileBegin:
+    case TransferProtocol::kFrameStreamBegin: {
+        QVariantMap metadata;
+        TransferProtocol::DecodeMetadata(QByteArray::fromRawData(payload, header.length), metadata);
+        BeginUpload(session, header, metadata);
+        break;
+    }
+    case TransferProtocol::kFrameFileData:
+    case TransferProtocol::kFrameStreamData: {
+        IngestUpload *upload = session->uploads.value(header.stream_id);
+        if (!upload) {
+            return;
+        }
+        const char *data = payload;
+        qint64 size = header.length;
+        if (header.type == TransferProtocol::kFrameStreamData) {
+            // 跳过时间戳
+            if (size < 8) {
+                return;
+            }
+            data += 8;
+            size -= 8;
+        }
+        QByteArray uncompressed;
+        if (header.flags & TransferProtocol::kFlagCompressed) {
+            // qCompress格式的前4字节为解压后长度（大端序），解压前检查，避免恶意数据让解压分配任意大的内存
+            if (size < 4 || qFromBigEndian<quint32>(data) > kMaxIngestFrame) {
+                FinishUpload(session, header.stream_id, "解压失败");
+                return;
+            }
+            uncompressed = qUncompress(reinterpret_cast<const uchar *>(data), size);
+            if (uncompressed.isEmpty() && size > 0) {
+                FinishUpload(session, header.stream_id, "解压失败");
+                return;
+            }
+            data = uncompressed.constData();
+            size = uncompressed.size();
+        }
+        const bool ok = upload->is_stream ? upload->stream_writer.Write(data, size) : upload->file_writer.Write(data, size);
+        if (!ok) {
+            FinishUpload(session, header.stream_id, "写入文件失败");
+            return;
+        }
+        if (!upload->is_stream) {
+            upload->crc = Crc32c(data, size, upload->crc);
+        }
+        upload->received += size;
+        ForwardIngestAudio(upload, data, size);
+        break;
+    }
+    case TransferProtocol::kFrameFileEnd: {
+        const IngestUpload *upload = session->uploads.value(header.stream_id);
+        if (!upload) {
+            return;
+        }
+        if (header.length < 4 || qFromBigEndian<quint32>(payload) != upload->crc) {
+            FinishUpload(session, header.stream_id, "校验失败");
+        } else if (upload->expected_size >= 0 && upload->received != upload->expected_size) {
+            FinishUpload(session, header.stream_id, "文件大小不符");
+        } else {
+            FinishUpload(session, header.stream_id);
+        }
+        break;
+    }
+    case TransferProtocol::kFrameStreamEnd:
+        FinishUpload(session, header.stream_id);
+        break;
+    default:
+        // 客户端发送的其他帧（如BatchEnd）不需要处理
+        break;
+    }
+}
+
+void NetworkModel::BeginUpload(ClientSession *session, const TransferProtocol::FrameHeader &header, const QVariantMap &metadata)
+{
+    if (!ingest_enabled_) {
+        emit ingestError(session->client_info, "服务器未开启上传接收");
+        return;
+    }
+    // 同一流编号上未结束的上传视为中断
+    FinishUpload(session, header.stream_id, "上传被中断");
+
+    auto *upload = new IngestUpload;
+    upload->is_stream = header.type == TransferProtocol::kFrameStreamBegin;
+    const QString time = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
+    // 只保留文件名部分，不允许写到接收目录之外
+    upload->name = QFileInfo(metadata.value(TransferProtocol::kKeyName).toString()).fileName();
+    if (upload->name.isEmpty()) {
+        upload->name = upload->is_stream ? QString("stream_%1.wav").arg(time) : QString("upload_%1.bin").arg(time);
+    }
+    QDir().mkpath(ingest_dir_);
+    const QString path = IngestFilePath(upload->name);
+    bool ok{ false };
+    if (upload->is_stream) {
+        QAudioFormat format;
+        format.setSampleRate(metadata.value(TransferProtocol::kKeySampleRate).toInt());
+        format.setChannelCount(metadata.value(TransferProtocol::kKeyChannels).toInt());
+        format.setSampleFormat(static_cast<QAudioFormat::SampleFormat>(metadata.value(TransferProtocol::kKeySampleFormat).toInt()));
+        if (format.isValid()) {
+            upload->format = format;
+            upload->audio_offset = WavStreamWriter::kHeaderSize;
+            ok = upload->stream_writer.Open(path, format);
+        }
+    } else {
+        upload->expected_size = metadata.value(TransferProtocol::kKeySize, -1).toLongLong();
+        upload->is_wav = metadata.value(TransferProtocol::kKeyContentType).toString() == "audio/wav";
+        upload->audio_offset = upload->is_wav ? kAudioUnknown : kNotAudio;
+        ok = upload->file_writer.Open(path, upload->expected_size);
+    }
+    if (!ok) {
+        emit ingestError(session->client_info, "无法保存上传: " + upload->name);
+        delete upload;
+        return;
+    }
+    session->uploads.insert(header.stream_id, upload);
+    emit ingestStarted(session->client_info, upload->name, upload->expected_size);
+}
+
+void NetworkModel::FinishUpload(ClientSession *session, quint16 stream_id, const QString &error_message)
+{
+    IngestUpload *upload = session->uploads.take(stream_id);
+    if (!upload) {
+        return;
+    }
+    if (playback_upload_ == upload) {
+        playback_upload_ = nullptr;
+    }
+    QString path;
+    bool ok{ false };
+    if (upload->is_stream) {
+        path = upload->stream_writer.get_file_path();
+        ok = upload->stream_writer.Close();
+    } else {
+        path = upload->file_writer.get_file_path();
+        ok = upload->file_writer.Close();
+    }
+    if (!error_message.isEmpty() || !ok) {
+        emit ingestError(session->client_info, upload->name + ": " + (error_message.isEmpty() ? "写入文件失败" : error_message));
+        delete upload;
+        return;
+    }
+    emit ingestCompleted(session->client_info, path, upload->received);
+    // 未实时播放的WAV文件在完整保存后读取文件头
+    if (upload->is_wav && !upload->format.isValid()) {
+        QFile file(path);
+        WavInfo info;
+        if (file.open(QIODevice::ReadOnly)) {
+            const QByteArray head = file.read(kWavHeadLimit);
+            if (ParseWavHeader(reinterpret_cast<const uchar *>(head.constData()), head.size(), info) && !info.NeedsConversion()) {
+                upload->format = info.ToAudioFormat();
+                upload->audio_offset = info.data_offset;
+            }
+        }
+    }
+    if (upload->format.isValid()) {
+        emit ingestAudioFileReady(path, upload->audio_offset, upload->format);
+    }
+    delete upload;
+}
+
+void NetworkModel::ForwardIngestAudio(IngestUpload *upload, const char *data, qint64 size)
+{
+    if (!ingest_playback_enabled_ || upload->audio_offset == kNotAudio
+        || (playback_upload_ && playback_upload_ != upload)) {
+        return;
+    }
+    if (upload->audio_offset == kAudioUnknown) {
+        // 暂存WAV文件开头，直到能解析出格式和data块位置
+        const qint64 chunk_start = upload->received - size;
+        upload->wav_head.append(data, qMin(size, kWavHeadLimit - upload->wav_head.size()));
+        WavInfo info;
+        if (!ParseWavHeader(reinterpret_cast<const uchar *>(upload->wav_head.constData()), upload->wav_head.size(), info)) {
+            if (upload->wav_head.size() >= kWavHeadLimit) {
+                upload->audio_offset = kNotAudio;
+                upload->wav_head.clear();
+            }
+            return;
+        }
+        upload->wav_head.clear();
+        if (info.NeedsConversion()) {
+            upload->audio_offset = kNotAudio;
+            return;
+        }
+        upload->format = info.ToAudioFormat();
+        upload->audio_offset = info.data_offset;
+        // 之前的块都没有完整的data块头，样本从当前块中开始
+        const qint64 skip = qMax<qint64>(0, info.data_offset - chunk_start);
+        data += qMin(skip, size);
+        size -= qMin(skip, size);
+    }
+    if (!upload->format.isValid() || size <= 0) {
+        return;
+    }
+    playback_upload_ = upload;
+    emit ingestAudioData(QByteArray(data, size), upload->format);
+}
+
+QString NetworkModel::IngestFilePath(const QString &name) const
+{
+    // 同名文件已存在时追加序号
+    const QDir dir(ingest_dir_);
+    const QFileInfo info(name);
+    QString path = dir.filePath(name);
+    for (int i = 1; QFileInfo::exists(path); ++i) {
+        const QString suffix = info.suffix().isEmpty() ? QString() : "." + info.suffix();
+        path = dir.filePath(QString("%1_%2%3").arg(info.completeBaseName()).arg(i).arg(suffix));
+    }
+    return path;
+}
+
+quint32 NetworkModel::BlockCrc(qint64 block)
+{
+    const auto index = static_cast<size_t>(block);
+    if (!block_crc_ready_[index]) {
+        // 内存数据源的块校验值取自Read()读出的同一范围
+        const qint64 begin = block * kHashBlockSize;
+        const QByteArray data = TransferData(begin, qMin(kHashBlockSize, total_bytes_ - begin));
+        block_crcs_[index] = Crc32c(data.constData(), data.size());
+        block_crc_ready_[index] = 1;
+    }
+    return block_crcs_[index];
+}
+
+quint32 NetworkModel::FileDigest()
+{
+    // 整文件摘要为各块CRC32C（大端序）的CRC32C，续传的客户端可用已保存部分的块校验值核对
+    quint32 digest{ 0 };
+    for (qint64 block = 0; block < static_cast<qint64>(block_crcs_.size()); ++block) {
+        uchar bytes[4];
+        qToBigEndian(BlockCrc(block), bytes);
+        digest = Crc32c(bytes, 4, digest);
+    }
+    return digest;
+}
+
+qint64 NetworkModel::WireToFileOffset(const ClientSession *session, qint64 wire_bytes) const
+{
+    if (!session->verified) {
+        return qMin(session->start_offset + wire_bytes, total_bytes_);
+    }
+    const qint64 blocks = wire_bytes / (kHashBlockSize + 4);
+    const qint64 remainder = wire_bytes % (kHashBlockSize + 4);
+    return qMin(session->start_offset + blocks * kHashBlockSize + qMin(remainder, kHashBlockSize), total_bytes_);
+}
+
+void NetworkModel::StartZeroCopy(ClientSession *session)
+{
+    // 此时文件头已全部交给内核，之后直接向套接字描述符写入不会打乱顺序
+    session->send_notifier = new QSocketNotifier(session->socket->socketDescriptor(), QSocketNotifier::Write, this);
+    connect(session->send_notifier, &QSocketNotifier::activated, this, [this, session]() {
+        SendZeroCopy(session);
+    });
+    SendZeroCopy(session);
+}
+
+void NetworkModel::StopZeroCopy(ClientSession *session)
+{
+    session->zero_copy = false;
+    if (session->send_notifier) {
+        session->send_notifier->setEnabled(false);
+        session->send_notifier->deleteLater();
+        session->send_notifier = nullptr;
+    }
+}
+
+void NetworkModel::SendZeroCopy(ClientSession *session)
+{
+#ifdef Q_OS_LINUX
+    if (!transfer_file_ || session->state != kTransferring) {
+        StopZeroCopy(session);
+        return;
+    }
+    if (session->send_notifier) {
+        session->send_notifier->setEnabled(false);
+    }
+    const int socket_fd = static_cast<int>(session->socket->socketDescriptor());
+    const int file_fd = transfer_file_->handle();
+    // 一直发送到套接字缓冲区满（EAGAIN），再等待可写通知；sendfile使用各自的偏移，不影响共享的文件描述符
+    bool would_block{ false };
+    while (session->file_bytes_written < total_bytes_) {
+        off_t offset = session->file_bytes_written;
+        const ssize_t n = sendfile(socket_fd, file_fd, &offset,
+            static_cast<size_t>(qMin(kZeroCopyChunk, total_bytes_ - session->file_bytes_written)));
+        if (n > 0) {
+            session->file_bytes_written += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            would_block = true;
+            break;
+        }
+        if (n < 0 && (errno == EINVAL || errno == ENOSYS) && session->file_bytes_written == 0) {
+            // 文件系统或套接字不支持sendfile，改用普通方式发送
+            StopZeroCopy(session);
+            FillSendPipeline(session);
+            return;
+        }
+        // 写入失败或文件被截断
+        StopZeroCopy(session);
+        FinishSession(session, kTransferError, "写入套接字失败");
+        return;
+    }
+    session->file_bytes_queued = session->file_bytes_written;
+    MarkProgress();
+    if (would_block) {
+        session->send_notifier->setEnabled(true);
+        return;
+    }
+    // 该客户端传输完成
+    StopZeroCopy(session);
+    FinishSession(session, kTransferCompleted);
+#else
+    Q_UNUSED(session);
+#endif
+}
+
+void NetworkModel::FillSendPipeline(ClientSession *session)
+{
+    if ((!file_data_ && !transfer_source_ && total_bytes_ > 0) || session->state != kTransferring) {
+        return;
+    }
+    // 保持套接字中有足够的排队数据，不必每次写出回调后才补充一块；文件内容排完后立即结束
+    while (!session->all_queued
+        && (session->socket->bytesToWrite() < session->effective_high_watermark || session->file_bytes_queued == total_bytes_)) {
+        if (session->file_bytes_queued == total_bytes_) {
+            // 文件内容已全部排队，校验扩展最后附加整文件摘要
+            if (session->verified) {
+                uchar bytes[4];
+                qToBigEndian(FileDigest(), bytes);
+                if (!WriteToSession(session, bytes, 4)) {
+                    return;
+                }
+            }
+            session->all_queued = true;
+            session->transfer_end = session->bytes_queued;
+            break;
+        }
+        if (session->compressed) {
+            // 下一块尚未压缩完成时暂停，压缩完成后继续
+            if (!QueueCompressedBlock(session)) {
+                return;
+            }
+            continue;
+        }
+        const qint64 queued = session->file_bytes_queued;
+        const qint64 block_end = session->verified
+            ? qMin((queued / kHashBlockSize + 1) * kHashBlockSize, total_bytes_)
+            : total_bytes_;
+        const qint64 length = qMin(session->chunk_size, block_end - queued);
+        const QByteArray data = TransferData(queued, length);
+        if (data.size() != length) {
+            FinishSession(session, kTransferError, "无法读取数据源");
+            return;
+        }
+        if (!WriteToSession(session, data.constData(), length)) {
+            return;
+        }
+        session->file_bytes_queued += length;
+        if (session->verified && session->file_bytes_queued == block_end) {
+            // 校验块发送完后附加该块的CRC32C
+            uchar bytes[4];
+            qToBigEndian(BlockCrc((block_end - 1) / kHashBlockSize), bytes);
+            if (!WriteToSession(session, bytes, 4)) {
+                return;
+            }
+        }
+    }
+}
+
+bool NetworkModel::QueueCompressedBlock(ClientSession *session)
+{
+    const qint64 block = session->file_bytes_queued / kHashBlockSize;
+    RequestCompressedBlocks(block);
+    const QFuture<QByteArray> future = compressed_blocks_.value(block);
+    if (!future.isFinished()) {
+        return false;
+    }
+    // 压缩后没有变小的块按原样发送
+    const QByteArray compressed = future.result();
+    const qint64 begin = block * kHashBlockSize;
+    const qint64 length = qMin(kHashBlockSize, total_bytes_ - begin);
+    const bool use_compressed = !compressed.isEmpty();
+    // 先取校验值：内存数据源计算校验值时的读取会使之前读出的数据失效
+    uchar crc[4];
+    qToBigEndian(BlockCrc(block), crc);
+    const QByteArray data = use_compressed ? compressed : TransferData(begin, length);
+    if (data.size() != (use_compressed ? compressed.size() : length)) {
+        FinishSession(session, kTransferError, "无法读取数据源");
+        return false;
+    }
+    uchar frame[4];
+    qToBigEndian(use_compressed ? (kCompressedFlag | static_cast<quint32>(compressed.size())) : static_cast<quint32>(length), frame);
+    if (!WriteToSession(session, frame, 4)
+        || !WriteToSession(session, data.constData(), data.size())
+        || !WriteToSession(session, crc, 4)) {
+        return false;
+    }
+    session->file_bytes_queued = begin + length;
+    session->block_marks.append({ session->bytes_queued, session->file_bytes_queued });
+    TrimCompressedBlocks();
+    return true;
+}
+
+int NetworkModel::ChooseCompressionLevel() const
+{
+    if (total_bytes_ <= 0) {
+        return 0;
+    }
+    // 从文件中均匀取4个片段，测量快速（级别1）和高压缩比（级别6）两种设置的压缩比和速度
+    QByteArray sample;
+    for (int i = 0; i < 4; ++i) {
+        const qint64 begin = qMax<qint64>(0, qMin(total_bytes_ * i / 4, total_bytes_ - kCompressionSample));
+        sample.append(TransferData(begin, qMin(kCompressionSample, total_bytes_ - begin)));
+    }
+    // 压缩与发送并行进行，有效速率取压缩速度（多线程）和链路按压缩比放大后的速率中较小者
+    const double link = link_throughput_ > 0.0 ? link_throughput_ : kAssumedLinkSpeed;
+    const int threads = qMax(1, QThread::idealThreadCount());
+    double best_rate = link;
+    int best_level{ 0 };
+    for (const int level : { 1, 6 }) {
+        QElapsedTimer timer;
+        timer.start();
+        const QByteArray compressed = qCompress(sample, level);
+        const double seconds = qMax<qint64>(timer.nsecsElapsed(), 1000) / 1e9;
+        const double ratio = static_cast<double>(compressed.size()) / sample.size();
+        const double rate = qMin(sample.size() / seconds * threads, link / ratio);
+        // 至少快10%才值得压缩
+        if (rate > best_rate * 1.1) {
+            best_rate = rate;
+            best_level = level;
+        }
+    }
+    return best_level;
+}
+
+void NetworkModel::RequestCompressedBlocks(qint64 first_block)
+{
+    const qint64 blocks = static_cast<qint64>(block_crcs_.size());
+    const int level = compression_level_;
+    for (qint64 block = first_block; block < qMin(first_block + kCompressAhead, blocks); ++block) {
+        if (compressed_blocks_.contains(block)) {
+            continue;
+        }
+        // 数据在网络线程中取出（内存数据源的Read不要求线程安全），压缩在线程池中进行
+        const qint64 length = qMin(kHashBlockSize, total_bytes_ - block * kHashBlockSize);
+        QByteArray data = TransferData(block * kHashBlockSize, length);
+        if (transfer_source_) {
+            data.detach();
+        }
+        QFuture<QByteArray> future = QtConcurrent::run([data, length, level]() {
+            if (data.size() != length) {
+                return QByteArray();
+            }
+            QByteArray compressed = qCompress(data, level);
+            if (compressed.size() >= length) {
+                compressed.clear();
+            }
+            return compressed;
+        });
+        future.then(this, [this](const QByteArray &) {
+            ResumeCompressedSessions();
+        });
+        compressed_blocks_.insert(block, future);
+    }
+}
+
+void NetworkModel::TrimCompressedBlocks()
+{
+    // 所有压缩客户端都已发送过的块不再需要
+    qint64 first_needed{ std::numeric_limits<qint64>::max() };
+    for (const auto *session : std::as_const(sessions_)) {
+        if (session->state == kTransferring && session->compressed) {
+            first_needed = qMin(first_needed, session->file_bytes_queued / kHashBlockSize);
+        }
+    }
+    for (auto it = compressed_blocks_.begin(); it != compressed_blocks_.end();) {
+        if (it.key() < first_needed) {
+            it = compressed_blocks_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void NetworkModel::ResumeCompressedSessions()
+{
+    for (auto *session : std::as_const(sessions_)) {
+        if (session->state == kTransferring && session->compressed) {
+            FillSendPipeline(session);
+        }
+    }
+}
+
+void NetworkModel::FinishSession(ClientSession *session, TransferState_t state, const QString &error_message)
+{
+    if (session->state != kTransferring) {
+        return;
+    }
+    session->state = state;
+    // 记录链路速度，供下次选择压缩级别
+    if (session->throughput > 0.0) {
+        link_throughput_ = session->throughput;
+    }
+    if (state == kTransferCompleted) {
+        ++completed_clients_;
+        emit clientTransferCompleted(session->client_info);
+    } else {
+        emit clientTransferError(session->client_info, error_message);
+    }
+    ReleasePassedBatchFiles();
+    for (const auto *other : std::as_const(sessions_)) {
+        if (other->state == kTransferring) {
+            return;
+        }
+    }
+    // 所有客户端都已结束，发出最终进度并释放文件资源
+    progress_timer_->stop();
+    EmitProgressSnapshot();
+    ReleaseTransferFile();
+    if (completed_clients_ > 0) {
+        transfer_state_ = kTransferCompleted;
+        emit transferCompleted();
+    } else {
         transfer_state_ = kTransferError;
-        emit transferError("客户端连接断开");
+        emit transferError(error_message);
+    }
+}
+
+void NetworkModel::set_streaming_enabled(bool enabled)
+{
+    if (streaming_enabled_ && !enabled) {
+        EndStream();
+    }
+    streaming_enabled_ = enabled;
+}
+
+void NetworkModel::SlotStreamAudioBlock(const AudioBlockRef &block, const QAudioFormat &format)
+{
+    if (!streaming_enabled_ || block.IsNull()) {
+        return;
+    }
+    // 格式变化时各客户端重新发送流头
+    if (format != stream_format_) {
+        EndStream();
+        stream_format_ = format;
+    }
+    stream_last_sequence_ = block.sequence();
+    StreamFrame frame{ block, QByteArray() };
+    const qint64 max_bytes = qMax<qint64>(format.bytesForDuration(kStreamMaxLatency), block.size());
+    for (auto *session : std::as_const(sessions_)) {
+        // 旧版客户端传输文件期间不发送音频，分帧客户端与文件帧交错发送
+        if ((session->state == kTransferring && !session->framed) || session->socket->state() != QTcpSocket::ConnectedState) {
+            continue;
+        }
+        if (!session->stream_started) {
+            QByteArray header;
+            if (session->framed) {
+                QVariantMap info;
+                info.insert(TransferProtocol::kKeySampleRate, format.sampleRate());
+                info.insert(TransferProtocol::kKeyChannels, format.channelCount());
+                info.insert(TransferProtocol::kKeySampleFormat, static_cast<int>(format.sampleFormat()));
+                header = TransferProtocol::MakeFrame(TransferProtocol::kFrameStreamBegin, TransferProtocol::kAudioStreamId, 0,
+                                                     TransferProtocol::EncodeMetadata(info));
+            } else {
+                const bool compressed = session->protocol_version >= 2 && compression_enabled_;
+                QDataStream stream(&header, QIODevice::WriteOnly);
+                stream.setVersion(QDataStream::Qt_6_0);
+                stream << kStreamHeaderMagic << kStreamVersion << static_cast<quint32>(format.sampleRate())
+                       << static_cast<quint16>(format.channelCount()) << static_cast<quint16>(format.sampleFormat())
+                       << (compressed ? kCodecZlib : kCodecNone);
+            }
+            if (!WriteToSession(session, header.constData(), header.size())) {
+                continue;
+            }
+            session->stream_started = true;
+            session->stream_sent_frames = 0;
+            session->stream_dropped_frames = 0;
+            session->stream_latency_sum_us = 0;
+            session->stream_latency_max_us = 0;
+        }
+        // 压缩只做一次，所有需要压缩的客户端共用
+        if (session->protocol_version >= 2 && compression_enabled_ && frame.compressed.isNull()) {
+            frame.compressed = qCompress(reinterpret_cast<const uchar *>(block.data()), block.size(), 1);
+            // 压缩后没有变小时置为空（非null），表示已尝试过，按原样发送
+            if (frame.compressed.size() >= block.size()) {
+                frame.compressed = QByteArray("");
+            }
+        }
+        session->stream_queue.append(frame);
+        session->stream_queued_bytes += block.size();
+        // 队列超出上限时丢弃最旧的数据，保证延迟有界
+        while (session->stream_queued_bytes > max_bytes && session->stream_queue.size() > 1) {
+            session->stream_queued_bytes -= session->stream_queue.first().block.size();
+            session->stream_queue.removeFirst();
+            ++session->stream_dropped_frames;
+        }
+        FlushStream(session);
+    }
+}
+
+void NetworkModel::FlushStream(ClientSession *session)
+{
+    const bool compressed = session->protocol_version >= 2 && compression_enabled_;
+    // 分帧客户端传输文件时，音频帧只要排队数据低于高水位就写入，延迟不超过高水位对应的发送时间；
+    // 否则套接字中排队的音频也不超过kStreamMaxLatency
+    const qint64 limit = session->framed && session->state == kTransferring
+        ? session->effective_high_watermark
+        : qMin(kStreamSocketLimit, qMax<qint64>(stream_format_.bytesForDuration(kStreamMaxLatency), 1));
+    while (!session->stream_queue.isEmpty() && session->socket->bytesToWrite() < limit) {
+        const StreamFrame frame = session->stream_queue.takeFirst();
+        session->stream_queued_bytes -= frame.block.size();
+        const bool use_compressed = compressed && !frame.compressed.isEmpty();
+        const qint64 size = use_compressed ? frame.compressed.size() : frame.block.size();
+        const char *data = use_compressed ? frame.compressed.constData() : frame.block.data();
+        if (session->framed) {
+            uchar timestamp[8];
+            qToBigEndian(frame.block.timestamp_us(), timestamp);
+            if (!WriteFrameHeader(session, TransferProtocol::kFrameStreamData, TransferProtocol::kAudioStreamId,
+                                  static_cast<quint32>(frame.block.sequence()), 8 + size,
+                                  use_compressed ? TransferProtocol::kFlagCompressed : 0)
+                || !WriteToSession(session, timestamp, 8) || !WriteToSession(session, data, size)) {
+                return;
+            }
+        } else {
+            uchar header[kStreamFrameHeaderSize];
+            qToBigEndian(kStreamFrameMagic, header);
+            qToBigEndian(static_cast<quint32>(size) | (use_compressed ? kCompressedFlag : 0u), header + 4);
+            qToBigEndian(frame.block.sequence(), header + 8);
+            qToBigEndian(frame.block.timestamp_us(), header + 16);
+            if (!WriteToSession(session, header, kStreamFrameHeaderSize) || !WriteToSession(session, data, size)) {
+                return;
+            }
+        }
+        ++session->stream_sent_frames;
+        // 块首样本在读出前一个块时长时采集
+        const qint64 latency_us = (AudioBlockRef::ClockNs() - frame.block.captured_ns()) / 1000
+            + stream_format_.durationForBytes(frame.block.size());
+        session->stream_latency_sum_us += latency_us;
+        session->stream_latency_max_us = qMax(session->stream_latency_max_us, latency_us);
+    }
+}
+
+void NetworkModel::EndSessionStream(ClientSession *session)
+{
+    if (!session->stream_started) {
+        return;
     }
+    session->stream_started = false;
+    if (session->socket->state() != QTcpSocket::ConnectedState) {
+        session->stream_queue.clear();
+        session->stream_queued_bytes = 0;
+        return;
+    }
+    // 丢弃未发送的数据，发送长度为0的结束帧
+    session->stream_dropped_frames += session->stream_queue.size();
+    session->stream_queue.clear();
+    session->stream_queued_bytes = 0;
+    if (session->framed) {
+        WriteFrameHeader(session, TransferProtocol::kFrameStreamEnd, TransferProtocol::kAudioStreamId,
+                         static_cast<quint32>(stream_last_sequence_), 0);
+    } else {
+        uchar header[kStreamFrameHeaderSize];
+        qToBigEndian(kStreamFrameMagic, header);
+        qToBigEndian(quint32{ 0 }, header + 4);
+        qToBigEndian(stream_last_sequence_, header + 8);
+        qToBigEndian(qint64{ 0 }, header + 16);
+        WriteToSession(session, header, kStreamFrameHeaderSize);
+    }
+    const qint64 average_latency_us = session->stream_sent_frames > 0 ? session->stream_latency_sum_us / session->stream_sent_frames : 0;
+    emit streamEnded(session->client_info, session->stream_sent_frames, session->stream_dropped_frames,
+                     average_latency_us, session->stream_latency_max_us);
+}
+
+void NetworkModel::EndStream()
+{
+    for (auto *session : std::as_const(sessions_)) {
+        EndSessionStream(session);
+    }
+    stream_format_ = QAudioFormat();
+}
+
+void NetworkModel::MarkProgress()
+{
+    progress_dirty_ = true;
+}
+
+void NetworkModel::EmitProgressSnapshot()
+{
+    progress_dirty_ = false;
+    TransferSnapshot snapshot;
+    for (const auto *session : std::as_const(sessions_)) {
+        if (session->state != kIdle) {
+            snapshot.bytes_sent += session->file_bytes_written;
+            snapshot.total_bytes += session->total_bytes;
+        }
+        if (session->state == kTransferring) {
+            ++snapshot.active_clients;
+            snapshot.throughput += session->throughput;
+        }
+    }
+    if (snapshot.total_bytes > 0) {
+        emit transferProgress(snapshot);
+    }
+}
+
+void NetworkModel::ReleaseTransferFile()
+{
+    // 等待仍在读取文件内容的压缩任务结束
+    for (auto &future : compressed_blocks_) {
+        future.waitForFinished();
+    }
+    compressed_blocks_.clear();
     if (transfer_file_) {
         transfer_file_->close();
         delete transfer_file_;
         transfer_file_ = nullptr;
     }
-    // 重置传输状态
+    file_data_ = nullptr;
+    file_buffer_.clear();
+    if (transfer_source_) {
+        transfer_source_->Close();
+        transfer_source_.reset();
+    }
     total_bytes_ = 0;
-    bytes_written_ = 0;
-    header_size_ = 0;
-    file_bytes_written_ = 0;
+    for (auto &file : batch_files_) {
+        UnloadBatchFile(file);
+    }
+    batch_files_.clear();
+    batch_released_ = 0;
+    batch_total_bytes_ = 0;
+}
 
-    socket_ = nullptr;
+void NetworkModel::SlotSocketDisconnected()
+{
+    auto *socket = qobject_cast<QTcpSocket *>(sender());
+    ClientSession *session = sessions_.value(socket);
+    if (!session) {
+        return;
+    }
+    StopZeroCopy(session);
+    emit connectionClosed(session->client_info);
+    FinishSession(session, kTransferError, "客户端连接断开");
+    for (const quint16 stream_id : session->uploads.keys()) {
+        FinishUpload(session, stream_id, "客户端连接断开");
+    }
+    sessions_.remove(socket);
+    client_count_ = sessions_.size();
+    delete session;
+    socket->deleteLater();
 }
 
 void NetworkModel::SlotBytesWritten(qint64 bytes)
 {
-    if (transfer_state_ != kTransferring) {
+    ClientSession *session = sessions_.value(qobject_cast<QTcpSocket *>(sender()));
+    if (!session) {
+        return;
+    }
+    session->bytes_written += bytes;
+    if (session->state != kTransferring) {
+        FlushStream(session);
+        return;
+    }
+    const qint64 data_start = session->transfer_base + session->header_size;
+    // 零拷贝模式下Qt只写出文件头，写完后转入sendfile发送
+    if (session->zero_copy) {
+        if (!session->send_notifier && session->bytes_written >= data_start) {
+            StartZeroCopy(session);
+        }
         return;
     }
-    bytes_written_ += bytes;
     // 如果还在发送头部数据，不更新文件传输进度
-    if (bytes_written_ <= header_size_) {
+    if (session->bytes_written < data_start) {
         return;
     }
-    // 计算实际的文件数据传输字节数
-    file_bytes_written_ = bytes_written_ - header_size_;
-    // 确保不超过文件大小
-    if (file_bytes_written_ > total_bytes_) {
-        file_bytes_written_ = total_bytes_;
+    // 计算实际的文件数据传输字节数（扣除校验值），确保不超过文件大小；压缩和分帧时按已写出的块计算
+    if (session->compressed || session->framed) {
+        while (!session->block_marks.isEmpty() && session->block_marks.first().first <= session->bytes_written) {
+            session->file_bytes_written = session->block_marks.takeFirst().second;
+        }
+    } else {
+        session->file_bytes_written = WireToFileOffset(session, session->bytes_written - data_start);
     }
-    emit transferProgress(file_bytes_written_, total_bytes_);
+    MarkProgress();
     // 检查文件是否传输完成
-    if (file_bytes_written_ == total_bytes_) {
-        // 文件传输完成
-        transfer_state_ = kTransferCompleted;
-        if (transfer_file_) {
-            transfer_file_->close();
-            delete transfer_file_;
-            transfer_file_ = nullptr;
-        }
-        emit transferCompleted();
+    if (session->all_queued && session->bytes_written >= session->transfer_end) {
+        FinishSession(session, kTransferCompleted);
         return; // 传输完成，不再发送下一块
     }
-    // 继续发送下一块
-    if (file_bytes_written_ < total_bytes_) {
-        SendNextChunk();
-    }
-}
-
-void NetworkModel::set_preview_file(const QString &file_path)
-{
-    preview_file_.clear();
-    QFile file(file_path);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        preview_file_ = QString("无法打开文件: %1").arg(file.errorString());
-        return;
+    // 排队数据降到低水位时补充
+    UpdateThroughput(session, bytes);
+    if (session->framed) {
+        FlushStream(session);
+        if (session->socket->bytesToWrite() <= low_watermark_) {
+            FillFramedPipeline(session);
+        }
+    } else if (session->socket->bytesToWrite() <= low_watermark_) {
+        FillSendPipeline(session);
     }
-    QTextStream in(&file);
-    preview_file_ = in.readAll();
-    file.close();
 }
@@ -4,7 +4,31 @@
 #include <QTcpServer>
 #include <QTcpSocket>
 #include <QFile>
+#include <QSocketNotifier>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QFuture>
+#include <QTimer>
+#include <QAudioFormat>
+#include <atomic>
+#include <vector>
+#include "audioblockpool.h"
+#include "ingestwriter.h"
+#include "transferprotocol.h"
+#include "transfersource.h"
+#include "wavstreamwriter.h"
 
+// 传输进度快照，由网络线程按固定频率合并后发出
+struct TransferSnapshot {
+    qint64 bytes_sent{ 0 };         // 所有客户端合计
+    qint64 total_bytes{ 0 };
+    int active_clients{ 0 };
+    double throughput{ 0.0 };       // 字节/秒
+};
+Q_DECLARE_METATYPE(TransferSnapshot)
+
+// 网络模型可以移到独立的网络线程中运行：界面通过QMetaObject::invokeMethod调用，
+// 状态查询函数可在任意线程调用，进度以快照形式最多每kProgressInterval毫秒发出一次
 class NetworkModel  : public QObject
 {
     Q_OBJECT
@@ -28,6 +52,12 @@ public:
         kTransferError
     };
 
+    // 套接字参数配置：延迟优先关闭Nagle算法并使用小缓冲，吞吐优先使用大发送缓冲和高水位
+    enum SocketProfile_t {
+        kThroughputProfile,
+        kLatencyProfile
+    };
+
 public:
     NetworkModel(QObject *parent);
     ~NetworkModel();
@@ -36,34 +66,282 @@ public:
     PortError_t StartListening(const QString &port);
     void StopListening();
 
+    // 向所有已连接的客户端广播同一个文件
     void StartFileTransfer(const QString &file_path);
+    // 向所有已连接的客户端依次发送一批文件，metadata附加到每个文件的元数据中；
+    // 只有一个文件时所有客户端都可接收，多个文件只发送给使用分帧协议（版本3）的客户端
+    void StartBatchTransfer(const QStringList &file_paths, const QVariantMap &metadata = QVariantMap());
+    // 发送任意数据源（文件或内存中的模型数据），规则与StartBatchTransfer相同
+    void StartSourceTransfer(const QList<TransferSourcePtr> &sources, const QVariantMap &metadata = QVariantMap());
     TransferState_t get_transfer_state() const { return transfer_state_; }
+    int get_client_count() const { return client_count_; }
+
+    // 发送流水线设置
+    void set_socket_profile(SocketProfile_t profile);
+    SocketProfile_t get_socket_profile() const { return socket_profile_; }
+    // 套接字中排队字节数低于低水位时补充数据，直到达到高水位
+    // 排队字节数为QTcpSocket::bytesToWrite()，即Qt用户态写缓冲中的数据，不含内核发送缓冲（大小由发送策略设置）中的数据，
+    // 未确认的数据最多为高水位加内核发送缓冲。不按内核队列（SIOCOUTQ/TCP_INFO）判断：Qt缓冲写空后不再有bytesWritten回调，
+    // 若内核队列仍高于低水位，流水线将没有机会补充数据
+    void set_watermarks(qint64 low_watermark, qint64 high_watermark);
+    void set_zero_copy_enabled(bool enabled) { zero_copy_enabled_ = enabled; }
+    // 固定发送块大小（用于基准测试），0为按吞吐量自动调整
+    void set_fixed_chunk_size(qint64 chunk_size) { fixed_chunk_size_ = chunk_size > 0 ? qBound(kMinChunkSize, chunk_size, kMaxChunkSize) : 0; }
+    // 对支持压缩的客户端，按数据可压缩性和链路速度自动决定是否压缩
+    void set_compression_enabled(bool enabled) { compression_enabled_ = enabled; }
+
+    // 实时音频流：录音时把采集到的数据块转发给未在传输文件的客户端
+    void set_streaming_enabled(bool enabled);
+    // 录音结束时调用，向各客户端发送结束帧
+    void EndStream();
+
+    // 接收上传：分帧协议的客户端可在同一连接上向服务器发送文件（FileBegin/FileData/FileEnd帧）
+    // 和实时音频流（StreamBegin/StreamData/StreamEnd帧），保存到ingest_dir；开启播放时音频边接收边转发
+    void set_ingest_enabled(bool enabled) { ingest_enabled_ = enabled; }
+    void set_ingest_dir(const QString &dir) { ingest_dir_ = dir; }
+    const QString &get_ingest_dir() const { return ingest_dir_; }
+    void set_ingest_playback_enabled(bool enabled);
+
+    static constexpr qint64 kZeroCopyChunk{ 4 * 1024 * 1024 };  // 每次sendfile的最大字节数
+    static constexpr qint64 kMinChunkSize{ 16 * 1024 };
+    static constexpr qint64 kMaxChunkSize{ 1024 * 1024 };
+    static constexpr qint64 kDefaultChunkSize{ 64 * 1024 };
+    static constexpr int kRateWindow{ 100 };            // 吞吐量统计周期（毫秒）
+    static constexpr int kChunkInterval{ 5 };           // 每块数据大致对应的发送时间（毫秒）
+    static constexpr int kProgressInterval{ 100 };      // 进度快照的最小间隔（毫秒）
+    // 校验扩展：客户端连接后先发送请求（魔数、版本、文件标识、续传偏移，共24字节），
+    // 服务器在文件头后追加扩展头（魔数、校验块大小、文件标识、起始偏移），
+    // 之后每个校验块后跟该块的CRC32C，最后是所有块CRC32C的CRC32C（整文件摘要）
+    static constexpr quint32 kResumeRequestMagic{ 0x53545251 };     // "STRQ"
+    static constexpr quint32 kExtensionMagic{ 0x53545831 };         // "STX1"
+    // 版本2的客户端可解压：扩展头后追加编码方式，压缩时每个校验块前有4字节长度（最高位表示已压缩，
+    // 内容为qCompress格式），块后的CRC32C仍按原始数据计算
+    // 版本3的客户端使用分帧协议（见TransferProtocol），文件和音频流都以帧发送
+    static constexpr quint32 kMinProtocolVersion{ 1 };
+    static constexpr quint32 kProtocolVersion{ TransferProtocol::kVersion };
+    static constexpr quint32 kCodecNone{ 0 };
+    static constexpr quint32 kCodecZlib{ 1 };
+    static constexpr quint32 kCompressedFlag{ 0x80000000 };
+    static constexpr int kCompressAhead{ 8 };                       // 提前压缩的校验块数
+    static constexpr qint64 kCompressionSample{ 16 * 1024 };        // 每个采样片段的长度
+    static constexpr double kAssumedLinkSpeed{ 100.0 * 1024 * 1024 };  // 未测得链路速度时的假设值（字节/秒）
+    // 实时音频流：先发送流头（魔数、版本、采样率、声道数、样本格式、编码方式，共20字节），
+    // 之后每个数据块一帧，帧头固定24字节（魔数、数据长度、序号、时间戳），数据长度为0表示流结束；
+    // 版本2的客户端可收到qCompress压缩的帧（数据长度最高位为1）
+    static constexpr quint32 kStreamHeaderMagic{ 0x53544155 };      // "STAU"
+    static constexpr quint32 kStreamFrameMagic{ 0x53544146 };       // "STAF"
+    static constexpr quint32 kStreamVersion{ 1 };
+    static constexpr int kStreamFrameHeaderSize{ 24 };
+    static constexpr qint64 kStreamSocketLimit{ 8 * 1024 };         // 套接字中排队超过此值时暂存到队列
+    static constexpr qint64 kStreamMaxLatency{ 40000 };             // 每个客户端队列最多保存的音频时长（微秒），超出丢弃最旧的
+    static constexpr qint64 kResumeRequestSize{ 24 };
+    static constexpr qint64 kHashBlockSize{ 1024 * 1024 };
+    static constexpr qint64 kMaxIngestFrame{ 16 * 1024 * 1024 };    // 上传帧的最大数据长度，超出视为数据错误
+    static constexpr qint64 kWavHeadLimit{ 64 * 1024 };             // 上传的WAV文件在此长度内找不到data块时不实时播放
 
-    void set_preview_file(const QString &file_path);
-    const QString &get_preview_file() const { return preview_file_; }
+public slots:
+    // 在网络线程中转发采集的数据块（来自AudioModel的流通道）
+    void SlotStreamAudioBlock(const AudioBlockRef &block, const QAudioFormat &format);
 
 private:
+    // 排队等待发送的音频帧，数据块和压缩结果在所有客户端之间共享
+    struct StreamFrame {
+        AudioBlockRef block;
+        QByteArray compressed;
+    };
+
+    // 上传的WAV文件中样本数据位置的特殊值
+    static constexpr qint64 kAudioUnknown{ -1 };        // 尚未解析出data块
+    static constexpr qint64 kNotAudio{ -2 };            // 不是可播放的音频
+    // 客户端上传中的一个文件或音频流
+    struct IngestUpload {
+        QString name;
+        bool is_stream{ false };
+        bool is_wav{ false };
+        qint64 expected_size{ -1 };         // 文件大小，-1为未知
+        qint64 received{ 0 };
+        quint32 crc{ 0 };
+        IngestWriter file_writer;
+        WavStreamWriter stream_writer;      // 音频流保存为WAV
+        QAudioFormat format;                // 可播放的音频格式，无效表示不播放
+        QByteArray wav_head;                // WAV文件的开头，找到data块之前暂存
+        qint64 audio_offset{ kAudioUnknown };   // WAV文件中样本数据的位置
+    };
+    // 每个客户端独立的发送进度和背压状态，慢速客户端不会拖慢其他客户端
+    struct ClientSession {
+        ~ClientSession() { qDeleteAll(uploads); }
+
+        QTcpSocket *socket{ nullptr };
+        QString client_info;
+        TransferState_t state{ kIdle };
+        bool verified{ false };             // 客户端请求了校验扩展
+        bool framed{ false };               // 客户端使用分帧协议
+        quint32 protocol_version{ 0 };
+        bool compressed{ false };
+        bool all_queued{ false };           // 全部数据（含校验值）已交给套接字
+        QList<QPair<qint64, qint64>> block_marks;  // 压缩或分帧时已排队数据的(写出位置, 文件位置)
+        QByteArray request;                 // 未收全的客户端请求
+        qint64 start_offset{ 0 };           // 续传起始位置（校验块边界）
+        qint64 header_size{ 0 };
+        // 写入套接字和已写出的字节数从连接开始累计（含音频流），transfer_base为本次传输开始时的写入位置
+        qint64 bytes_queued{ 0 };
+        qint64 bytes_written{ 0 };
+        qint64 transfer_base{ 0 };
+        qint64 transfer_end{ 0 };           // 全部数据排队后的写入位置，之后可能还有音频帧
+        qint64 total_bytes{ 0 };            // 本次传输的文件字节数（批量传输为各文件之和）
+        qint64 file_bytes_queued{ 0 };      // 已交给套接字的文件字节数
+        qint64 file_bytes_written{ 0 };
+        // 分帧协议的批量传输
+        int batch_index{ 0 };
+        qint64 batch_offset{ 0 };           // 当前文件内的位置
+        bool file_begun{ false };
+        quint32 frame_sequence{ 0 };
+        bool zero_copy{ false };
+        QSocketNotifier *send_notifier{ nullptr };
+        qint64 effective_high_watermark{ 0 };
+        qint64 chunk_size{ kDefaultChunkSize };
+        QElapsedTimer rate_timer;
+        qint64 rate_window_bytes{ 0 };
+        double throughput{ 0.0 };           // 字节/秒
+        qint64 rtt_us{ 0 };
+        // 实时音频流
+        bool stream_started{ false };       // 已发送流头
+        QList<StreamFrame> stream_queue;
+        qint64 stream_queued_bytes{ 0 };
+        qint64 stream_sent_frames{ 0 };
+        // 采集到写入套接字的延迟统计（微秒）
+        qint64 stream_latency_sum_us{ 0 };
+        qint64 stream_latency_max_us{ 0 };
+        qint64 stream_dropped_frames{ 0 };
+        // 客户端上传，按流编号区分
+        QByteArray ingest_buffer;           // 未收全的上传帧
+        QHash<quint16, IngestUpload *> uploads;
+    };
+
     QTcpServer *server_{ nullptr };
-    QTcpSocket *socket_{ nullptr };
+    QHash<QTcpSocket *, ClientSession *> sessions_;
+    std::atomic<PortState_t> port_state_{ kNotListening };
+    std::atomic<TransferState_t> transfer_state_{ kIdle };
+    std::atomic<int> client_count_{ 0 };
+    // 进度变化只做标记，由定时器合并发出
+    QTimer *progress_timer_{ nullptr };
+    bool progress_dirty_{ false };
+    // 广播的文件只映射一次，各客户端从同一块内存按各自进度取数据
     QFile *transfer_file_{ nullptr };
-    PortState_t port_state_{ kNotListening };
-    TransferState_t transfer_state_{ kIdle };
+    QString transfer_file_path_;            // 最近传输的文件，断线重连的客户端可续传
+    quint64 file_id_{ 0 };                  // 由路径、大小、修改时间得到，续传时确认文件未变化
+    const uchar *file_data_{ nullptr };
+    QByteArray file_buffer_;                // 无法映射时一次性读入
+    // 旧版客户端接收内存数据源（编码数据、调制信号）时按需从数据源读取，不整体序列化
+    TransferSourcePtr transfer_source_;
     qint64 total_bytes_{ 0 };
-    qint64 bytes_written_{ 0 };
-    qint64 header_size_{ 0 };
-    qint64 file_bytes_written_{ 0 };
-    QString preview_file_;
+    QByteArray header_;
+    // 批量传输的数据源按顺序打开一次，所有分帧客户端都发送过后关闭
+    struct BatchFile {
+        TransferSourcePtr source;
+        QVariantMap metadata;
+        qint64 size{ 0 };
+        bool loaded{ false };
+        // 整文件CRC32C由最先发送到的客户端逐段计算，所有客户端共用
+        quint32 crc{ 0 };
+        qint64 crc_bytes{ 0 };              // 已计入crc的字节数
+    };
+    QList<BatchFile> batch_files_;
+    int batch_released_{ 0 };               // 此前的文件已释放
+    qint64 batch_total_bytes_{ 0 };
+    // 各校验块的CRC32C，发送时按需计算，所有客户端共用
+    std::vector<quint32> block_crcs_;
+    std::vector<char> block_crc_ready_;
+    // 压缩在线程池中进行，提前于套接字发送；压缩结果按校验块缓存，所有客户端共用
+    bool compression_enabled_{ true };
+    int compression_level_{ -1 };           // 本次传输选定的zlib级别，0为不压缩，-1为尚未选择
+    QHash<qint64, QFuture<QByteArray>> compressed_blocks_;
+    double link_throughput_{ 0.0 };         // 最近测得的单个客户端发送速率
+    bool streaming_enabled_{ false };
+    QAudioFormat stream_format_;
+    quint64 stream_last_sequence_{ 0 };
+    int completed_clients_{ 0 };
+    // 零拷贝发送（Linux sendfile）：文件头由Qt写出后，文件内容由内核直接从页缓存发送到套接字
+    bool zero_copy_enabled_{ true };
+    // 发送流水线：水位（Qt写缓冲中的字节数）、块大小按实测吞吐量和RTT调整
+    SocketProfile_t socket_profile_{ kThroughputProfile };
+    qint64 low_watermark_{ 0 };
+    qint64 high_watermark_{ 0 };
+    qint64 fixed_chunk_size_{ 0 };
+    // 上传
+    bool ingest_enabled_{ false };
+    QString ingest_dir_;
+    bool ingest_playback_enabled_{ false };
+    const IngestUpload *playback_upload_{ nullptr };    // 同一时间只播放一个上传的音频
 
-    void SendNextChunk();
+    bool OpenTransferFile(const QString &file_path);
+    bool OpenTransferSource(const TransferSourcePtr &source);
+    // 广播数据的一段：映射文件不复制，内存数据源按需读取（在下一次读取之前有效）；读取失败时返回的数据不足length
+    QByteArray TransferData(qint64 offset, qint64 length) const;
+    void PrepareTransferData(const QString &file_name);
+    void StartSession(ClientSession *session, qint64 offset);
+    bool WriteToSession(ClientSession *session, const void *data, qint64 size);
+    void HandleClientRequest(ClientSession *session);
+    quint32 BlockCrc(qint64 block);
+    quint32 FileDigest();
+    qint64 WireToFileOffset(const ClientSession *session, qint64 wire_bytes) const;
+    int ChooseCompressionLevel() const;
+    void RequestCompressedBlocks(qint64 first_block);
+    void TrimCompressedBlocks();
+    void ResumeCompressedSessions();
+    bool QueueCompressedBlock(ClientSession *session);
+    void FillSendPipeline(ClientSession *session);
+    void ResetSessionTransfer(ClientSession *session);
+    void StartFramedSession(ClientSession *session);
+    void FillFramedPipeline(ClientSession *session);
+    bool WriteFrameHeader(ClientSession *session, TransferProtocol::FrameType_t type, quint16 stream_id, quint32 sequence,
+                          qint64 length, quint8 flags = 0);
+    bool LoadBatchFile(BatchFile &file);
+    void UnloadBatchFile(BatchFile &file);
+    void ReleasePassedBatchFiles();
+    void ApplySocketProfile(QTcpSocket *socket);
+    void UpdateThroughput(ClientSession *session, qint64 bytes);
+    void StartZeroCopy(ClientSession *session);
+    void StopZeroCopy(ClientSession *session);
+    void SendZeroCopy(ClientSession *session);
+    void FinishSession(ClientSession *session, TransferState_t state, const QString &error_message = QString());
+    void FlushStream(ClientSession *session);
+    void EndSessionStream(ClientSession *session);
+    void ParseIngestFrames(ClientSession *session);
+    void HandleIngestFrame(ClientSession *session, const TransferProtocol::FrameHeader &header, const char *payload);
+    void BeginUpload(ClientSession *session, const TransferProtocol::FrameHeader &header, const QVariantMap &metadata);
+    void FinishUpload(ClientSession *session, quint16 stream_id, const QString &error_message = QString());
+    void ForwardIngestAudio(IngestUpload *upload, const char *data, qint64 size);
+    QString IngestFilePath(const QString &name) const;
+    void MarkProgress();
+    void EmitProgressSnapshot();
+    void ReleaseTransferFile();
 
 private slots:
     void SlotNewConnection();
     void SlotSocketDisconnected();
     void SlotBytesWritten(qint64 bytes);
+    void SlotReadyRead();
 
 signals:
     void connectionEstablished(const QString &client_info);
-    void transferProgress(qint64 bytes_sent, qint64 total_bytes);
+    void connectionClosed(const QString &client_info);
+    // 所有客户端合计的进度
+    void transferProgress(const TransferSnapshot &snapshot);
     void transferCompleted();
     void transferError(const QString &error_message);
+    // 单个客户端的传输结果
+    void clientTransferCompleted(const QString &client_info);
+    void clientTransferError(const QString &client_info, const QString &error_message);
+    void clientResumed(const QString &client_info, qint64 offset);
+    // 延迟为块首样本采集到数据块交给套接字的时间（微秒），不含声卡缓冲和网络传输
+    void streamEnded(const QString &client_info, qint64 sent_frames, qint64 dropped_frames, qint64 average_latency_us, qint64 max_latency_us);
+    // 客户端上传
+    void ingestStarted(const QString &client_info, const QString &name, qint64 size);
+    void ingestCompleted(const QString &client_info, const QString &file_path, qint64 bytes);
+    void ingestError(const QString &client_info, const QString &error_message);
+    // 上传的音频数据，开启播放时边接收边发出
+    void ingestAudioData(const QByteArray &data, const QAudioFormat &format);
+    // 上传的音频已完整保存，data_offset为样本数据在文件中的位置
+    void ingestAudioFileReady(const QString &file_path, qint64 data_offset, const QAudioFormat &format);
 };
@@ -0,0 +1,181 @@
+﻿#include "peakfile.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+constexpr char kPeakMagic[4]{ 'S', 'T', 'P', 'K' };
+constexpr int kPeakVersion{ 1 };
+
+inline qint16 ToPeakValue(float v)
+{
+    return static_cast<qint16>(qBound(-32768.0f, v * 32767.0f, 32767.0f));
+}
+
+}
+
+std::shared_ptr<PeakFile> PeakFile::Build(const QString &wav_path)
+{
+    const QFileInfo file_info(wav_path);
+    const qint64 file_size = file_info.size();
+    const qint64 modified_ms = file_info.lastModified().toMSecsSinceEpoch();
+    const auto cache_path = CachePath(wav_path);
+    std::shared_ptr<PeakFile> peaks(new PeakFile);
+    if (peaks->Load(cache_path, file_size, modified_ms)) {
+        return peaks;
+    }
+    QFile file(wav_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+    const uchar *mapped = file.map(0, file.size());
+    WavInfo info;
+    if (!mapped || !ParseWavHeader(mapped, file.size(), info) || !peaks->Compute(mapped, info)) {
+        return nullptr;
+    }
+    // 缓存写入失败不影响本次显示
+    peaks->Save(cache_path, file_size, modified_ms);
+    return peaks;
+}
+
+qint64 PeakFile::get_frames_per_peak(int level) const
+{
+    qint64 frames = kBaseFramesPerPeak;
+    for (int i = 0; i < level; ++i) {
+        frames *= kLevelFactor;
+    }
+    return frames;
+}
+
+int PeakFile::LevelForResolution(double frames_per_pixel) const
+{
+    int level{ 0 };
+    while (level + 1 < levels_.size() && get_frames_per_peak(level + 1) <= frames_per_pixel) {
+        ++level;
+    }
+    return level;
+}
+
+QString PeakFile::CachePath(const QString &wav_path)
+{
+    // 优先放在音频文件旁边，目录不可写时放到缓存目录
+    const QFileInfo file_info(wav_path);
+    if (QFileInfo(file_info.absolutePath()).isWritable()) {
+        return wav_path + ".stpk";
+    }
+    const QDir cache_dir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    cache_dir.mkpath(".");
+    const auto hash = QCryptographicHash::hash(file_info.absoluteFilePath().toUtf8(), QCryptographicHash::Sha1).toHex();
+    return cache_dir.filePath(QString::fromLatin1(hash) + ".stpk");
+}
+
+bool PeakFile::Compute(const uchar *data, const WavInfo &info)
+{
+    frame_count_ = info.get_frame_count();
+    sample_rate_ = info.sample_rate;
+    const qint64 peak_count = (frame_count_ + kBaseFramesPerPeak - 1) / kBaseFramesPerPeak;
+    if (peak_count <= 0) {
+        return false;
+    }
+    QList<Peak> base(peak_count);
+    const uchar *audio = data + info.data_offset;
+    const int sample_bytes = info.bits_per_sample / 8;
+    // 按峰值区间分段，各段在线程池中并行计算，页面按需从映射中读入
+    QList<qint64> task_starts;
+    for (qint64 start = 0; start < peak_count; start += kPeaksPerTask) {
+        task_starts.append(start);
+    }
+    QtConcurrent::blockingMap(task_starts, [&](qint64 first_peak) {
+        const qint64 last_peak = qMin(peak_count, first_peak + kPeaksPerTask);
+        for (qint64 p = first_peak; p < last_peak; ++p) {
+            const qint64 first_frame = p * kBaseFramesPerPeak;
+            const qint64 last_frame = qMin(frame_count_, first_frame + kBaseFramesPerPeak);
+            float min_value{ 1.0f }, max_value{ -1.0f };
+            const uchar *sample = audio + first_frame * info.block_align;
+            const qint64 samples = (last_frame - first_frame) * info.channels;
+            for (qint64 i = 0; i < samples; ++i, sample += sample_bytes) {
+                const float v = LoadNormalizedSample(sample, info);
+                min_value = qMin(min_value, v);
+                max_value = qMax(max_value, v);
+            }
+            base[p] = { ToPeakValue(min_value), ToPeakValue(max_value) };
+        }
+    });
+    levels_.clear();
+    levels_.append(base);
+    BuildUpperLevels();
+    return true;
+}
+
+void PeakFile::BuildUpperLevels()
+{
+    while (levels_.last().size() > kMinPeaks) {
+        const auto &lower = levels_.last();
+        QList<Peak> upper((lower.size() + kLevelFactor - 1) / kLevelFactor);
+        for (qsizetype i = 0; i < upper.size(); ++i) {
+            Peak peak{ lower[i * kLevelFactor] };
+            for (qsizetype j = i * kLevelFactor + 1; j < qMin(lower.size(), (i + 1) * kLevelFactor); ++j) {
+                peak.min = qMin(peak.min, lower[j].min);
+                peak.max = qMax(peak.max, lower[j].max);
+            }
+            upper[i] = peak;
+        }
+        levels_.append(upper);
+    }
+}
+
+bool PeakFile::Load(const QString &cache_path, qint64 file_size, qint64 modified_ms)
+{
+    QFile file(cache_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    // 缓存只保存第0级，其余各级加载后重新合并
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    char magic[4];
+    qint32 version{ 0 }, base_frames{ 0 }, sample_rate{ 0 };
+    qint64 cached_size{ 0 }, cached_modified{ 0 }, frame_count{ 0 }, peak_count{ 0 };
+    if (stream.readRawData(magic, 4) != 4 || memcmp(magic, kPeakMagic, 4) != 0) {
+        return false;
+    }
+    stream >> version >> cached_size >> cached_modified >> base_frames >> sample_rate >> frame_count >> peak_count;
+    if (stream.status() != QDataStream::Ok || version != kPeakVersion || cached_size != file_size || cached_modified != modified_ms
+        || base_frames != kBaseFramesPerPeak || peak_count != (frame_count + kBaseFramesPerPeak - 1) / kBaseFramesPerPeak || peak_count <= 0) {
+        return false;
+    }
+    QList<Peak> base(peak_count);
+    const qint64 bytes = peak_count * static_cast<qint64>(sizeof(Peak));
+    if (stream.readRawData(reinterpret_cast<char *>(base.data()), bytes) != bytes) {
+        return false;
+    }
+    frame_count_ = frame_count;
+    sample_rate_ = sample_rate;
+    levels_.clear();
+    levels_.append(base);
+    BuildUpperLevels();
+    return true;
+}
+
+bool PeakFile::Save(const QString &cache_path, qint64 file_size, qint64 modified_ms) const
+{
+    QFile file(cache_path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    const auto &base = levels_.first();
+    stream.writeRawData(kPeakMagic, 4);
+    stream << qint32(kPeakVersion) << file_size << modified_ms << qint32(kBaseFramesPerPeak) << qint32(sample_rate_)
+           << frame_count_ << qint64(base.size());
+    stream.writeRawData(reinterpret_cast<const char *>(base.constData()), base.size() * static_cast<qint64>(sizeof(Peak)));
+    return stream.status() == QDataStream::Ok;
+}
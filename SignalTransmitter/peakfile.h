@@ -0,0 +1,47 @@
+﻿#pragma once
+
+#include <QString>
+#include <QList>
+#include <memory>
+#include "wavfile.h"
+
+// WAV文件的多分辨率峰值摘要
+// 第0级每kBaseFramesPerPeak帧一个最小/最大值对（多声道合并），之后每级合并kLevelFactor个；
+// 第0级在映射的数据上分段并行计算，结果缓存在文件旁的.stpk文件中，以文件大小和修改时间校验
+class PeakFile
+{
+public:
+    struct Peak {
+        qint16 min{ 0 };
+        qint16 max{ 0 };
+    };
+
+    // 读取缓存或计算峰值，可在后台线程调用；失败时返回空指针
+    static std::shared_ptr<PeakFile> Build(const QString &wav_path);
+
+    int get_level_count() const { return levels_.size(); }
+    const QList<Peak> &get_level(int level) const { return levels_[level]; }
+    qint64 get_frames_per_peak(int level) const;
+    qint64 get_frame_count() const { return frame_count_; }
+    int get_sample_rate() const { return sample_rate_; }
+    // 每个峰值覆盖帧数不超过frames_per_pixel的最粗一级
+    int LevelForResolution(double frames_per_pixel) const;
+
+    static constexpr int kBaseFramesPerPeak{ 256 };
+    static constexpr int kLevelFactor{ 4 };
+    static constexpr int kMinPeaks{ 512 };              // 最粗一级至少保留的峰值数
+    static constexpr qint64 kPeaksPerTask{ 4096 };      // 每个并行任务计算的峰值数
+
+private:
+    PeakFile() = default;
+    bool Compute(const uchar *data, const WavInfo &info);
+    bool Load(const QString &cache_path, qint64 file_size, qint64 modified_ms);
+    bool Save(const QString &cache_path, qint64 file_size, qint64 modified_ms) const;
+    void BuildUpperLevels();
+    static QString CachePath(const QString &wav_path);
+
+private:
+    QList<QList<Peak>> levels_;
+    qint64 frame_count_{ 0 };
+    int sample_rate_{ 0 };
+};
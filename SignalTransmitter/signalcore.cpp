@@ -0,0 +1,248 @@
+﻿#include "signalcore.h"
+#include "dspblocks.h"
+#include <QFile>
+#include <QTextStream>
+#include <QtMath>
+#include <cstring>
+
+namespace {
+
+// 一个比特周期内两种符号的波形模板：ASK为高/低电平，PSK为0/π相位
+void BuildPatterns(SignalCore::Modulation_t modulation, double *zero, double *one)
+{
+    const double ask_high{ 1.0 }, ask_low{ 0.0 };       // ASK高低电平
+    const double f = SignalCore::kCarrierFreq;
+    for (qsizetype n = 0; n < SignalCore::kSamplesPerBit; ++n) {
+        const double t = static_cast<double>(n) / SignalCore::kSampleRate;
+        if (modulation == SignalCore::kModulationAsk) {
+            one[n] = ask_high * sin(2 * M_PI * f * t);
+            zero[n] = ask_low * sin(2 * M_PI * f * t);
+        } else {
+            zero[n] = sin(2 * M_PI * f * t);
+            one[n] = sin(2 * M_PI * f * t + M_PI);
+        }
+    }
+}
+
+// 把stream交给count个消费者：没有消费者时丢弃，两个时经分流块复制
+template <typename T>
+std::vector<DspStream<T> *> FanOut(DspGraph &graph, DspStream<T> *stream, int count)
+{
+    if (count == 0) {
+        graph.AddBlock<NullSinkBlock<T>>(stream);
+        return {};
+    }
+    if (count == 1) {
+        return { stream };
+    }
+    auto *a = graph.AddStream<T>();
+    auto *b = graph.AddStream<T>();
+    graph.AddBlock<TeeBlock<T>>(stream, a, b);
+    return { a, b };
+}
+
+}
+
+SignalCore::Encoding_t SignalCore::EncodingFromName(const QString &name)
+{
+    if (name.compare("UTF-8", Qt::CaseInsensitive) == 0) {
+        return kEncodingUtf8;
+    }
+    if (name.compare("UTF-16", Qt::CaseInsensitive) == 0) {
+        return kEncodingUtf16;
+    }
+    return kEncodingUnknown;
+}
+
+SignalCore::Modulation_t SignalCore::ModulationFromName(const QString &name)
+{
+    if (name.compare("ASK", Qt::CaseInsensitive) == 0) {
+        return kModulationAsk;
+    }
+    if (name.compare("PSK", Qt::CaseInsensitive) == 0) {
+        return kModulationPsk;
+    }
+    return kModulationUnknown;
+}
+
+QByteArray SignalCore::EncodeText(QStringView text, Encoding_t encoding)
+{
+    switch (encoding) {
+    case kEncodingUtf8:
+        return text.toUtf8();
+    case kEncodingUtf16:
+        return QByteArray(reinterpret_cast<const char *>(text.utf16()), text.size() * 2);
+    default:
+        return QByteArray();
+    }
+}
+
+qsizetype SignalCore::EncodedSize(QStringView text, Encoding_t encoding)
+{
+    switch (encoding) {
+    case kEncodingUtf8: {
+        qsizetype size{ 0 };
+        for (qsizetype i = 0; i < text.size(); ++i) {
+            const char16_t c = text[i].unicode();
+            if (c < 0x80) {
+                size += 1;
+            } else if (c < 0x800) {
+                size += 2;
+            } else if (QChar::isHighSurrogate(c) && i + 1 < text.size() && text[i + 1].isLowSurrogate()) {
+                size += 4;
+                ++i;
+            } else if (QChar::isSurrogate(c)) {
+                // 不成对的代理项按toUtf8的替换规则计算
+                size += text.sliced(i, 1).toUtf8().size();
+            } else {
+                size += 3;
+            }
+        }
+        return size;
+    }
+    case kEncodingUtf16:
+        return text.size() * 2;
+    default:
+        return 0;
+    }
+}
+
+void SignalCore::ExpandBits(const char *data, qsizetype size, uint8_t *bits)
+{
+    for (qsizetype i = 0; i < size; ++i) {
+        const auto ubyte = static_cast<uint8_t>(static_cast<unsigned char>(data[i]));
+        for (auto b{ 7 }; b >= 0; --b) { // 高位在前
+            *bits++ = (ubyte >> b) & 0x01;
+        }
+    }
+}
+
+void SignalCore::Modulate(const uint8_t *bits, qsizetype count, Modulation_t modulation, double *samples)
+{
+    if (modulation == kModulationUnknown) {
+        return;
+    }
+    double zero[kSamplesPerBit];
+    double one[kSamplesPerBit];
+    BuildPatterns(modulation, zero, one);
+    // 对每个比特复制预计算的波形模板
+    for (qsizetype i = 0; i < count; ++i) {
+        memcpy(samples, bits[i] == 1 ? one : zero, sizeof(zero));
+        samples += kSamplesPerBit;
+    }
+}
+
+QList<uint8_t> SignalCore::Encode(const QString &text, Encoding_t encoding)
+{
+    const QByteArray encoded = EncodeText(text, encoding);
+    QList<uint8_t> bits(encoded.size() * 8);
+    ExpandBits(encoded.constData(), encoded.size(), bits.data());
+    return bits;
+}
+
+QList<double> SignalCore::Modulate(const QList<uint8_t> &bits, Modulation_t modulation)
+{
+    if (modulation == kModulationUnknown) {
+        return QList<double>();
+    }
+    QList<double> samples(bits.size() * kSamplesPerBit);
+    Modulate(bits.constData(), bits.size(), modulation, samples.data());
+    return samples;
+}
+
+bool SignalCore::ReadTextFile(const QString &file_name, QString &text, QString &error)
+{
+    QFile file(file_name);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        error = QString("Cannot open file: %1").arg(file.errorString());
+        return false;
+    }
+    QTextStream in(&file);
+    text = in.readAll();
+    return true;
+}
+
+bool SignalCore::WriteTextFile(const QString &file_name, const QString &text, QString &error)
+{
+    QFile file(file_name);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        error = QString("Cannot open file: %1").arg(file.errorString());
+        return false;
+    }
+    QTextStream out(&file);
+    out << text;
+    return true;
+}
+
+bool SignalCore::WriteEncodedFile(const QString &file_name, const QList<uint8_t> &bits, QString &error)
+{
+    QFile file(file_name);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        error = QString("Cannot open file: %1").arg(file.errorString());
+        return false;
+    }
+    QTextStream out(&file);
+    for (auto bit : bits) {
+        out << bit;
+    }
+    return true;
+}
+
+bool SignalCore::WriteModulatedFile(const QString &file_name, const QList<double> &samples, QString &error)
+{
+    QFile file(file_name);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        error = QString("Cannot open file: %1").arg(file.errorString());
+        return false;
+    }
+    QTextStream out(&file);
+    for (auto sample : samples) {
+        out << sample << " ";
+    }
+    return true;
+}
+
+SignalPipeline::SignalPipeline(SignalCore::Encoding_t encoding, SignalCore::Modulation_t modulation)
+    : encoding_(encoding)
+    , modulation_(modulation)
+{
+}
+
+bool SignalPipeline::Run(QIODevice &input, const Outputs &outputs, QThreadPool *pool)
+{
+    input_bytes_ = 0;
+    bit_count_ = 0;
+    error_.clear();
+    const bool write_encoded = !outputs.encoded_path.isEmpty();
+    const bool write_modulated = !outputs.modulated_path.isEmpty();
+    const bool write_wav = !outputs.wav_path.isEmpty();
+    const bool modulate = write_modulated || write_wav;
+
+    DspGraph graph;
+    auto *text = graph.AddStream<char16_t>();
+    auto *bits = graph.AddStream<uint8_t>();
+    auto *source = graph.AddBlock<TextDeviceSourceBlock>(&input, text);
+    auto *encoder = graph.AddBlock<EncoderBlock>(encoding_, text, bits);
+    const auto bit_streams = FanOut(graph, bits, int(write_encoded) + int(modulate));
+    if (write_encoded) {
+        graph.AddBlock<EncodedFileSinkBlock>(outputs.encoded_path, bit_streams.front());
+    }
+    if (modulate) {
+        auto *samples = graph.AddStream<double>();
+        graph.AddBlock<ModulatorBlock>(modulation_, bit_streams.back(), samples);
+        const auto sample_streams = FanOut(graph, samples, int(write_modulated) + int(write_wav));
+        if (write_modulated) {
+            graph.AddBlock<ModulatedFileSinkBlock>(outputs.modulated_path, sample_streams.front());
+        }
+        if (write_wav) {
+            graph.AddBlock<WavSinkBlock>(outputs.wav_path, static_cast<int>(SignalCore::kSampleRate), sample_streams.back());
+        }
+    }
+    const bool ok = graph.Run(pool ? pool : QThreadPool::globalInstance());
+    input_bytes_ = source->get_input_bytes();
+    bit_count_ = encoder->get_bit_count();
+    if (!ok) {
+        error_ = graph.get_error();
+    }
+    return ok;
+}
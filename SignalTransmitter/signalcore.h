@@ -0,0 +1,81 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QList>
+#include <QString>
+
+class QThreadPool;
+
+// 文本编码、调制和导出的核心逻辑，不依赖界面
+// TxtModel（界面）和SignalCli（命令行批量处理）共用；出错时返回false并给出错误信息，由调用者决定如何提示
+class SignalCore
+{
+public:
+    enum Encoding_t {
+        kEncodingUtf8,
+        kEncodingUtf16,
+        kEncodingUnknown
+    };
+
+    enum Modulation_t {
+        kModulationAsk,
+        kModulationPsk,
+        kModulationUnknown
+    };
+
+    // 名称与界面下拉框一致（UTF-8/UTF-16、ASK/PSK），不区分大小写
+    static Encoding_t EncodingFromName(const QString &name);
+    static Modulation_t ModulationFromName(const QString &name);
+
+    // 文本转换为字节流，UTF-16为本机字节序
+    static QByteArray EncodeText(QStringView text, Encoding_t encoding);
+    // 编码后的字节数，与EncodeText(text, encoding).size()相同，但不生成数据
+    static qsizetype EncodedSize(QStringView text, Encoding_t encoding);
+    // 按位展开（高位在前），每个位存为0或1，bits至少有size * 8个元素
+    static void ExpandBits(const char *data, qsizetype size, uint8_t *bits);
+    // 每个位生成kSamplesPerBit个样本，samples至少有count * kSamplesPerBit个元素
+    static void Modulate(const uint8_t *bits, qsizetype count, Modulation_t modulation, double *samples);
+
+    // 整段处理
+    static QList<uint8_t> Encode(const QString &text, Encoding_t encoding);
+    static QList<double> Modulate(const QList<uint8_t> &bits, Modulation_t modulation);
+
+    static bool ReadTextFile(const QString &file_name, QString &text, QString &error);
+    static bool WriteTextFile(const QString &file_name, const QString &text, QString &error);
+    // 编码文件每位一个'0'或'1'字符，调制文件为空格分隔的样本值
+    static bool WriteEncodedFile(const QString &file_name, const QList<uint8_t> &bits, QString &error);
+    static bool WriteModulatedFile(const QString &file_name, const QList<double> &samples, QString &error);
+
+    static constexpr double kSampleRate{ 1600.0 };
+    static constexpr qsizetype kSamplesPerBit{ 16 };
+    static constexpr double kCarrierFreq{ 200 };
+};
+
+// 流式处理一个输入：设备文本源 -> 编码 -> 调制 -> 文件汇，由DspGraph分段流水处理（与TxtModel使用相同的处理块），
+// 内存占用只与分段大小有关，与输入长度无关
+// 输出路径为空的项不生成；WAV为32位浮点单声道，与界面播放生成信号时的格式相同
+class SignalPipeline
+{
+public:
+    struct Outputs {
+        QString encoded_path;
+        QString modulated_path;
+        QString wav_path;
+    };
+
+    SignalPipeline(SignalCore::Encoding_t encoding, SignalCore::Modulation_t modulation);
+
+    // 读取input（文件或标准输入）直到结束，各级在pool（为空时为全局线程池）中运行；不要在pool的任务中调用
+    bool Run(QIODevice &input, const Outputs &outputs, QThreadPool *pool = nullptr);
+    const QString &get_error() const { return error_; }
+    qint64 get_input_bytes() const { return input_bytes_; }
+    qint64 get_bit_count() const { return bit_count_; }
+
+private:
+    SignalCore::Encoding_t encoding_;
+    SignalCore::Modulation_t modulation_;
+    qint64 input_bytes_{ 0 };
+    qint64 bit_count_{ 0 };
+    QString error_;
+};
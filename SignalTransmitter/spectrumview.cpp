@@ -0,0 +1,204 @@
+﻿#include "spectrumview.h"
+#include <QPainter>
+#include <QPainterPath>
+#include <QWheelEvent>
+#include <QtMath>
+
+SpectrumView::SpectrumView(QWidget *parent)
+    : QWidget(parent)
+    , fft_(kFftSize)
+    , current_spectrum_(fft_.get_bin_count(), kMinDb)
+    , spectrogram_(kHistoryColumns, fft_.get_bin_count(), QImage::Format_RGB32)
+{
+    InitColorTable();
+    spectrogram_.fill(color_table_.first());
+    pending_samples_.reserve(kFftSize * 4);
+    setMinimumSize(200, 150);
+}
+
+SpectrumView::~SpectrumView()
+{}
+
+void SpectrumView::InitColorTable()
+{
+    // 黑-蓝-红-黄-白渐变色表，按dB值线性映射
+    color_table_.resize(256);
+    for (int i = 0; i < 256; ++i) {
+        const double t = i / 255.0;
+        const int r = qBound(0, static_cast<int>(255 * qMin(1.0, t * 2.0)), 255);
+        const int g = qBound(0, static_cast<int>(255 * (t - 0.5) * 2.0), 255);
+        const int b = qBound(0, static_cast<int>(255 * (t < 0.5 ? t * 2.0 : (1.0 - t) * 2.0 + qMax(0.0, t - 0.85) * 6.0)), 255);
+        color_table_[i] = qRgb(r, g, b);
+    }
+}
+
+void SpectrumView::AppendAudioData(const QByteArray &audio_data, const QAudioFormat &format)
+{
+    if (audio_data.isEmpty() || format.sampleRate() <= 0 || format.channelCount() <= 0) {
+        return;
+    }
+    if (format.sampleRate() != sample_rate_) {
+        // 采样率变化时重新开始
+        ClearDisplay();
+        sample_rate_ = format.sampleRate();
+    }
+    // 转换为单声道浮点样本（多声道取平均）
+    const int channel_count = format.channelCount();
+    const int bytes_per_sample = format.bytesPerSample();
+    const int frame_size = bytes_per_sample * channel_count;
+    const qsizetype frame_count = audio_data.size() / frame_size;
+    const char *data = audio_data.constData();
+    const float channel_gain = 1.0f / channel_count;
+    for (qsizetype i = 0; i < frame_count; ++i) {
+        const char *frame = data + i * frame_size;
+        float sum{ 0.0f };
+        for (int ch = 0; ch < channel_count; ++ch) {
+            sum += format.normalizedSampleValue(frame + ch * bytes_per_sample);
+        }
+        pending_samples_.push_back(sum * channel_gain);
+    }
+    ProcessPendingFrames();
+    update();
+}
+
+void SpectrumView::AppendAudioBlock(const AudioBlockRef &block, const QAudioFormat &format)
+{
+    if (block.IsNull()) {
+        return;
+    }
+    // 共享数据块的只读视图，不复制样本
+    AppendAudioData(block.ToByteArray(), format);
+}
+
+void SpectrumView::ProcessPendingFrames()
+{
+    // 按帧移逐帧分析，相邻帧重叠 kFftSize - kHopSize 个样本
+    while (static_cast<qsizetype>(pending_samples_.size()) - pending_offset_ >= kFftSize) {
+        fft_.ComputePowerSpectrum(pending_samples_.data() + pending_offset_, current_spectrum_.data());
+        PushSpectrogramColumn(current_spectrum_.data());
+        pending_offset_ += kHopSize;
+    }
+    // 丢弃已经分析完毕的样本
+    if (pending_offset_ > 0) {
+        pending_samples_.erase(pending_samples_.begin(), pending_samples_.begin() + pending_offset_);
+        pending_offset_ = 0;
+    }
+}
+
+void SpectrumView::PushSpectrogramColumn(const float *power_db)
+{
+    const int bin_count = fft_.get_bin_count();
+    const float scale = 255.0f / (kMaxDb - kMinDb);
+    // 高频在上、低频在下
+    for (int k = 0; k < bin_count; ++k) {
+        const int index = qBound(0, static_cast<int>((power_db[k] - kMinDb) * scale), 255);
+        auto *line = reinterpret_cast<QRgb *>(spectrogram_.scanLine(bin_count - 1 - k));
+        line[write_column_] = color_table_[index];
+    }
+    write_column_ = (write_column_ + 1) % kHistoryColumns;
+    filled_columns_ = qMin(filled_columns_ + 1, kHistoryColumns);
+}
+
+void SpectrumView::ClearDisplay()
+{
+    pending_samples_.clear();
+    pending_offset_ = 0;
+    std::fill(current_spectrum_.begin(), current_spectrum_.end(), kMinDb);
+    spectrogram_.fill(color_table_.first());
+    write_column_ = 0;
+    filled_columns_ = 0;
+    update();
+}
+
+void SpectrumView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::white);
+    // 字体设置
+    QFont font = painter.font();
+    font.setBold(true);
+    painter.setFont(font);
+    const int title_height = painter.fontMetrics().height() + 4;
+    painter.drawText(QRect(0, 0, width(), title_height), Qt::AlignCenter, "Spectrum View");
+    // 上部为当前频谱曲线，下部为时频图
+    const int bin_count = fft_.get_bin_count();
+    const int display_bins = display_bins_;
+    const QRect spectrum_rect(40, title_height, width() - 50, (height() - title_height) * 2 / 5 - 4);
+    const QRect spectrogram_rect(40, spectrum_rect.bottom() + 8, width() - 50, height() - spectrum_rect.bottom() - 12);
+    if (spectrum_rect.width() <= 0 || spectrum_rect.height() <= 0 || spectrogram_rect.height() <= 0) {
+        return;
+    }
+    painter.setPen(Qt::gray);
+    painter.drawRect(spectrum_rect);
+    // 频谱曲线：每个像素列取对应频点范围内的最大值
+    QPainterPath path;
+    int peak_bin{ 0 };
+    for (int k = 1; k < display_bins; ++k) {
+        if (current_spectrum_[k] > current_spectrum_[peak_bin]) {
+            peak_bin = k;
+        }
+    }
+    for (int x = 0; x < spectrum_rect.width(); ++x) {
+        const int k0 = x * (display_bins - 1) / spectrum_rect.width();
+        const int k1 = qMax(k0 + 1, (x + 1) * (display_bins - 1) / spectrum_rect.width());
+        float value = kMinDb;
+        for (int k = k0; k < k1 && k < display_bins; ++k) {
+            value = qMax(value, current_spectrum_[k]);
+        }
+        const double level = (qBound(kMinDb, value, kMaxDb) - kMinDb) / (kMaxDb - kMinDb);
+        const QPointF point(spectrum_rect.left() + x, spectrum_rect.bottom() - level * spectrum_rect.height());
+        if (x == 0) {
+            path.moveTo(point);
+        } else {
+            path.lineTo(point);
+        }
+    }
+    painter.setPen(QPen(Qt::red, 1));
+    painter.drawPath(path);
+    // 坐标标注
+    painter.setPen(Qt::black);
+    font.setBold(false);
+    painter.setFont(font);
+    painter.drawText(QRect(0, spectrum_rect.top(), 38, 20), Qt::AlignRight, QString::number(kMaxDb, 'f', 0) + "dB");
+    painter.drawText(QRect(0, spectrum_rect.bottom() - 20, 38, 20), Qt::AlignRight | Qt::AlignBottom, QString::number(kMinDb, 'f', 0) + "dB");
+    if (sample_rate_ > 0) {
+        const double max_freq = static_cast<double>(display_bins - 1) * sample_rate_ / kFftSize;
+        const double peak_freq = static_cast<double>(peak_bin) * sample_rate_ / kFftSize;
+        painter.drawText(spectrum_rect.adjusted(4, 2, -4, -2), Qt::AlignTop | Qt::AlignRight,
+                         QString("峰值: %1 Hz (%2 dB)\n0 - %3 Hz")
+                         .arg(peak_freq, 0, 'f', 1)
+                         .arg(current_spectrum_[peak_bin], 0, 'f', 1)
+                         .arg(max_freq, 0, 'f', 0));
+    }
+    // 时频图：环形图像分两段绘制，最旧的帧在左，只取显示频率范围内的行
+    const int row0 = bin_count - display_bins;
+    if (filled_columns_ < kHistoryColumns) {
+        const QRectF target(spectrogram_rect.left(), spectrogram_rect.top(),
+                            static_cast<double>(spectrogram_rect.width()) * filled_columns_ / kHistoryColumns,
+                            spectrogram_rect.height());
+        painter.drawImage(target, spectrogram_, QRectF(0, row0, filled_columns_, display_bins));
+    } else {
+        const int older = kHistoryColumns - write_column_;
+        const double column_width = static_cast<double>(spectrogram_rect.width()) / kHistoryColumns;
+        painter.drawImage(QRectF(spectrogram_rect.left(), spectrogram_rect.top(), older * column_width, spectrogram_rect.height()),
+                          spectrogram_, QRectF(write_column_, row0, older, display_bins));
+        painter.drawImage(QRectF(spectrogram_rect.left() + older * column_width, spectrogram_rect.top(),
+                                 write_column_ * column_width, spectrogram_rect.height()),
+                          spectrogram_, QRectF(0, row0, write_column_, display_bins));
+    }
+    painter.setPen(Qt::gray);
+    painter.drawRect(spectrogram_rect);
+}
+
+void SpectrumView::wheelEvent(QWheelEvent *event)
+{
+    const int zoom_amount = event->angleDelta().y() / 120; // 每滚动120单位为一个级别
+    if (zoom_amount > 0) {
+        display_bins_ = qMax(32, (display_bins_ - 1) / 2 + 1);
+    } else if (zoom_amount < 0) {
+        display_bins_ = qMin(fft_.get_bin_count(), (display_bins_ - 1) * 2 + 1);
+    }
+    update();
+    event->accept();
+}
@@ -0,0 +1,54 @@
+﻿#pragma once
+
+#include <QWidget>
+#include <QImage>
+#include <QAudioFormat>
+#include <vector>
+#include "fftprocessor.h"
+#include "audioblockpool.h"
+
+class SpectrumView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    SpectrumView(QWidget *parent);
+    ~SpectrumView();
+
+    void AppendAudioData(const QByteArray &audio_data, const QAudioFormat &format);
+    void AppendAudioBlock(const AudioBlockRef &block, const QAudioFormat &format);
+    void ClearDisplay();
+
+public:
+    static constexpr int kFftSize{ 4096 };          // FFT点数
+    static constexpr int kHopSize{ kFftSize / 4 };  // 帧移（75%重叠）
+    static constexpr int kHistoryColumns{ 600 };    // 时频图保留的帧数
+    static constexpr float kMinDb{ -100.0f };       // 显示动态范围
+    static constexpr float kMaxDb{ 0.0f };
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    // 滚轮缩放显示的频率范围
+    void wheelEvent(QWheelEvent *event) override;
+
+private:
+    void ProcessPendingFrames();
+    void PushSpectrogramColumn(const float *power_db);
+    void InitColorTable();
+
+private:
+    FftProcessor fft_;
+    // 待分析的单声道样本（多声道取平均）
+    std::vector<float> pending_samples_;
+    qsizetype pending_offset_{ 0 };
+    // 最新一帧的功率谱
+    std::vector<float> current_spectrum_;
+    // 时频图环形图像：每列为一帧，write_column_为下一次写入的列
+    QImage spectrogram_;
+    int write_column_{ 0 };
+    int filled_columns_{ 0 };
+    QList<QRgb> color_table_;
+    int sample_rate_{ 0 };
+    // 当前显示的频点数（从0 Hz开始）
+    int display_bins_{ kFftSize / 2 + 1 };
+};
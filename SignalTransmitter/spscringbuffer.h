@@ -0,0 +1,84 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// 单生产者/单消费者无锁环形缓冲区
+// 生产者只写head_，消费者只写tail_，两个索引分处不同缓存行避免伪共享；容量取2的幂，下标用掩码回绕
+template <typename T>
+class SpscRingBuffer
+{
+public:
+    explicit SpscRingBuffer(size_t capacity)
+        : capacity_(RoundUpPowerOfTwo(capacity))
+        , mask_(capacity_ - 1)
+        , buffer_(new T[capacity_])
+    {}
+
+    SpscRingBuffer(const SpscRingBuffer &) = delete;
+    SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+    // 生产者线程调用，返回实际写入的元素数（空间不足时只写入一部分）
+    size_t Write(const T *data, size_t count)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t n = std::min(count, capacity_ - (head - tail));
+        const size_t index = head & mask_;
+        const size_t first = std::min(n, capacity_ - index);
+        std::copy_n(data, first, buffer_.get() + index);
+        std::copy_n(data + first, n - first, buffer_.get());
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // 消费者线程调用，返回实际读出的元素数
+    size_t Read(T *out, size_t count)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t head = head_.load(std::memory_order_acquire);
+        const size_t n = std::min(count, head - tail);
+        const size_t index = tail & mask_;
+        const size_t first = std::min(n, capacity_ - index);
+        std::copy_n(buffer_.get() + index, first, out);
+        std::copy_n(buffer_.get(), n - first, out + first);
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    bool Push(const T &item) { return Write(&item, 1) == 1; }
+    bool Pop(T &item) { return Read(&item, 1) == 1; }
+
+    size_t ReadAvailable() const
+    {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+    size_t WriteAvailable() const { return capacity_ - ReadAvailable(); }
+    size_t get_capacity() const { return capacity_; }
+
+    // 仅在生产者和消费者都停止时调用
+    void Reset()
+    {
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static size_t RoundUpPowerOfTwo(size_t value)
+    {
+        size_t result{ 1 };
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+private:
+    alignas(64) std::atomic<size_t> head_{ 0 };
+    alignas(64) std::atomic<size_t> tail_{ 0 };
+    alignas(64) const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<T[]> buffer_;
+};
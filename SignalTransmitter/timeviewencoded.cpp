@@ -111,6 +111,16 @@ void TimeViewEncoded::UpdateView()
     }
 }
 
+void TimeViewEncoded::UpdateRange(qsizetype first, qsizetype removed, qsizetype added)
+{
+    const qsizetype window_end = start_index_ + display_count_;
+    // 长度不变时只有重叠的部分变化，长度变化时first之后的数据都会移动
+    const bool affected = removed == added ? first < window_end && first + added > start_index_ : first < window_end;
+    if (affected) {
+        UpdateView();
+    }
+}
+
 void TimeViewEncoded::wheelEvent(QWheelEvent *event)
 {
     // 如果没有数据，则不处理滚轮事件
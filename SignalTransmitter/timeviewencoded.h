@@ -15,6 +15,8 @@ public:
     void set_txt_model(TxtModel *txt_model_ptr) { txt_model_ = txt_model_ptr; }
 
     void UpdateView();
+    // 文本编辑后从first开始的removed个比特被替换为added个，变化影响当前窗口时才重绘
+    void UpdateRange(qsizetype first, qsizetype removed, qsizetype added);
 
 protected:
     // 重写鼠标滚轮事件处理
@@ -108,6 +108,16 @@ void TimeViewModulated::UpdateView()
     CalculateYAxisRange();
 }
 
+void TimeViewModulated::UpdateRange(qsizetype first, qsizetype removed, qsizetype added)
+{
+    const qsizetype window_end = start_sample_index_ + display_samples_;
+    // 长度不变时只有重叠的部分变化，长度变化时first之后的数据都会移动
+    const bool affected = removed == added ? first < window_end && first + added > start_sample_index_ : first < window_end;
+    if (affected) {
+        UpdateView();
+    }
+}
+
 void TimeViewModulated::wheelEvent(QWheelEvent *event)
 {
     // 如果没有数据，则不处理滚轮事件
@@ -16,6 +16,8 @@ public:
     void set_modulation_type(const QString &modulation_type) { modulation_type_ = modulation_type; }
 
     void UpdateView();
+    // 文本编辑后从first开始的removed个样本被替换为added个，变化影响当前窗口时才重绘
+    void UpdateRange(qsizetype first, qsizetype removed, qsizetype added);
 
 protected:
     // 重写鼠标滚轮事件处理
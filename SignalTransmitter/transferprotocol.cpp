@@ -0,0 +1,91 @@
+﻿#include "transferprotocol.h"
+#include "wavfile.h"
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+#include <cstring>
+
+void TransferProtocol::EncodeFrameHeader(const FrameHeader &header, uchar *buffer)
+{
+    qToBigEndian(kMagic, buffer);
+    buffer[4] = header.type;
+    buffer[5] = header.flags;
+    qToBigEndian(header.stream_id, buffer + 6);
+    qToBigEndian(header.length, buffer + 8);
+    qToBigEndian(header.sequence, buffer + 12);
+}
+
+bool TransferProtocol::DecodeFrameHeader(const uchar *buffer, FrameHeader &header)
+{
+    if (qFromBigEndian<quint32>(buffer) != kMagic) {
+        return false;
+    }
+    header.type = buffer[4];
+    header.flags = buffer[5];
+    header.stream_id = qFromBigEndian<quint16>(buffer + 6);
+    header.length = qFromBigEndian<quint32>(buffer + 8);
+    header.sequence = qFromBigEndian<quint32>(buffer + 12);
+    return true;
+}
+
+QByteArray TransferProtocol::MakeFrame(FrameType_t type, quint16 stream_id, quint32 sequence, const QByteArray &payload, quint8 flags)
+{
+    QByteArray frame(kFrameHeaderSize + payload.size(), Qt::Uninitialized);
+    FrameHeader header;
+    header.type = type;
+    header.flags = flags;
+    header.stream_id = stream_id;
+    header.length = static_cast<quint32>(payload.size());
+    header.sequence = sequence;
+    EncodeFrameHeader(header, reinterpret_cast<uchar *>(frame.data()));
+    memcpy(frame.data() + kFrameHeaderSize, payload.constData(), payload.size());
+    return frame;
+}
+
+QByteArray TransferProtocol::EncodeMetadata(const QVariantMap &metadata)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << metadata;
+    return data;
+}
+
+bool TransferProtocol::DecodeMetadata(const QByteArray &data, QVariantMap &metadata)
+{
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream >> metadata;
+    return stream.status() == QDataStream::Ok;
+}
+
+QVariantMap TransferProtocol::MetadataForFile(const QString &file_path)
+{
+    QFileInfo file_info(file_path);
+    QVariantMap metadata;
+    metadata.insert(kKeyName, file_info.fileName());
+    metadata.insert(kKeySize, file_info.size());
+    const QString suffix = file_info.suffix().toLower();
+    if (suffix == "txt") {
+        metadata.insert(kKeyContentType, QString("text/plain"));
+    } else if (suffix == "stfl") {
+        metadata.insert(kKeyContentType, QString("audio/x-stfl"));
+    } else if (suffix == "wav") {
+        metadata.insert(kKeyContentType, QString("audio/wav"));
+        // 头部之后可能还有LIST等附加块，读取文件开头一段即可找到data块
+        QFile file(file_path);
+        WavInfo info;
+        if (file.open(QIODevice::ReadOnly)) {
+            const QByteArray head = file.read(64 * 1024);
+            if (ParseWavHeader(reinterpret_cast<const uchar *>(head.constData()), head.size(), info)) {
+                metadata.insert(kKeySampleRate, info.sample_rate);
+                metadata.insert(kKeyChannels, info.channels);
+                metadata.insert(kKeyBitsPerSample, info.bits_per_sample);
+            }
+        }
+    } else {
+        metadata.insert(kKeyContentType, QString("application/octet-stream"));
+    }
+    return metadata;
+}
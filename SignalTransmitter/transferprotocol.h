@@ -0,0 +1,70 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVariantMap>
+
+// 分帧传输协议（版本3）
+// 客户端连接后发送版本号为3的请求（见NetworkModel），之后服务器发出的所有数据都是帧：
+// 帧头固定16字节（大端序）：魔数"STFR"(4) 帧类型(1) 标志(1) 流编号(2) 数据长度(4) 序号(4)，之后是数据。
+// 同一连接上的多个文件和实时音频流按流编号区分，帧可以交错；批量传输的文件依次发送，文件之间不需要等待应答。
+//
+// 元数据为QDataStream（Qt_6_0）编码的QVariantMap，值带类型，键见下方kKey*常量，可自由扩展。
+class TransferProtocol
+{
+public:
+    enum FrameType_t : quint8 {
+        kFrameHello = 1,            // 服务器信息（元数据）
+        kFrameFileBegin = 2,        // 文件开始（元数据）
+        kFrameFileData = 3,         // 文件内容，序号为该文件内的帧序号
+        kFrameFileEnd = 4,          // 文件结束，数据为整个文件的CRC32C（4字节）
+        kFrameStreamBegin = 5,      // 音频流开始（元数据）
+        kFrameStreamData = 6,       // 音频数据，序号为采集序号的低32位，数据前8字节为时间戳（微秒）
+        kFrameStreamEnd = 7,        // 音频流结束
+        kFrameBatchEnd = 8          // 本批文件全部发送完毕，数据为文件数（4字节）
+    };
+
+    enum FrameFlag_t : quint8 {
+        kFlagCompressed = 0x01      // 数据为qCompress格式
+    };
+
+    struct FrameHeader {
+        quint8 type{ 0 };
+        quint8 flags{ 0 };
+        quint16 stream_id{ 0 };
+        quint32 length{ 0 };
+        quint32 sequence{ 0 };
+    };
+
+    // 帧头编解码，buffer长度至少为kFrameHeaderSize
+    static void EncodeFrameHeader(const FrameHeader &header, uchar *buffer);
+    static bool DecodeFrameHeader(const uchar *buffer, FrameHeader &header);
+    // 生成带数据的完整帧
+    static QByteArray MakeFrame(FrameType_t type, quint16 stream_id, quint32 sequence, const QByteArray &payload, quint8 flags = 0);
+
+    // 元数据编解码
+    static QByteArray EncodeMetadata(const QVariantMap &metadata);
+    static bool DecodeMetadata(const QByteArray &data, QVariantMap &metadata);
+    // 根据文件内容生成元数据：文件名、大小、内容类型，WAV文件附加采样率、声道数和位深
+    static QVariantMap MetadataForFile(const QString &file_path);
+
+    static constexpr quint32 kMagic{ 0x53544652 };     // "STFR"
+    static constexpr quint32 kVersion{ 3 };
+    static constexpr int kFrameHeaderSize{ 16 };
+    static constexpr quint16 kAudioStreamId{ 0 };      // 实时音频流固定使用0，文件从1开始编号
+
+    static constexpr const char *kKeyName{ "name" };
+    static constexpr const char *kKeySize{ "size" };
+    static constexpr const char *kKeyContentType{ "content_type" };
+    static constexpr const char *kKeySampleRate{ "sample_rate" };
+    static constexpr const char *kKeyChannels{ "channels" };
+    static constexpr const char *kKeyBitsPerSample{ "bits_per_sample" };
+    static constexpr const char *kKeySampleFormat{ "sample_format" };
+    static constexpr const char *kKeyEncoding{ "encoding" };
+    static constexpr const char *kKeyModulation{ "modulation" };
+    static constexpr const char *kKeyCarrierFrequency{ "carrier_frequency" };
+    static constexpr const char *kKeySamplesPerBit{ "samples_per_bit" };
+    static constexpr const char *kKeyBatchIndex{ "batch_index" };
+    static constexpr const char *kKeyBatchCount{ "batch_count" };
+    static constexpr const char *kKeyProtocolVersion{ "protocol_version" };
+};
@@ -0,0 +1,156 @@
+﻿#include "transfersource.h"
+#include "transferprotocol.h"
+#include "wavfile.h"
+#include <QFileInfo>
+#include <QtEndian>
+#include <cstring>
+
+FileTransferSource::FileTransferSource(const QString &file_path)
+    : file_(file_path)
+    , size_(QFileInfo(file_path).size())
+{
+}
+
+bool FileTransferSource::Open()
+{
+    if (file_.isOpen()) {
+        return true;
+    }
+    // 文件在选择后被修改时不再发送
+    if (!file_.open(QIODevice::ReadOnly) || file_.size() != size_) {
+        file_.close();
+        return false;
+    }
+    if (size_ > kMapThreshold) {
+        data_ = file_.map(0, size_);
+        if (data_) {
+            return true;
+        }
+    }
+    // 小文件或无法映射时整体读入内存
+    buffer_ = file_.readAll();
+    file_.close();
+    if (buffer_.size() != size_) {
+        buffer_.clear();
+        return false;
+    }
+    data_ = reinterpret_cast<const uchar *>(buffer_.constData());
+    return true;
+}
+
+void FileTransferSource::Close()
+{
+    // 关闭文件同时解除映射
+    data_ = nullptr;
+    buffer_.clear();
+    file_.close();
+}
+
+QByteArray FileTransferSource::Read(qint64 offset, qint64 max_size)
+{
+    if (!data_ || offset < 0 || offset >= size_) {
+        return QByteArray();
+    }
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(data_ + offset), qMin(max_size, size_ - offset));
+}
+
+QVariantMap FileTransferSource::metadata() const
+{
+    return TransferProtocol::MetadataForFile(file_.fileName());
+}
+
+SignalTransferSource::SignalTransferSource(const QString &name, const QList<double> &samples, int sample_rate)
+    : name_(name)
+    , samples_(samples)
+    , sample_rate_(sample_rate)
+{
+    // RIFF + fmt(18字节，浮点格式) + fact + data块头
+    const auto data_size = static_cast<quint32>(qMin<qint64>(samples_.size() * 8, 0xFFFFFFFF - 50));
+    header_.resize(58);
+    auto *p = reinterpret_cast<uchar *>(header_.data());
+    memcpy(p, "RIFF", 4);
+    qToLittleEndian<quint32>(50 + data_size, p + 4);
+    memcpy(p + 8, "WAVEfmt ", 8);
+    qToLittleEndian<quint32>(18, p + 16);
+    qToLittleEndian<quint16>(WavInfo::kFormatFloat, p + 20);
+    qToLittleEndian<quint16>(1, p + 22);
+    qToLittleEndian<quint32>(static_cast<quint32>(sample_rate_), p + 24);
+    qToLittleEndian<quint32>(static_cast<quint32>(sample_rate_) * 8, p + 28);
+    qToLittleEndian<quint16>(8, p + 32);
+    qToLittleEndian<quint16>(64, p + 34);
+    qToLittleEndian<quint16>(0, p + 36);
+    memcpy(p + 38, "fact", 4);
+    qToLittleEndian<quint32>(4, p + 42);
+    qToLittleEndian<quint32>(data_size / 8, p + 46);
+    memcpy(p + 50, "data", 4);
+    qToLittleEndian<quint32>(data_size, p + 54);
+}
+
+QByteArray SignalTransferSource::Read(qint64 offset, qint64 max_size)
+{
+    if (offset < 0 || offset >= size()) {
+        return QByteArray();
+    }
+    if (offset < header_.size()) {
+        return header_.mid(offset, qMin(max_size, header_.size() - offset));
+    }
+    // 只返回完整的样本，避免跨样本的片段
+    const qint64 byte_offset = offset - header_.size();
+    qint64 bytes = qMin(max_size, samples_.size() * static_cast<qint64>(sizeof(double)) - byte_offset);
+    if (bytes >= 8) {
+        bytes -= bytes % 8;
+    }
+    const char *data = reinterpret_cast<const char *>(samples_.constData()) + byte_offset;
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    buffer_.resize(bytes);
+    for (qint64 i = 0; i + 8 <= bytes; i += 8) {
+        qToLittleEndian(qFromUnaligned<quint64>(data + i), buffer_.data() + i);
+    }
+    return buffer_;
+#else
+    return QByteArray::fromRawData(data, bytes);
+#endif
+}
+
+QVariantMap SignalTransferSource::metadata() const
+{
+    QVariantMap metadata;
+    metadata.insert(TransferProtocol::kKeyName, name_);
+    metadata.insert(TransferProtocol::kKeySize, size());
+    metadata.insert(TransferProtocol::kKeyContentType, QString("audio/wav"));
+    metadata.insert(TransferProtocol::kKeySampleRate, sample_rate_);
+    metadata.insert(TransferProtocol::kKeyChannels, 1);
+    metadata.insert(TransferProtocol::kKeyBitsPerSample, 64);
+    return metadata;
+}
+
+BitTransferSource::BitTransferSource(const QString &name, const QList<uint8_t> &bits)
+    : name_(name)
+    , bits_(bits)
+{
+}
+
+QByteArray BitTransferSource::Read(qint64 offset, qint64 max_size)
+{
+    if (offset < 0 || offset >= size()) {
+        return QByteArray();
+    }
+    // 只转换本次发送的一段，缓冲区大小与发送块相同
+    const qint64 count = qMin(max_size, size() - offset);
+    buffer_.resize(count);
+    const uint8_t *bits = bits_.constData() + offset;
+    char *out = buffer_.data();
+    for (qint64 i = 0; i < count; ++i) {
+        out[i] = bits[i] ? '1' : '0';
+    }
+    return buffer_;
+}
+
+QVariantMap BitTransferSource::metadata() const
+{
+    QVariantMap metadata;
+    metadata.insert(TransferProtocol::kKeyName, name_);
+    metadata.insert(TransferProtocol::kKeySize, size());
+    metadata.insert(TransferProtocol::kKeyContentType, QString("text/plain"));
+    return metadata;
+}
@@ -0,0 +1,90 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QVariantMap>
+#include <memory>
+
+// 传输数据源
+// 网络模型按位置分段读取要发送的内容：文件按需映射，内存中的模型数据直接引用或分段序列化，
+// 发送前不需要先保存为临时文件。Read返回的数据在下一次Read或Close之前有效。
+class TransferSource
+{
+public:
+    virtual ~TransferSource() = default;
+
+    virtual bool Open() = 0;
+    virtual void Close() {}
+    virtual qint64 size() const = 0;
+    // 读取从offset开始的至多max_size字节，可能少于max_size（如跨越文件头和数据的边界）
+    virtual QByteArray Read(qint64 offset, qint64 max_size) = 0;
+    // 文件名、内容类型等元数据，键见TransferProtocol
+    virtual QVariantMap metadata() const = 0;
+    // 数据来自磁盘文件时返回路径（可零拷贝发送和续传），否则为空
+    virtual QString file_path() const { return QString(); }
+};
+
+using TransferSourcePtr = std::shared_ptr<TransferSource>;
+
+// 磁盘文件：大文件映射，小文件读入内存
+class FileTransferSource : public TransferSource
+{
+public:
+    explicit FileTransferSource(const QString &file_path);
+
+    bool Open() override;
+    void Close() override;
+    qint64 size() const override { return size_; }
+    QByteArray Read(qint64 offset, qint64 max_size) override;
+    QVariantMap metadata() const override;
+    QString file_path() const override { return file_.fileName(); }
+
+    static constexpr qint64 kMapThreshold{ 1024 * 1024 };     // 超过此大小的文件用映射，否则读入内存
+
+private:
+    QFile file_;
+    qint64 size_{ 0 };
+    const uchar *data_{ nullptr };
+    QByteArray buffer_;
+};
+
+// 调制信号：64位浮点单声道WAV，文件头在内存中生成，样本直接引用信号数据（隐式共享，不复制）
+class SignalTransferSource : public TransferSource
+{
+public:
+    SignalTransferSource(const QString &name, const QList<double> &samples, int sample_rate);
+
+    bool Open() override { return true; }
+    qint64 size() const override { return header_.size() + samples_.size() * static_cast<qint64>(sizeof(double)); }
+    QByteArray Read(qint64 offset, qint64 max_size) override;
+    QVariantMap metadata() const override;
+
+private:
+    QString name_;
+    QList<double> samples_;
+    int sample_rate_{ 0 };
+    QByteArray header_;
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    QByteArray buffer_;                 // 大端平台上转换为小端序
+#endif
+};
+
+// 编码比特流：与TxtModel::SaveEncodedFile相同的文本格式（每位一个'0'或'1'字符），读取时分段转换
+class BitTransferSource : public TransferSource
+{
+public:
+    BitTransferSource(const QString &name, const QList<uint8_t> &bits);
+
+    bool Open() override { return true; }
+    void Close() override { buffer_.clear(); }
+    qint64 size() const override { return bits_.size(); }
+    QByteArray Read(qint64 offset, qint64 max_size) override;
+    QVariantMap metadata() const override;
+
+private:
+    QString name_;
+    QList<uint8_t> bits_;
+    QByteArray buffer_;
+};
@@ -1,145 +1,238 @@
 ﻿#include "txtmodel.h"
-#include <QFile>
-#include <QMessageBox>
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// 把list中从first开始的removed个元素替换为data中的added个，重叠部分原地覆盖，只移动一次其后的数据
+template <typename T>
+void ReplaceSpan(QList<T> &list, qsizetype first, qsizetype removed, const T *data, qsizetype added)
+{
+    const qsizetype common = qMin(removed, added);
+    std::copy(data, data + common, list.begin() + first);
+    if (added > removed) {
+        list.insert(first + common, added - removed, T{});
+        std::copy(data + common, data + added, list.begin() + first + common);
+    } else if (removed > added) {
+        list.remove(first + common, removed - added);
+    }
+}
+
+}
 
 TxtModel::TxtModel(QObject *parent)
     : QObject(parent)
 {}
 
 TxtModel::~TxtModel()
-{}
+{
+    // 先停止处理图，线程池随后销毁
+    graph_.reset();
+}
 
 bool TxtModel::LoadTxtFile(const QString &file_name)
 {
-    QFile file(file_name);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QMessageBox::warning(static_cast<QWidget *>(parent()), "Error", QString("Cannot open file: %1")
-                             .arg(file.errorString()));
+    QString text;
+    QString error;
+    if (!SignalCore::ReadTextFile(file_name, text, error)) {
+        emit ErrorOccurred(error);
         return false;
     }
-    QTextStream in(&file);
-    txt_raw_data_ = in.readAll();
-    file.close();
+    txt_raw_data_ = text;
+    encoding_ = SignalCore::kEncodingUnknown;
+    modulation_ = SignalCore::kModulationUnknown;
     return true;
 }
 
 bool TxtModel::SaveTxtFile(const QString &file_name)
 {
-    QFile file(file_name);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::warning(static_cast<QWidget *>(parent()), "Error", QString("Cannot open file: %1")
-                             .arg(file.errorString()));
+    QString error;
+    if (!SignalCore::WriteTextFile(file_name, txt_raw_data_, error)) {
+        emit ErrorOccurred(error);
         return false;
     }
-    QTextStream out(&file);
-    out << txt_raw_data_;
-    file.close();
     return true;
 }
 
-void TxtModel::EncodeTxtFile(const QString &encode_t)
+void TxtModel::EncodeTxtFile(const QString &encode_t, const QString &modulate_t)
 {
-    txt_encoded_data_.clear();
-    QByteArray encoded;
-
-    // 根据编码类型将原始文本转换为字节流
-    if (encode_t.compare("UTF-8", Qt::CaseInsensitive) == 0) {
-        encoded = txt_raw_data_.toUtf8();
-    } else if (encode_t.compare("UTF-16", Qt::CaseInsensitive) == 0) {
-        const auto *data = reinterpret_cast<const char16_t *>(txt_raw_data_.utf16());
-        auto byte_count = txt_raw_data_.size() * 2;
-        encoded = QByteArray(reinterpret_cast<const char *>(data), byte_count);
-    }
-    // 按位展开，每个位存为0或1
-    txt_encoded_data_.reserve(encoded.size() * 8);
-    for (auto byte : encoded) {
-        auto ubyte = static_cast<uint8_t>(static_cast<unsigned char>(byte));
-        for (auto i{ 7 }; i >= 0; --i) { // 高位在前
-            txt_encoded_data_.append((ubyte >> i) & 0x01);
-        }
-    }
+    StartEncode(SignalCore::EncodingFromName(encode_t), SignalCore::ModulationFromName(modulate_t));
 }
 
 void TxtModel::ModulateTxtFile(const QString &modulate_t)
 {
-    const double ask_high{ 1.0 }, ask_low{ 0.0 };       // ASK高低电平
-    // 载波参数
-    const double ask_f0 = kCarrierFreq;    // ASK载波频率
-    const double psk_f = kCarrierFreq;     // PSK载波频率
-
-    const auto sample_rate{ kSampleRate };
-    const auto samples_per_bit{ kSamplesPerBit };
-
-    // 计算预期数据大小并预分配内存
-    const qsizetype expected_size = txt_encoded_data_.size() * samples_per_bit;
-    txt_modulated_data.clear();
-    txt_modulated_data.reserve(expected_size);
-
-    if (modulate_t.compare("ASK", Qt::CaseInsensitive) == 0) {
-        // 振幅键控
-        // 预计算一个比特周期内的正弦波形状
-        QList<double> high_pattern(samples_per_bit);
-        QList<double> low_pattern(samples_per_bit);
-
-        // 计算高电平和低电平的波形模板
-        for (qsizetype n = 0; n < samples_per_bit; ++n) {
-            double t = static_cast<double>(n) / sample_rate;
-            high_pattern[n] = ask_high * sin(2 * M_PI * ask_f0 * t);
-            low_pattern[n] = ask_low * sin(2 * M_PI * ask_f0 * t);
-        }
-
-        // 对每个比特应用预计算的波形模板
-        for (auto bit : txt_encoded_data_) {
-            const auto& pattern = (bit == 1) ? high_pattern : low_pattern;
-            txt_modulated_data.append(pattern);
-        }
-    } else if (modulate_t.compare("PSK", Qt::CaseInsensitive) == 0) {
-        // 相位键控
-        // 预计算一个比特周期内的0相位和π相位正弦波形状
-        QList<double> phase0_pattern(samples_per_bit);
-        QList<double> phasePI_pattern(samples_per_bit);
-
-        // 计算两种相位的波形模板
-        for (qsizetype n = 0; n < samples_per_bit; ++n) {
-            double t = static_cast<double>(n) / sample_rate;
-            phase0_pattern[n] = sin(2 * M_PI * psk_f * t);
-            phasePI_pattern[n] = sin(2 * M_PI * psk_f * t + M_PI);
-        }
-
-        // 对每个比特应用预计算的波形模板
-        for (auto bit : txt_encoded_data_) {
-            const auto& pattern = (bit == 1) ? phasePI_pattern : phase0_pattern;
-            txt_modulated_data.append(pattern);
-        }
+    const auto modulation = SignalCore::ModulationFromName(modulate_t);
+    if (graph_ && encoded_sink_) {
+        StartEncode(graph_encoding_, modulation);
+    } else {
+        StartModulate(modulation);
     }
 }
 
-void TxtModel::SaveEncodedFile(const QString &file_name)
+void TxtModel::StartEncode(SignalCore::Encoding_t encoding, SignalCore::Modulation_t modulation)
 {
-    QFile file(file_name);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::warning(static_cast<QWidget *>(parent()), "Error", QString("Cannot open file: %1")
-                             .arg(file.errorString()));
+    // 文本源 -> 编码 -> 分流 -> 收集比特
+    //                         -> 调制 -> 收集样本
+    // 调制与编码同时进行，完整的比特序列不需要先生成出来
+    graph_.reset();
+    graph_ = std::make_unique<DspGraph>();
+    auto *text = graph_->AddStream<char16_t>();
+    auto *bits = graph_->AddStream<uint8_t>();
+    auto *kept_bits = graph_->AddStream<uint8_t>();
+    auto *modulator_bits = graph_->AddStream<uint8_t>();
+    auto *samples = graph_->AddStream<double>();
+    graph_->AddBlock<TextSourceBlock>(txt_raw_data_, text);
+    graph_->AddBlock<EncoderBlock>(encoding, text, bits);
+    graph_->AddBlock<TeeBlock<uint8_t>>(bits, kept_bits, modulator_bits);
+    encoded_sink_ = graph_->AddBlock<VectorSinkBlock<uint8_t>>(kept_bits, txt_raw_data_.size() * 8);
+    graph_->AddBlock<ModulatorBlock>(modulation, modulator_bits, samples);
+    modulated_sink_ = graph_->AddBlock<VectorSinkBlock<double>>(samples, txt_raw_data_.size() * 8 * kSamplesPerBit);
+    graph_encoding_ = encoding;
+    graph_modulation_ = modulation;
+    // 现有数据将被替换，编辑时不再增量更新
+    encoding_ = SignalCore::kEncodingUnknown;
+    modulation_ = SignalCore::kModulationUnknown;
+    StartGraph();
+}
+
+void TxtModel::StartModulate(SignalCore::Modulation_t modulation)
+{
+    // 比特源 -> 调制 -> 收集样本
+    graph_.reset();
+    graph_ = std::make_unique<DspGraph>();
+    auto *bits = graph_->AddStream<uint8_t>();
+    auto *samples = graph_->AddStream<double>();
+    graph_->AddBlock<VectorSourceBlock<uint8_t>>(txt_encoded_data_, bits);
+    graph_->AddBlock<ModulatorBlock>(modulation, bits, samples);
+    encoded_sink_ = nullptr;
+    modulated_sink_ = graph_->AddBlock<VectorSinkBlock<double>>(samples, txt_encoded_data_.size() * kSamplesPerBit);
+    graph_modulation_ = modulation;
+    modulation_ = SignalCore::kModulationUnknown;
+    StartGraph();
+}
+
+void TxtModel::StartGraph()
+{
+    const quint64 graph_id = ++graph_id_;
+    graph_->set_finished_handler([this, graph_id](bool ok) {
+        QMetaObject::invokeMethod(this, [this, graph_id, ok]() { FinishGraph(graph_id, ok); }, Qt::QueuedConnection);
+    });
+    graph_->Start(&pool_);
+}
+
+void TxtModel::FinishGraph(quint64 graph_id, bool ok)
+{
+    if (graph_id != graph_id_ || !graph_) {
         return;
     }
-    QTextStream out(&file);
-    for (auto bit : txt_encoded_data_) {
-        out << bit;
+    const std::unique_ptr<DspGraph> graph = std::move(graph_);
+    auto *encoded_sink = std::exchange(encoded_sink_, nullptr);
+    auto *modulated_sink = std::exchange(modulated_sink_, nullptr);
+    if (!ok) {
+        emit ErrorOccurred(graph->get_error());
+        return;
+    }
+    if (encoded_sink) {
+        txt_encoded_data_ = std::move(encoded_sink->get_data());
+        encoding_ = graph_encoding_;
+    }
+    txt_modulated_data = std::move(modulated_sink->get_data());
+    modulation_ = graph_modulation_;
+    if (encoded_sink) {
+        emit EncodingFinished();
+    }
+    emit ModulationFinished();
+}
+
+void TxtModel::SaveEncodedFile(const QString &file_name)
+{
+    QString error;
+    if (!SignalCore::WriteEncodedFile(file_name, txt_encoded_data_, error)) {
+        emit ErrorOccurred(error);
     }
-    file.close();
 }
 
 void TxtModel::SaveModulatedFile(const QString &file_name)
 {
-    QFile file(file_name);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::warning(static_cast<QWidget *>(parent()), "Error", QString("Cannot open file: %1")
-                             .arg(file.errorString()));
+    QString error;
+    if (!SignalCore::WriteModulatedFile(file_name, txt_modulated_data, error)) {
+        emit ErrorOccurred(error);
+    }
+}
+
+void TxtModel::ReplaceText(qsizetype position, qsizetype removed, const QString &inserted)
+{
+    position = qBound<qsizetype>(0, position, txt_raw_data_.size());
+    removed = qBound<qsizetype>(0, removed, txt_raw_data_.size() - position);
+    if (graph_ && encoded_sink_) {
+        // 正在编码的是编辑前的文本，以新文本重新开始
+        txt_raw_data_.replace(position, removed, inserted);
+        StartEncode(graph_encoding_, graph_modulation_);
+        return;
+    }
+    ReplaceEncodedText(position, removed, inserted);
+    if (graph_) {
+        // 正在调制的是编辑前的比特
+        StartModulate(graph_modulation_);
+    }
+}
+
+void TxtModel::ReplaceEncodedText(qsizetype position, qsizetype removed, const QString &inserted)
+{
+    if (encoding_ == SignalCore::kEncodingUnknown) {
+        txt_raw_data_.replace(position, removed, inserted);
+        return;
+    }
+    // 受影响的范围向两侧各扩展到不拆分代理项对，范围外的字符编码不变
+    qsizetype begin = position;
+    qsizetype end = position + removed;
+    if (begin > 0 && txt_raw_data_[begin - 1].isHighSurrogate()) {
+        --begin;
+    }
+    if (end < txt_raw_data_.size() && txt_raw_data_[end].isLowSurrogate()) {
+        ++end;
+    }
+    const QStringView raw(txt_raw_data_);
+    const qsizetype byte_offset = SignalCore::EncodedSize(raw.first(begin), encoding_);
+    const QByteArray old_bytes = SignalCore::EncodeText(raw.sliced(begin, end - begin), encoding_);
+    QString new_text;
+    new_text.reserve(end - begin - removed + inserted.size());
+    new_text.append(raw.sliced(begin, position - begin));
+    new_text.append(inserted);
+    new_text.append(raw.sliced(position + removed, end - position - removed));
+    const QByteArray new_bytes = SignalCore::EncodeText(new_text, encoding_);
+    txt_raw_data_.replace(position, removed, inserted);
+
+    // 去掉新旧编码相同的首尾字节，只更新实际变化的部分
+    qsizetype prefix{ 0 };
+    const qsizetype min_size = qMin(old_bytes.size(), new_bytes.size());
+    while (prefix < min_size && old_bytes[prefix] == new_bytes[prefix]) {
+        ++prefix;
+    }
+    qsizetype suffix{ 0 };
+    while (suffix < min_size - prefix && old_bytes[old_bytes.size() - 1 - suffix] == new_bytes[new_bytes.size() - 1 - suffix]) {
+        ++suffix;
+    }
+    const qsizetype removed_bytes = old_bytes.size() - prefix - suffix;
+    const qsizetype added_bytes = new_bytes.size() - prefix - suffix;
+    if (removed_bytes == 0 && added_bytes == 0) {
         return;
     }
-    QTextStream out(&file);
-    for (auto sample : txt_modulated_data) {
-        out << sample << " ";
+
+    const qsizetype first_bit = (byte_offset + prefix) * 8;
+    const qsizetype removed_bits = removed_bytes * 8;
+    const qsizetype added_bits = added_bytes * 8;
+    std::vector<uint8_t> bits(static_cast<size_t>(added_bits));
+    SignalCore::ExpandBits(new_bytes.constData() + prefix, added_bytes, bits.data());
+    ReplaceSpan(txt_encoded_data_, first_bit, removed_bits, bits.data(), added_bits);
+    emit EncodedDataChanged(first_bit, removed_bits, added_bits);
+
+    if (modulation_ == SignalCore::kModulationUnknown) {
+        return;
     }
-    file.close();
+    // 每个比特的波形只取决于该比特，受影响的样本与比特一一对应
+    std::vector<double> samples(static_cast<size_t>(added_bits * kSamplesPerBit));
+    SignalCore::Modulate(bits.data(), added_bits, modulation_, samples.data());
+    ReplaceSpan(txt_modulated_data, first_bit * kSamplesPerBit, removed_bits * kSamplesPerBit, samples.data(), added_bits * kSamplesPerBit);
+    emit ModulatedDataChanged(first_bit * kSamplesPerBit, removed_bits * kSamplesPerBit, added_bits * kSamplesPerBit);
 }
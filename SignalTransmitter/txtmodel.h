@@ -2,7 +2,12 @@
 
 #include <QObject>
 #include <QList>
+#include <QThreadPool>
+#include <memory>
+#include "dspblocks.h"
+#include "signalcore.h"
 
+// 界面使用的文本模型：保存当前的原始、编码和调制数据，处理逻辑在SignalCore中
 class TxtModel  : public QObject
 {
     Q_OBJECT
@@ -17,17 +22,55 @@ public:
 
     bool LoadTxtFile(const QString &file_name);
     bool SaveTxtFile(const QString &file_name);
-    void EncodeTxtFile(const QString &encode_t);
+    // 编码并按modulate_t调制：文本源 -> 编码 -> 分流 -> (收集比特, 调制 -> 收集样本)，各级在模型的线程池中流水处理，
+    // 调用后立即返回，完成时发出EncodingFinished和ModulationFinished，出错时发出ErrorOccurred
+    void EncodeTxtFile(const QString &encode_t, const QString &modulate_t);
+    // 只重新调制已编码的比特，完成时发出ModulationFinished；正在编码时改为按新的调制方式重新编码
     void ModulateTxtFile(const QString &modulate_t);
+    bool IsProcessing() const { return graph_ != nullptr; }
     void SaveEncodedFile(const QString &file_name);
     void SaveModulatedFile(const QString &file_name);
+    // 编辑文本：[position, position + removed)替换为inserted
+    // 已编码（已调制）时只重新编码受影响的字符，原地修改对应的比特和样本，长度变化时移动其后的数据；
+    // 正在处理时以编辑后的文本重新开始
+    void ReplaceText(qsizetype position, qsizetype removed, const QString &inserted);
 
-    static constexpr double kSampleRate{ 1600.0 };
-    static constexpr qsizetype kSamplesPerBit { 16 };
-    static constexpr double kCarrierFreq{ 200 };
+    static constexpr double kSampleRate{ SignalCore::kSampleRate };
+    static constexpr qsizetype kSamplesPerBit { SignalCore::kSamplesPerBit };
+    static constexpr double kCarrierFreq{ SignalCore::kCarrierFreq };
+
+private:
+    void StartEncode(SignalCore::Encoding_t encoding, SignalCore::Modulation_t modulation);
+    void StartModulate(SignalCore::Modulation_t modulation);
+    // 在线程池中启动graph_，结束时回到界面线程调用FinishGraph
+    void StartGraph();
+    void FinishGraph(quint64 graph_id, bool ok);
+    // ReplaceText的增量更新部分
+    void ReplaceEncodedText(qsizetype position, qsizetype removed, const QString &inserted);
 
 private:
     QString txt_raw_data_;
     QList<uint8_t> txt_encoded_data_;
     QList<double> txt_modulated_data;
+    // 当前编码和调制数据对应的方式，未知表示数据与文本不同步，编辑时不更新
+    SignalCore::Encoding_t encoding_{ SignalCore::kEncodingUnknown };
+    SignalCore::Modulation_t modulation_{ SignalCore::kModulationUnknown };
+    // 处理图在模型自己的线程池中运行：界面线程不等待，也不与全局线程池中的眼图、压缩等任务争用线程
+    QThreadPool pool_;
+    std::unique_ptr<DspGraph> graph_;
+    quint64 graph_id_{ 0 };                             // 重新开始后忽略旧图的结束通知
+    VectorSinkBlock<uint8_t> *encoded_sink_{ nullptr };  // 只调制时为空
+    VectorSinkBlock<double> *modulated_sink_{ nullptr };
+    SignalCore::Encoding_t graph_encoding_{ SignalCore::kEncodingUnknown };
+    SignalCore::Modulation_t graph_modulation_{ SignalCore::kModulationUnknown };
+
+signals:
+    // 文件读写失败，由界面决定如何提示
+    void ErrorOccurred(const QString &message);
+    // 编码、调制数据已更新
+    void EncodingFinished();
+    void ModulationFinished();
+    // 编辑文本后从first开始的removed个比特（样本）被替换为added个，其后的数据随之移动
+    void EncodedDataChanged(qsizetype first, qsizetype removed, qsizetype added);
+    void ModulatedDataChanged(qsizetype first, qsizetype removed, qsizetype added);
 };
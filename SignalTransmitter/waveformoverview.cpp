@@ -0,0 +1,148 @@
+﻿#include "waveformoverview.h"
+#include <QPainter>
+#include <QMouseEvent>
+#include <QtConcurrent>
+
+WaveformOverview::WaveformOverview(QWidget *parent)
+    : QWidget(parent)
+    , watcher_(new QFutureWatcher<std::shared_ptr<PeakFile>>(this))
+{
+    setMinimumHeight(60);
+    setCursor(Qt::PointingHandCursor);
+    // 监视器只报告最后一次设置的任务，之前未完成的任务结果被丢弃
+    connect(watcher_, &QFutureWatcher<std::shared_ptr<PeakFile>>::finished, this, [this]() {
+        peaks_ = watcher_->result();
+        is_loading_ = false;
+        RenderWaveform();
+        update();
+    });
+}
+
+WaveformOverview::~WaveformOverview()
+{
+    watcher_->waitForFinished();
+}
+
+void WaveformOverview::LoadFile(const QString &wav_path)
+{
+    ClearDisplay();
+    is_loading_ = true;
+    watcher_->setFuture(QtConcurrent::run([wav_path]() {
+        return PeakFile::Build(wav_path);
+    }));
+    update();
+}
+
+void WaveformOverview::ClearDisplay()
+{
+    peaks_.reset();
+    waveform_pixmap_ = QPixmap();
+    playhead_frame_ = 0;
+    is_loading_ = false;
+    update();
+}
+
+void WaveformOverview::SetPlayhead(qint64 frame)
+{
+    if (frame == playhead_frame_) {
+        return;
+    }
+    playhead_frame_ = frame;
+    update();
+}
+
+void WaveformOverview::RenderWaveform()
+{
+    waveform_pixmap_ = QPixmap();
+    if (!peaks_ || width() <= 0 || height() <= 0) {
+        return;
+    }
+    waveform_pixmap_ = QPixmap(size());
+    waveform_pixmap_.fill(Qt::white);
+    QPainter painter(&waveform_pixmap_);
+    const int w = width();
+    const int h = height();
+    const double mid = h / 2.0;
+    painter.setPen(Qt::lightGray);
+    painter.drawLine(0, qRound(mid), w, qRound(mid));
+    // 按每像素帧数选择分辨率合适的一级，每列取其覆盖峰值的最小/最大值
+    const double frames_per_pixel = static_cast<double>(peaks_->get_frame_count()) / w;
+    const int level = peaks_->LevelForResolution(frames_per_pixel);
+    const auto &peaks = peaks_->get_level(level);
+    const double peaks_per_pixel = frames_per_pixel / peaks_->get_frames_per_peak(level);
+    painter.setPen(QColor(0, 102, 204));
+    for (int x = 0; x < w; ++x) {
+        const qsizetype first = static_cast<qsizetype>(x * peaks_per_pixel);
+        const qsizetype last = qMin(peaks.size(), qMax(first + 1, static_cast<qsizetype>((x + 1) * peaks_per_pixel)));
+        if (first >= peaks.size()) {
+            break;
+        }
+        qint16 min_value = peaks[first].min;
+        qint16 max_value = peaks[first].max;
+        for (qsizetype i = first + 1; i < last; ++i) {
+            min_value = qMin(min_value, peaks[i].min);
+            max_value = qMax(max_value, peaks[i].max);
+        }
+        const int y_top = qRound(mid - max_value / 32768.0 * mid);
+        const int y_bottom = qRound(mid - min_value / 32768.0 * mid);
+        painter.drawLine(x, y_top, x, y_bottom);
+    }
+}
+
+void WaveformOverview::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    if (waveform_pixmap_.isNull()) {
+        painter.fillRect(rect(), Qt::white);
+        painter.setPen(Qt::gray);
+        painter.drawText(rect(), Qt::AlignCenter, is_loading_ ? "正在生成波形概览..." : "未加载音频文件");
+        return;
+    }
+    painter.drawPixmap(0, 0, waveform_pixmap_);
+    // 播放指示线
+    if (peaks_->get_frame_count() > 0) {
+        const int x = static_cast<int>(playhead_frame_ * width() / peaks_->get_frame_count());
+        painter.setPen(QPen(Qt::red, 1));
+        painter.drawLine(x, 0, x, height());
+    }
+}
+
+void WaveformOverview::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    RenderWaveform();
+}
+
+void WaveformOverview::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        seek_timer_.start();
+        EmitSeek(event->position().x());
+    }
+}
+
+void WaveformOverview::mouseMoveEvent(QMouseEvent *event)
+{
+    if ((event->buttons() & Qt::LeftButton) && seek_timer_.elapsed() >= kSeekInterval) {
+        seek_timer_.start();
+        EmitSeek(event->position().x());
+    }
+}
+
+void WaveformOverview::mouseReleaseEvent(QMouseEvent *event)
+{
+    // 松开时跳到最终位置
+    if (event->button() == Qt::LeftButton) {
+        EmitSeek(event->position().x());
+    }
+}
+
+void WaveformOverview::EmitSeek(double x)
+{
+    if (!peaks_ || width() <= 0) {
+        return;
+    }
+    const double ratio = qBound(0.0, x / width(), 1.0);
+    emit SeekRequested(static_cast<qint64>(ratio * peaks_->get_frame_count()));
+}
@@ -0,0 +1,48 @@
+﻿#pragma once
+
+#include <QWidget>
+#include <QPixmap>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include <memory>
+#include "peakfile.h"
+
+// 整个音频文件的波形概览，带播放指示线
+// 峰值摘要在后台线程中读取缓存或计算，点击或拖动可跳转播放位置
+class WaveformOverview : public QWidget
+{
+    Q_OBJECT
+
+public:
+    WaveformOverview(QWidget *parent);
+    ~WaveformOverview();
+
+    void LoadFile(const QString &wav_path);
+    void ClearDisplay();
+    void SetPlayhead(qint64 frame);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+private:
+    void RenderWaveform();
+    void EmitSeek(double x);
+
+private:
+    QFutureWatcher<std::shared_ptr<PeakFile>> *watcher_;
+    std::shared_ptr<PeakFile> peaks_;
+    QPixmap waveform_pixmap_;
+    qint64 playhead_frame_{ 0 };
+    bool is_loading_{ false };
+    // 拖动时限制跳转频率
+    QElapsedTimer seek_timer_;
+
+    static constexpr int kSeekInterval{ 40 };   // 毫秒
+
+signals:
+    void SeekRequested(qint64 frame);
+};
@@ -0,0 +1,111 @@
+﻿#include "wavfile.h"
+#include <QtEndian>
+#include <cstring>
+
+QAudioFormat WavInfo::ToAudioFormat() const
+{
+    QAudioFormat format;
+    format.setChannelCount(channels);
+    format.setSampleRate(sample_rate);
+    if (format_tag == kFormatFloat) {
+        format.setSampleFormat(QAudioFormat::Float);
+    } else if (bits_per_sample == 8) {
+        format.setSampleFormat(QAudioFormat::UInt8);
+    } else if (bits_per_sample == 16) {
+        format.setSampleFormat(QAudioFormat::Int16);
+    } else {
+        format.setSampleFormat(QAudioFormat::Int32);
+    }
+    return format;
+}
+
+bool ParseWavHeader(const uchar *data, qint64 size, WavInfo &info)
+{
+    info = WavInfo();
+    if (!data || size < 12) {
+        return false;
+    }
+    const bool is_riff = memcmp(data, "RIFF", 4) == 0;
+    info.is_rf64 = memcmp(data, "RF64", 4) == 0;
+    if ((!is_riff && !info.is_rf64) || memcmp(data + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+    bool has_fmt{ false };
+    bool has_data{ false };
+    qint64 ds64_data_size{ -1 };
+    qint64 pos{ 12 };
+    // 逐块遍历，块大小为奇数时有一个填充字节
+    while (pos + 8 <= size) {
+        const uchar *chunk = data + pos;
+        const qint64 chunk_size = qFromLittleEndian<quint32>(chunk + 4);
+        const uchar *body = chunk + 8;
+        const qint64 available = size - pos - 8;
+        if (memcmp(chunk, "ds64", 4) == 0) {
+            // RF64的64位大小：RIFF大小、data大小、样本数
+            if (chunk_size >= 24 && available >= 24) {
+                ds64_data_size = static_cast<qint64>(qFromLittleEndian<quint64>(body + 8));
+            }
+        } else if (memcmp(chunk, "fmt ", 4) == 0) {
+            if (chunk_size < 16 || available < 16) {
+                return false;
+            }
+            info.format_tag = qFromLittleEndian<quint16>(body);
+            info.channels = qFromLittleEndian<quint16>(body + 2);
+            info.sample_rate = static_cast<int>(qFromLittleEndian<quint32>(body + 4));
+            info.block_align = qFromLittleEndian<quint16>(body + 12);
+            info.bits_per_sample = qFromLittleEndian<quint16>(body + 14);
+            info.valid_bits = info.bits_per_sample;
+            // WAVE_FORMAT_EXTENSIBLE：cbSize(2) 有效位数(2) 声道掩码(4) 子格式GUID(16)，GUID前两个字节即格式编号
+            if (info.format_tag == WavInfo::kFormatExtensible) {
+                if (chunk_size < 40 || available < 40) {
+                    return false;
+                }
+                const int valid_bits = qFromLittleEndian<quint16>(body + 18);
+                info.valid_bits = valid_bits > 0 ? valid_bits : info.bits_per_sample;
+                info.format_tag = qFromLittleEndian<quint16>(body + 24);
+            }
+            has_fmt = true;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            info.data_offset = pos + 8;
+            qint64 data_size = chunk_size;
+            if (chunk_size == 0xFFFFFFFFLL) {
+                // RF64中data块大小来自ds64块，缺失时取到文件末尾
+                data_size = ds64_data_size >= 0 ? ds64_data_size : available;
+            }
+            // 录音中断时头部可能未回填，以实际文件长度为准
+            if (data_size == 0 || data_size > available) {
+                data_size = available;
+            }
+            info.data_size = data_size;
+            has_data = true;
+            if (has_fmt) {
+                break;
+            }
+            pos += 8 + data_size + (data_size & 1);
+            continue;
+        }
+        pos += 8 + chunk_size + (chunk_size & 1);
+    }
+    if (!has_fmt || !has_data || info.channels <= 0 || info.sample_rate <= 0) {
+        return false;
+    }
+    // 检查支持的样本格式
+    const int bits = info.bits_per_sample;
+    if (info.format_tag == WavInfo::kFormatPcm) {
+        if (bits != 8 && bits != 16 && bits != 24 && bits != 32) {
+            return false;
+        }
+    } else if (info.format_tag == WavInfo::kFormatFloat) {
+        if (bits != 32 && bits != 64) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+    if (info.block_align != info.channels * bits / 8) {
+        info.block_align = info.channels * bits / 8;
+    }
+    // data块长度截断到整帧
+    info.data_size -= info.data_size % info.block_align;
+    return info.data_size > 0;
+}
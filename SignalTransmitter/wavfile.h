@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include <QtGlobal>
+#include <QAudioFormat>
+#include <QtEndian>
+#include <cstring>
+
+// WAV文件格式信息
+struct WavInfo {
+    enum FormatTag_t {
+        kFormatPcm = 0x0001,
+        kFormatFloat = 0x0003,
+        kFormatExtensible = 0xFFFE
+    };
+
+    int format_tag{ 0 };            // 实际编码（WAVE_FORMAT_EXTENSIBLE已解析为子格式）
+    int channels{ 0 };
+    int sample_rate{ 0 };
+    int bits_per_sample{ 0 };       // 容器位数
+    int valid_bits{ 0 };            // 有效位数
+    int block_align{ 0 };
+    qint64 data_offset{ 0 };        // data块内容在文件中的偏移
+    qint64 data_size{ 0 };
+    bool is_rf64{ false };
+
+    qint64 get_frame_count() const { return block_align > 0 ? data_size / block_align : 0; }
+    // Qt播放使用的格式：24位PCM以Int32输出，64位浮点以Float输出
+    QAudioFormat ToAudioFormat() const;
+    // 文件中的样本是否需要转换后才能播放
+    bool NeedsConversion() const { return bits_per_sample == 24 || (format_tag == kFormatFloat && bits_per_sample == 64); }
+};
+
+// 遍历RIFF/RF64块解析WAV头部，支持LIST/fact等附加块、WAVE_FORMAT_EXTENSIBLE、8/16/24/32位PCM和32/64位浮点
+bool ParseWavHeader(const uchar *data, qint64 size, WavInfo &info);
+
+// 按WAV文件的样本格式读取一个样本并归一化到[-1, 1]
+inline float LoadNormalizedSample(const uchar *p, const WavInfo &info)
+{
+    if (info.format_tag == WavInfo::kFormatFloat) {
+        if (info.bits_per_sample == 64) {
+            double v;
+            memcpy(&v, p, sizeof(v));
+            return static_cast<float>(v);
+        }
+        float v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    switch (info.bits_per_sample) {
+    case 8: return (static_cast<int>(*p) - 128) / 128.0f;
+    case 16: return qFromLittleEndian<qint16>(p) / 32768.0f;
+    case 24: return (static_cast<qint32>((quint32(p[0]) << 8) | (quint32(p[1]) << 16) | (quint32(p[2]) << 24)) >> 8) / 8388608.0f;
+    default: return static_cast<float>(qFromLittleEndian<qint32>(p) / 2147483648.0);
+    }
+}
@@ -0,0 +1,161 @@
+﻿#include "wavstreamwriter.h"
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+// 按小端序追加字段
+void AppendTag(QByteArray &out, const char *tag)
+{
+    out.append(tag, 4);
+}
+
+void AppendUInt16(QByteArray &out, quint16 value)
+{
+    const auto le = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&le), sizeof(le));
+}
+
+void AppendUInt32(QByteArray &out, quint32 value)
+{
+    const auto le = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&le), sizeof(le));
+}
+
+void AppendUInt64(QByteArray &out, quint64 value)
+{
+    const auto le = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&le), sizeof(le));
+}
+}
+
+WavStreamWriter::WavStreamWriter()
+{}
+
+WavStreamWriter::~WavStreamWriter()
+{
+    Close();
+}
+
+bool WavStreamWriter::Open(const QString &file_path, int sample_rate, int channels, int bits_per_sample, bool is_float)
+{
+    Close();
+    if (sample_rate <= 0 || channels <= 0 || bits_per_sample <= 0 || bits_per_sample % 8 != 0) {
+        return false;
+    }
+    file_.setFileName(file_path);
+    // 自行缓冲，关闭QFile的内部缓冲避免二次拷贝
+    if (!file_.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        return false;
+    }
+    if (!buffer_) {
+        buffer_.reset(static_cast<char *>(::operator new[](kBufferSize, std::align_val_t(kBufferAlignment))));
+    }
+    sample_rate_ = sample_rate;
+    channels_ = channels;
+    bits_per_sample_ = bits_per_sample;
+    is_float_ = is_float;
+    buffered_bytes_ = 0;
+    data_bytes_ = 0;
+    // 先写入大小为0的头部，之后由PatchHeader回填
+    if (!PatchHeader()) {
+        file_.close();
+        return false;
+    }
+    return true;
+}
+
+bool WavStreamWriter::Write(const char *data, qint64 size)
+{
+    if (!file_.isOpen()) {
+        return false;
+    }
+    while (size > 0) {
+        const qint64 n = qMin(size, kBufferSize - buffered_bytes_);
+        memcpy(buffer_.get() + buffered_bytes_, data, n);
+        buffered_bytes_ += n;
+        data_bytes_ += n;
+        data += n;
+        size -= n;
+        // 缓冲区写满后整块写出
+        if (buffered_bytes_ == kBufferSize && !WriteBuffer()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool WavStreamWriter::Flush()
+{
+    if (!file_.isOpen()) {
+        return false;
+    }
+    return WriteBuffer() && PatchHeader();
+}
+
+bool WavStreamWriter::Close()
+{
+    if (!file_.isOpen()) {
+        return true;
+    }
+    bool ok = Flush();
+    // 奇数长度的data块补一个填充字节
+    if (ok && (data_bytes_ & 1)) {
+        ok = file_.write("\0", 1) == 1;
+    }
+    file_.close();
+    return ok;
+}
+
+bool WavStreamWriter::WriteBuffer()
+{
+    if (buffered_bytes_ == 0) {
+        return true;
+    }
+    if (!file_.seek(kHeaderSize + data_bytes_ - buffered_bytes_)
+        || file_.write(buffer_.get(), buffered_bytes_) != buffered_bytes_) {
+        return false;
+    }
+    buffered_bytes_ = 0;
+    return true;
+}
+
+bool WavStreamWriter::PatchHeader()
+{
+    const int channels = channels_;
+    const int bytes_per_sample = bits_per_sample_ / 8;
+    const quint16 block_align = static_cast<quint16>(channels * bytes_per_sample);
+    // 数据对齐到帧，奇数长度的data块需要一个填充字节
+    const qint64 riff_size = kHeaderSize - 8 + data_bytes_ + (data_bytes_ & 1);
+    const bool is_rf64 = riff_size > 0xFFFFFFFFLL;
+
+    QByteArray header;
+    header.reserve(kHeaderSize);
+    AppendTag(header, is_rf64 ? "RF64" : "RIFF");
+    AppendUInt32(header, is_rf64 ? 0xFFFFFFFFu : static_cast<quint32>(riff_size));
+    AppendTag(header, "WAVE");
+    // 预留块：普通WAV中为JUNK，RF64中为ds64
+    AppendTag(header, is_rf64 ? "ds64" : "JUNK");
+    AppendUInt32(header, 28);
+    AppendUInt64(header, is_rf64 ? riff_size : 0);
+    AppendUInt64(header, is_rf64 ? data_bytes_ : 0);
+    AppendUInt64(header, is_rf64 && block_align ? data_bytes_ / block_align : 0);
+    AppendUInt32(header, 0);
+    // fmt块
+    AppendTag(header, "fmt ");
+    AppendUInt32(header, 16);
+    AppendUInt16(header, is_float_ ? 3 : 1); // 1: PCM 3: IEEE float
+    AppendUInt16(header, static_cast<quint16>(channels));
+    AppendUInt32(header, static_cast<quint32>(sample_rate_));
+    AppendUInt32(header, static_cast<quint32>(sample_rate_ * block_align));
+    AppendUInt16(header, block_align);
+    AppendUInt16(header, static_cast<quint16>(bytes_per_sample * 8));
+    // data块
+    AppendTag(header, "data");
+    AppendUInt32(header, is_rf64 ? 0xFFFFFFFFu : static_cast<quint32>(data_bytes_));
+
+    const qint64 end = kHeaderSize + data_bytes_ - buffered_bytes_;
+    if (!file_.seek(0) || file_.write(header) != header.size() || !file_.seek(end)) {
+        return false;
+    }
+    return true;
+}
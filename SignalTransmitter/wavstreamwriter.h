@@ -0,0 +1,54 @@
+﻿#pragma once
+
+#include <QFile>
+#include <memory>
+#include <new>
+
+// 流式WAV写入器
+// 录音数据先进入对齐的大块缓冲区，写满后整块写入文件；Flush时回填RIFF/data大小，
+// 保证任意时刻文件都是可读的WAV。文件头预留JUNK块，数据超过4GB时原地改写为RF64的ds64块
+// 只依赖QtCore，格式以普通数值给出，命令行工具不需要QtMultimedia
+class WavStreamWriter
+{
+public:
+    WavStreamWriter();
+    ~WavStreamWriter();
+
+    bool Open(const QString &file_path, int sample_rate, int channels, int bits_per_sample, bool is_float);
+    // 按QAudioFormat打开；写成模板使本头文件不依赖QtMultimedia
+    template <typename AudioFormat>
+    bool Open(const QString &file_path, const AudioFormat &format) {
+        return Open(file_path, format.sampleRate(), format.channelCount(), format.bytesPerSample() * 8,
+                    format.sampleFormat() == AudioFormat::Float);
+    }
+    bool Write(const char *data, qint64 size);
+    // 写出缓冲区并更新头部大小字段
+    bool Flush();
+    bool Close();
+    bool IsOpen() const { return file_.isOpen(); }
+
+    QString get_file_path() const { return file_.fileName(); }
+    qint64 get_data_bytes() const { return data_bytes_; }
+
+    static constexpr qint64 kBufferSize{ 1 << 20 };         // 写缓冲区大小（1MB）
+    static constexpr size_t kBufferAlignment{ 4096 };       // 缓冲区内存对齐
+    static constexpr qint64 kHeaderSize{ 80 };              // RIFF(12) + JUNK/ds64(36) + fmt(24) + data(8)
+
+private:
+    bool WriteBuffer();
+    bool PatchHeader();
+
+private:
+    struct AlignedDeleter {
+        void operator()(char *p) const { ::operator delete[](p, std::align_val_t(kBufferAlignment)); }
+    };
+
+    QFile file_;
+    int sample_rate_{ 0 };
+    int channels_{ 0 };
+    int bits_per_sample_{ 0 };
+    bool is_float_{ false };
+    std::unique_ptr<char[], AlignedDeleter> buffer_;
+    qint64 buffered_bytes_{ 0 };
+    qint64 data_bytes_{ 0 };
+};